@@ -0,0 +1,99 @@
+// Prints the content of an instruction trace file, as written by the
+// 'debug instruction_trace save <filename>' command. One line per
+// instruction: time (in seconds), address, disassembled instruction and the
+// registers after executing that instruction.
+//
+// compile with (build-info.hh is generated by the openMSX build):
+//   g++ -std=c++17 -Wall -O2 -I ../src -I ../src/cpu -I ../src/debugger
+//       -I ../src/utils -I ../derived/<flavour>/config cputrace-reader.cc
+//       ../src/cpu/Dasm.cc ../src/debugger/DasmTables.cc -o cputrace-reader
+//
+// usage:
+//   cputrace-reader [-n <count>] <filename>
+// With '-n' only the last <count> instructions are printed.
+
+#include "InstructionTrace.hh"
+#include "Dasm.hh"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static void usage()
+{
+	fprintf(stderr, "Usage: cputrace-reader [-n <count>] <filename>\n");
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t last = uint64_t(-1);
+	const char* filename = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-n") == 0) {
+			if (++i == argc) usage();
+			last = strtoull(argv[i], nullptr, 10);
+		} else if (!filename) {
+			filename = argv[i];
+		} else {
+			usage();
+		}
+	}
+	if (!filename) usage();
+
+	FILE* file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Couldn't open %s\n", filename);
+		return 1;
+	}
+	InstructionTrace::Header header;
+	if ((fread(&header, sizeof(header), 1, file) != 1) ||
+	    (memcmp(header.magic, InstructionTrace::MAGIC, sizeof(header.magic)) != 0)) {
+		fprintf(stderr, "Not an openMSX instruction trace file\n");
+		return 1;
+	}
+	if ((header.version != InstructionTrace::VERSION) ||
+	    (header.recordSize != sizeof(InstructionTrace::Record))) {
+		fprintf(stderr, "Unsupported instruction trace version: %u\n",
+		        unsigned(header.version));
+		return 1;
+	}
+	uint64_t num = header.numRecords;
+	uint64_t total = header.totalRecords;
+	double ticksPerSecond = double(uint64_t(header.ticksPerSecond));
+	printf("# %" PRIu64 " instructions (of %" PRIu64 " recorded)\n", num, total);
+
+	uint64_t skip = (last < num) ? (num - last) : 0;
+	if (skip && fseek(file, long(skip * sizeof(InstructionTrace::Record)), SEEK_CUR)) {
+		fprintf(stderr, "Error while reading %s\n", filename);
+		return 1;
+	}
+	std::vector<InstructionTrace::Record> records(4096);
+	uint64_t remaining = num - skip;
+	while (remaining) {
+		size_t n = (remaining < records.size()) ? size_t(remaining) : records.size();
+		if (fread(records.data(), sizeof(InstructionTrace::Record), n, file) != n) {
+			fprintf(stderr, "Error while reading %s (file truncated?)\n", filename);
+			return 1;
+		}
+		for (size_t i = 0; i < n; ++i) {
+			const auto& r = records[i];
+			std::string dasmOutput;
+			dasm(r.opcode, r.pc, dasmOutput);
+			printf("%.9f %04X : %s AF=%04X BC=%04X DE=%04X HL=%04X "
+			       "IX=%04X IY=%04X SP=%04X\n",
+			       double(uint64_t(r.time)) / ticksPerSecond,
+			       unsigned(r.pc), dasmOutput.c_str(),
+			       unsigned(r.af), unsigned(r.bc), unsigned(r.de),
+			       unsigned(r.hl), unsigned(r.ix), unsigned(r.iy),
+			       unsigned(r.sp));
+		}
+		remaining -= n;
+	}
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Measures the emulation speed of openMSX: runs the 'benchmark' script command
+# (see share/scripts/_benchmark.tcl) on a number of machines, without any
+# video or sound output, and prints a summary.
+#
+# openMSX is started in control mode (so it never opens a window) with a
+# temporary settings file that selects the 'null' sound driver. The user's
+# own settings are not used and not modified. The machines must be available
+# to the executable, e.g. install openMSX first (this also installs the C-BIOS
+# machines) or point OPENMSX_SYSTEM_DATA to a directory containing them.
+
+from os import close, remove
+from subprocess import DEVNULL, PIPE, Popen
+from tempfile import mkstemp
+from threading import Timer
+import re, sys
+
+defaultMachines = ('C-BIOS_MSX1', 'C-BIOS_MSX2', 'C-BIOS_MSX2+')
+
+settingsXML = '''<!DOCTYPE settings SYSTEM 'settings.dtd'>
+<settings>
+  <settings>
+    <setting id="sound_driver">null</setting>
+    <setting id="save_settings_on_exit">false</setting>
+  </settings>
+</settings>
+'''
+
+_reResult = re.compile(
+	r'^(\w+): ([0-9.]+) emulated seconds in ([0-9.]+) host seconds'
+	)
+
+def runMachine(executable, settingsFile, machine, seconds):
+	'''Runs the benchmark on the given machine.
+	Returns a list of (workload, emulated seconds, host seconds) tuples,
+	or None if openMSX failed.
+	'''
+	proc = Popen(
+		[executable, '-setting', settingsFile, '-machine', machine,
+		 '-control', 'stdio'],
+		stdin=PIPE, stdout=DEVNULL, stderr=PIPE, universal_newlines=True
+		)
+	# Keep stdin (the control connection) open until openMSX exits.
+	try:
+		proc.stdin.write(
+			'<openmsx-control>\n'
+			'<command>benchmark -exit -seconds %s</command>\n' % seconds
+			)
+		proc.stdin.flush()
+	except BrokenPipeError:
+		pass # openMSX failed to start, reported below
+	# Don't hang forever when the benchmark doesn't finish (e.g. because the
+	# machine doesn't boot).
+	timer = Timer(600, proc.kill)
+	timer.start()
+	results = []
+	try:
+		for line in proc.stderr:
+			sys.stdout.write(line)
+			match = _reResult.match(line)
+			if match is not None:
+				workload, emu, host = match.groups()
+				results.append((workload, float(emu), float(host)))
+	finally:
+		timer.cancel()
+	status = proc.wait()
+	try:
+		proc.stdin.close()
+	except BrokenPipeError:
+		pass
+	return results if status == 0 else None
+
+def main(executable, seconds, machines):
+	handle, settingsFile = mkstemp(suffix='.xml', prefix='openmsx-benchmark-')
+	close(handle)
+	try:
+		with open(settingsFile, 'w') as out:
+			out.write(settingsXML)
+		summary = []
+		failed = []
+		for machine in machines:
+			print('%s:' % machine)
+			results = runMachine(executable, settingsFile, machine, seconds)
+			if results is None:
+				failed.append(machine)
+			else:
+				summary += [(machine, ) + result for result in results]
+			print()
+	finally:
+		remove(settingsFile)
+
+	print('Summary (emulated seconds per host second):')
+	for machine, workload, emu, host in summary:
+		print('  %-24s %-6s %8.2f' % (machine, workload, emu / host))
+	if failed:
+		print('Failed: %s' % ' '.join(failed), file=sys.stderr)
+		sys.exit(1)
+
+if __name__ == '__main__':
+	if len(sys.argv) >= 2:
+		args = sys.argv[2 : ]
+		seconds = '10'
+		if len(args) >= 2 and args[0] == '--seconds':
+			seconds = args[1]
+			args = args[2 : ]
+		main(sys.argv[1], seconds, args or defaultMachines)
+	else:
+		print(
+			'Usage: python3 benchmark.py EXECUTABLE [--seconds N] [MACHINE ...]',
+			file=sys.stderr
+			)
+		sys.exit(2)
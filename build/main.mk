@@ -53,7 +53,7 @@ endif
 # TODO: "dist" and "createsubs" are missing
 # TODO: more missing?
 # Logical targets which require dependency files.
-DEPEND_TARGETS:=all default install run bindist
+DEPEND_TARGETS:=all default install run benchmark bindist
 # Logical targets which do not require dependency files.
 NODEPEND_TARGETS:=clean config probe 3rdparty run-3rdparty staticbindist
 # Mark all logical targets as such.
@@ -543,6 +543,11 @@ run: all
 	$(SUM) "Running $(notdir $(BINARY_FULL))..."
 	$(CMD)$(BINARY_FULL)
 
+# Measure emulation speed, pass BENCHMARK_MACHINES to select the machines.
+benchmark: all
+	$(SUM) "Benchmarking $(notdir $(BINARY_FULL))..."
+	$(CMD)$(PYTHON) build/benchmark.py $(BINARY_FULL) $(BENCHMARK_MACHINES)
+
 
 # Installation and Binary Packaging
 # =================================
@@ -0,0 +1,376 @@
+namespace eval benchmark {
+
+set_help_text benchmark \
+{Measure the emulation speed of the current machine.
+
+Usage:
+  benchmark [-exit] [-seconds <seconds>] [<workload> ...]
+
+Each workload replaces the running MSX program by a small test program and
+runs it unthrottled for <seconds> (default 10) of emulated time. Before each
+workload the machine is reset. Available workloads:
+  cpu    a mix of common Z80 instructions, running from RAM
+  vdp    a continuous stream of VDP block commands (needs an MSX2 or higher)
+  fm     play notes on all channels of the (internal) MSX-MUSIC
+  disk   read sectors via the disk ROM (needs a disk drive, a 'ramdsk' is
+         inserted in drive A)
+Without arguments all workloads supported by the current machine are run.
+
+For each workload this reports the number of emulated seconds per host second
+and a breakdown of the host time per subsystem (as measured by 'debug
+scheduler_stats'). The remaining time is mostly spent in the CPU emulation
+(including I/O done directly by the CPU).
+
+For the most stable results disable rendering and sound, see build/benchmark.py
+(also available as 'make benchmark') for a way to run the benchmark without
+any video or sound output on a set of machines. With '-exit' the results are
+printed on stderr and openMSX quits after the last workload.
+
+Note: afterwards the MSX is not in a usable state anymore, reset it.
+}
+
+set_help_text cpu_benchmark \
+{Measure the speed of the CPU emulation.
+
+Usage:
+  cpu_benchmark [-exit] [<seconds>]
+
+Shortcut for 'benchmark [-exit] -seconds <seconds> cpu', see 'help benchmark'.
+}
+
+# The test programs are placed at 0xC000 (page 3 is RAM on every MSX).
+variable start_address 0xC000
+variable programs [dict create]
+
+#   C000  F3        di
+#   C001  31 00 F0  ld   sp,#F000
+#   C004  21 00 C1  ld   hl,#C100   ; outer
+#   C007  06 00     ld   b,0
+#   C009  7E        ld   a,(hl)     ; loop
+#   C00A  86        add  a,(hl)
+#   C00B  77        ld   (hl),a
+#   C00C  23        inc  hl
+#   C00D  E5        push hl
+#   C00E  DD E1     pop  ix
+#   C010  DD 7E 01  ld   a,(ix+1)
+#   C013  CB 27     sla  a
+#   C015  ED 44     neg
+#   C017  C5        push bc
+#   C018  CD 20 C0  call sub
+#   C01B  C1        pop  bc
+#   C01C  10 EB     djnz loop
+#   C01E  18 E4     jr   outer
+#   C020  AF        xor  a          ; sub
+#   C021  C9        ret
+dict set programs cpu {
+	0xF3 0x31 0x00 0xF0 0x21 0x00 0xC1 0x06 0x00 0x7E 0x86 0x77 0x23 0xE5
+	0xDD 0xE1 0xDD 0x7E 0x01 0xCB 0x27 0xED 0x44 0xC5 0xCD 0x20 0xC0 0xC1
+	0x10 0xEB 0x18 0xE4 0xAF 0xC9
+}
+
+# Switches to screen 5 and then repeatedly executes a LMMV command (64x64
+# pixels) with a different color and destination each time.
+#   C000  F3        di
+#   C001  31 00 F0  ld   sp,#F000
+#   C004  21 37 C0  ld   hl,init
+#   C007  06 08     ld   b,8
+#   C009  0E 99     ld   c,#99
+#   C00B  ED B3     otir
+#   C00D  3E 02     ld   a,2        ; loop
+#   C00F  D3 99     out  (#99),a
+#   C011  3E 8F     ld   a,#8F
+#   C013  D3 99     out  (#99),a    ; R#15 = 2
+#   C015  DB 99     in   a,(#99)    ; wait
+#   C017  0F        rrca
+#   C018  38 FB     jr   c,wait     ; wait till CE=0
+#   C01A  3E 20     ld   a,32
+#   C01C  D3 99     out  (#99),a
+#   C01E  3E 91     ld   a,#91
+#   C020  D3 99     out  (#99),a    ; R#17 = 32, auto increment
+#   C022  21 3F C0  ld   hl,cmd
+#   C025  01 9B 0F  ld   bc,#0F9B
+#   C028  ED B3     otir            ; R#32-R#46
+#   C02A  21 4B C0  ld   hl,cmd+12
+#   C02D  34        inc  (hl)       ; next color
+#   C02E  21 43 C0  ld   hl,cmd+4
+#   C031  7E        ld   a,(hl)
+#   C032  C6 05     add  a,5
+#   C034  77        ld   (hl),a     ; next destination
+#   C035  18 D6     jr   loop
+#   C037  init: R#0=#06, R#1=#40, R#8=#0A, R#9=#00
+#   C03F  cmd:  SX SY DX DY NX=64 NY=64 CLR ARG CMD=LMMV
+dict set programs vdp {
+	0xF3 0x31 0x00 0xF0 0x21 0x37 0xC0 0x06 0x08 0x0E 0x99 0xED 0xB3 0x3E
+	0x02 0xD3 0x99 0x3E 0x8F 0xD3 0x99 0xDB 0x99 0x0F 0x38 0xFB 0x3E 0x20
+	0xD3 0x99 0x3E 0x91 0xD3 0x99 0x21 0x3F 0xC0 0x01 0x9B 0x0F 0xED 0xB3
+	0x21 0x4B 0xC0 0x34 0x21 0x43 0xC0 0x7E 0xC6 0x05 0x77 0x18 0xD6
+	0x06 0x80 0x40 0x81 0x0A 0x88 0x00 0x89
+	0x00 0x00 0x00 0x00 0x00 0x00 0x00 0x00 0x40 0x00 0x40 0x00 0x00 0x00
+	0x80
+}
+
+# Starts a note (each time with a different instrument and frequency) on all
+# 9 channels, waits about 0.1s, releases all notes and repeats.
+#   C000  F3        di
+#   C001  31 00 F0  ld   sp,#F000
+#   C004  16 00     ld   d,0
+#   C006  0E 00     ld   c,0        ; loop
+#   C008  79        ld   a,c        ; channel
+#   C009  C6 30     add  a,#30
+#   C00B  D3 7C     out  (#7C),a
+#   C00D  79        ld   a,c
+#   C00E  82        add  a,d
+#   C00F  E6 0F     and  #0F
+#   C011  07 07 07 07  rlca (4x)
+#   C015  D3 7D     out  (#7D),a    ; instrument, max volume
+#   C017  79        ld   a,c
+#   C018  C6 10     add  a,#10
+#   C01A  D3 7C     out  (#7C),a
+#   C01C  7A        ld   a,d
+#   C01D  81        add  a,c
+#   C01E  87        add  a,a
+#   C01F  D3 7D     out  (#7D),a    ; frequency (low bits)
+#   C021  79        ld   a,c
+#   C022  C6 20     add  a,#20
+#   C024  D3 7C     out  (#7C),a
+#   C026  3E 19     ld   a,#19
+#   C028  D3 7D     out  (#7D),a    ; key on, block 4
+#   C02A  0C        inc  c
+#   C02B  79        ld   a,c
+#   C02C  FE 09     cp   9
+#   C02E  20 D8     jr   nz,channel
+#   C030  01 00 40  ld   bc,#4000
+#   C033  0B        dec  bc         ; delay
+#   C034  78        ld   a,b
+#   C035  B1        or   c
+#   C036  20 FB     jr   nz,delay
+#   C038  0E 00     ld   c,0
+#   C03A  79        ld   a,c        ; off
+#   C03B  C6 20     add  a,#20
+#   C03D  D3 7C     out  (#7C),a
+#   C03F  AF        xor  a
+#   C040  D3 7D     out  (#7D),a    ; key off
+#   C042  0C        inc  c
+#   C043  79        ld   a,c
+#   C044  FE 09     cp   9
+#   C046  20 F2     jr   nz,off
+#   C048  14        inc  d
+#   C049  18 BB     jr   loop
+dict set programs fm {
+	0xF3 0x31 0x00 0xF0 0x16 0x00 0x0E 0x00 0x79 0xC6 0x30 0xD3 0x7C 0x79
+	0x82 0xE6 0x0F 0x07 0x07 0x07 0x07 0xD3 0x7D 0x79 0xC6 0x10 0xD3 0x7C
+	0x7A 0x81 0x87 0xD3 0x7D 0x79 0xC6 0x20 0xD3 0x7C 0x3E 0x19 0xD3 0x7D
+	0x0C 0x79 0xFE 0x09 0x20 0xD8 0x01 0x00 0x40 0x0B 0x78 0xB1 0x20 0xFB
+	0x0E 0x00 0x79 0xC6 0x20 0xD3 0x7C 0xAF 0xD3 0x7D 0x0C 0x79 0xFE 0x09
+	0x20 0xF2 0x14 0x18 0xBB
+}
+
+# Reads 9 sectors at a time from drive A: via PHYDIO, cycling through the
+# first 1280 sectors of the disk. Interrupts stay enabled, the disk ROM
+# needs them (e.g. to turn off the motor).
+#   C000  31 00 F0     ld   sp,#F000
+#   C003  FB           ei
+#   C004  AF           xor  a          ; loop: drive A:, read
+#   C005  06 09        ld   b,9
+#   C007  0E F9        ld   c,#F9
+#   C009  ED 5B 27 C0  ld   de,(sector)
+#   C00D  21 00 80     ld   hl,#8000
+#   C010  CD 44 01     call #0144      ; PHYDIO
+#   C013  2A 27 C0     ld   hl,(sector)
+#   C016  11 09 00     ld   de,9
+#   C019  19           add  hl,de
+#   C01A  7C           ld   a,h
+#   C01B  FE 05        cp   5
+#   C01D  38 03        jr   c,store
+#   C01F  21 00 00     ld   hl,0
+#   C022  22 27 C0     ld   (sector),hl ; store
+#   C025  18 DD        jr   loop
+#   C027  00 00        sector: dw 0
+dict set programs disk {
+	0x31 0x00 0xF0 0xFB 0xAF 0x06 0x09 0x0E 0xF9 0xED 0x5B 0x27 0xC0 0x21
+	0x00 0x80 0xCD 0x44 0x01 0x2A 0x27 0xC0 0x11 0x09 0x00 0x19 0x7C 0xFE
+	0x05 0x38 0x03 0x21 0x00 0x00 0x22 0x27 0xC0 0x18 0xDD 0x00 0x00
+}
+
+# Emulated time to let the machine boot after a reset (so that e.g. RAM is
+# selected in page 3 and the disk ROM is initialized).
+variable boot_time 5
+
+variable queue
+variable seconds
+variable exit
+variable channel
+variable old_throttle
+variable start_host
+variable start_emu
+
+proc is_supported {workload} {
+	switch -- $workload {
+		cpu {
+			return true
+		}
+		vdp {
+			return [expr {[debug size VRAM] >= 0x10000}]
+		}
+		fm {
+			foreach device [machine_info sounddevice] {
+				if {[machine_info sounddevice $device] eq "MSX-MUSIC"} {
+					return true
+				}
+			}
+			return false
+		}
+		disk {
+			return [expr {[info commands diska] ne ""}]
+		}
+	}
+}
+
+proc benchmark {args} {
+	variable programs
+	variable queue
+	variable seconds 10
+	variable exit false
+	variable channel
+	variable old_throttle
+
+	set workloads [list]
+	while {[llength $args] > 0} {
+		set args [lassign $args arg]
+		if {$arg eq "-exit"} {
+			set exit true
+		} elseif {$arg eq "-seconds"} {
+			set args [lassign $args seconds]
+			if {![string is double -strict $seconds] || $seconds <= 0} {
+				error "Invalid number of seconds: $seconds"
+			}
+		} elseif {[dict exists $programs $arg]} {
+			lappend workloads $arg
+		} else {
+			error "Unknown workload: $arg, should be one of: [dict keys $programs]"
+		}
+	}
+	if {[llength $workloads] == 0} {
+		foreach workload [dict keys $programs] {
+			if {[is_supported $workload]} {
+				lappend workloads $workload
+			}
+		}
+	}
+
+	set queue $workloads
+	set channel [expr {$exit ? "stderr" : "stdout"}]
+	set old_throttle $::throttle
+	set ::throttle off
+	puts $channel "Benchmarking [machine_info config_name]: $workloads"
+	next_workload
+	return ""
+}
+
+proc cpu_benchmark {args} {
+	set options [list]
+	foreach arg $args {
+		if {$arg eq "-exit"} {
+			lappend options -exit
+		} else {
+			lappend options -seconds $arg
+		}
+	}
+	benchmark {*}$options cpu
+}
+
+proc next_workload {} {
+	variable queue
+	variable boot_time
+	variable exit
+	variable old_throttle
+
+	if {[llength $queue] == 0} {
+		set ::throttle $old_throttle
+		if {$exit} {
+			exit
+		}
+		return
+	}
+	set queue [lassign $queue workload]
+	if {$workload eq "disk"} {
+		diska ramdsk
+	}
+	reset
+	after time $boot_time [namespace code [list start_workload $workload]]
+}
+
+proc start_workload {workload} {
+	variable programs
+	variable start_address
+	variable seconds
+	variable channel
+	variable start_host
+	variable start_emu
+
+	if {[catch {
+		if {$workload eq "disk" && [peek 0xFFA7] == 0xC9} {
+			error "no disk ROM found (H.PHYD hook is not installed)"
+		}
+		set addr $start_address
+		foreach byte [dict get $programs $workload] {
+			poke $addr $byte
+			if {[peek $addr] != $byte} {
+				error "no RAM at address [format 0x%04X $addr]"
+			}
+			incr addr
+		}
+	} message]} {
+		puts $channel "$workload: skipped, $message"
+		next_workload
+		return
+	}
+	reg PC $start_address
+
+	debug scheduler_stats reset
+	debug scheduler_stats start
+	set start_host [clock microseconds]
+	set start_emu [machine_info time]
+	after time $seconds [namespace code [list stop_workload $workload]]
+}
+
+proc stop_workload {workload} {
+	variable channel
+	variable start_host
+	variable start_emu
+
+	set host [expr {([clock microseconds] - $start_host) / 1e6}]
+	set emu [expr {[machine_info time] - $start_emu}]
+	debug scheduler_stats stop
+	if {$workload eq "disk"} {
+		diska eject
+	}
+
+	set cpu [get_active_cpu]
+	set mhz [expr {[machine_info ${cpu}_freq] * $emu / $host / 1e6}]
+	puts $channel [format "%s: %.2f emulated seconds in %.3f host seconds: %.2f times real speed (%s at %.1f MHz)" \
+		$workload $emu $host [expr {$emu / $host}] $cpu $mhz]
+
+	# Schedulable types that took at least 0.1% of the time, the rest is
+	# mostly CPU emulation.
+	set rest $host
+	foreach entry [debug scheduler_stats] {
+		lassign $entry name count time
+		set rest [expr {$rest - $time}]
+		if {$time >= 0.001 * $host} {
+			puts $channel [format "  %5.1f%%  %8.3fs  %10d  %s" \
+				[expr {100 * $time / $host}] $time $count $name]
+		}
+	}
+	puts $channel [format "  %5.1f%%  %8.3fs  %10s  %s" \
+		[expr {100 * $rest / $host}] $rest "" "(CPU emulation and other)"]
+
+	next_workload
+}
+
+namespace export benchmark
+namespace export cpu_benchmark
+
+} ;# namespace benchmark
+
+namespace import benchmark::*
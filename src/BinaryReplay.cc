@@ -0,0 +1,346 @@
+#include "BinaryReplay.hh"
+#include "DeltaBlock.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "Version.hh"
+#include "lz4.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include "build-info.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+
+namespace openmsx {
+
+constexpr char MAGIC[8] = {'o', 'M', 'S', 'X', 'R', 'P', 'L', 'Y'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+enum ChunkType : uint32_t { SNAPSHOT = 1, EVENT_LOG = 2 };
+
+struct ChunkHeader {
+	uint32_t type;
+	uint32_t eventCount;
+	uint64_t time;       // EmuTime, in ticks since EmuTime::zero()
+	uint64_t rawSize;    // size of the uncompressed payload
+	uint64_t storedSize; // equal to 'rawSize' when not compressed
+	uint32_t checksum;   // crc32 of this header and the stored payload
+	uint32_t padding;
+};
+static_assert(sizeof(ChunkHeader) == 40);
+
+struct Trailer {
+	uint64_t indexOffset;
+	char magic[8];
+};
+static_assert(sizeof(Trailer) == 16);
+
+// Replays can only be loaded by the same build that created them, see
+// comments in BinaryReplay.hh.
+[[nodiscard]] static std::string getCreator()
+{
+	return strCat(Version::full(), ' ', TARGET_PLATFORM, ' ',
+	              8 * sizeof(void*), "-bit");
+}
+
+// Checksum over the chunk header (excluding the checksum field itself) and
+// the stored payload.
+[[nodiscard]] static uint32_t calcChecksum(ChunkHeader header, span<const uint8_t> payload)
+{
+	header.checksum = 0;
+	uLong crc = crc32(0, nullptr, 0);
+	crc = crc32(crc, reinterpret_cast<const Bytef*>(&header), sizeof(header));
+	while (!payload.empty()) {
+		// crc32() takes a 32-bit length
+		auto n = std::min<size_t>(payload.size(), 1 << 30);
+		crc = crc32(crc, payload.data(), uInt(n));
+		payload = payload.subspan(n);
+	}
+	return uint32_t(crc);
+}
+
+
+// class BinaryReplayWriter
+
+BinaryReplayWriter::BinaryReplayWriter(const std::string& filename_)
+	: filename(filename_)
+	, tmpFilename(strCat(filename_, ".tmp"))
+	, file(tmpFilename, File::TRUNCATE)
+{
+	auto creator = getCreator();
+	auto len = uint32_t(creator.size());
+	write(MAGIC, sizeof(MAGIC));
+	write(&FORMAT_VERSION, sizeof(FORMAT_VERSION));
+	write(&BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK));
+	write(&len, sizeof(len));
+	write(creator.data(), len);
+}
+
+BinaryReplayWriter::~BinaryReplayWriter()
+{
+	if (!closed) {
+		file.close();
+		FileOperations::unlink(tmpFilename);
+	}
+}
+
+void BinaryReplayWriter::write(const void* data, size_t size)
+{
+	file.write(data, size);
+	pos += size;
+}
+
+void BinaryReplayWriter::addSnapshot(
+	EmuTime::param time, unsigned eventCount, span<const uint8_t> savestate,
+	span<const std::shared_ptr<DeltaBlock>> deltaBlocks)
+{
+	writeChunk(SNAPSHOT, time, eventCount, savestate, deltaBlocks);
+}
+
+void BinaryReplayWriter::addEventLog(
+	span<const uint8_t> data, span<const std::shared_ptr<DeltaBlock>> deltaBlocks)
+{
+	writeChunk(EVENT_LOG, EmuTime::zero(), 0, data, deltaBlocks);
+}
+
+void BinaryReplayWriter::writeChunk(
+	uint32_t type, EmuTime::param time, unsigned eventCount,
+	span<const uint8_t> data, span<const std::shared_ptr<DeltaBlock>> deltaBlocks)
+{
+	// payload: size of data, data, number of blocks, (size, content) for
+	// each block
+	size_t rawSize = sizeof(uint64_t) + data.size() + sizeof(uint32_t);
+	for (const auto& block : deltaBlocks) {
+		rawSize += sizeof(uint64_t) + block->getSize();
+	}
+	MemBuffer<uint8_t> raw(rawSize);
+	uint8_t* p = raw.data();
+	auto put = [&](const void* src, size_t n) {
+		if (n) memcpy(p, src, n);
+		p += n;
+	};
+	uint64_t dataSize = data.size();
+	put(&dataSize, sizeof(dataSize));
+	put(data.data(), data.size());
+	auto num = uint32_t(deltaBlocks.size());
+	put(&num, sizeof(num));
+	for (const auto& block : deltaBlocks) {
+		uint64_t blockSize = block->getSize();
+		put(&blockSize, sizeof(blockSize));
+		block->apply(p, blockSize);
+		p += blockSize;
+	}
+	assert(p == raw.data() + rawSize);
+
+	span<const uint8_t> stored(raw.data(), rawSize);
+	MemBuffer<uint8_t> compressed;
+	if (rawSize <= size_t(std::numeric_limits<int>::max() / 2)) { // LZ4 uses int sizes
+		compressed.resize(LZ4::compressBound(int(rawSize)));
+		auto len = size_t(LZ4::compress(raw.data(), compressed.data(), int(rawSize)));
+		if (len < rawSize) stored = span<const uint8_t>(compressed.data(), len);
+	}
+
+	ChunkHeader header = {};
+	header.type = type;
+	header.eventCount = eventCount;
+	header.time = (time - EmuTime::zero()).length();
+	header.rawSize = rawSize;
+	header.storedSize = stored.size();
+	header.checksum = calcChecksum(header, stored);
+	offsets.push_back(pos);
+	write(&header, sizeof(header));
+	write(stored.data(), stored.size());
+}
+
+void BinaryReplayWriter::close()
+{
+	Trailer trailer;
+	trailer.indexOffset = pos;
+	memcpy(trailer.magic, MAGIC, sizeof(MAGIC));
+
+	uint64_t num = offsets.size();
+	write(&num, sizeof(num));
+	write(offsets.data(), offsets.size() * sizeof(uint64_t));
+	write(&trailer, sizeof(trailer));
+	file.close();
+	if (FileOperations::rename(tmpFilename, filename) != 0) {
+		throw FileException("Couldn't replace ", filename,
+		                    ", is it still in use?");
+	}
+	closed = true;
+}
+
+
+// class BinaryReplayReader
+
+bool BinaryReplayReader::isBinaryReplay(const std::string& filename)
+{
+	try {
+		File f(filename, "rb");
+		if (f.getSize() < sizeof(MAGIC)) return false;
+		char buf[sizeof(MAGIC)];
+		f.read(buf, sizeof(buf));
+		return memcmp(buf, MAGIC, sizeof(MAGIC)) == 0;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+BinaryReplayReader::BinaryReplayReader(const std::string& filename_)
+	: filename(filename_)
+	, file(filename, "rb")
+	, mmap(file.mmap())
+{
+	auto read32 = [&](size_t offset) {
+		uint32_t result;
+		memcpy(&result, get(offset, sizeof(result)).data(), sizeof(result));
+		return result;
+	};
+	auto read64 = [&](size_t offset) {
+		uint64_t result;
+		memcpy(&result, get(offset, sizeof(result)).data(), sizeof(result));
+		return result;
+	};
+
+	// header
+	if (memcmp(get(0, sizeof(MAGIC)).data(), MAGIC, sizeof(MAGIC)) != 0) {
+		throw MSXException("Not a binary replay file");
+	}
+	if (auto version = read32(8); version != FORMAT_VERSION) {
+		throw MSXException("Unsupported binary replay version: ", version);
+	}
+	if (read32(12) != BYTE_ORDER_MARK) {
+		throw MSXException("Binary replay was created on a different platform");
+	}
+	auto len = read32(16);
+	auto creator = get(20, len);
+	if (std::string_view(reinterpret_cast<const char*>(creator.data()), len) != getCreator()) {
+		throw MSXException(
+			"This binary replay was created by a different openMSX "
+			"version (", std::string_view(reinterpret_cast<const char*>(creator.data()), len),
+			"), it can only be loaded by that same version. Replays "
+			"in XML format don't have this limitation.");
+	}
+
+	// trailer and index
+	if (mmap.size() < sizeof(Trailer)) {
+		throw MSXException("Binary replay is incomplete");
+	}
+	Trailer trailer;
+	memcpy(&trailer, get(mmap.size() - sizeof(Trailer), sizeof(Trailer)).data(), sizeof(Trailer));
+	if (memcmp(trailer.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw MSXException("Binary replay is incomplete");
+	}
+	auto num = read64(trailer.indexOffset);
+	if (num > (mmap.size() / sizeof(uint64_t))) {
+		throw MSXException("Corrupt binary replay: invalid index");
+	}
+	bool haveEventLog = false;
+	for (auto i : xrange(num)) {
+		auto offset = read64(trailer.indexOffset + (i + 1) * sizeof(uint64_t));
+		ChunkHeader header;
+		memcpy(&header, get(offset, sizeof(header)).data(), sizeof(header));
+		(void)get(offset + sizeof(header), header.storedSize); // bounds check
+		Chunk chunk = {EmuTime::zero() + EmuDuration(header.time),
+		               header.eventCount, offset};
+		if (header.type == SNAPSHOT) {
+			snapshots.push_back(chunk);
+		} else if (header.type == EVENT_LOG) {
+			eventLog = chunk;
+			haveEventLog = true;
+		}
+		// ignore unknown chunk types
+	}
+	if (snapshots.empty() || !haveEventLog) {
+		throw MSXException("Corrupt binary replay: missing chunks");
+	}
+	std::sort(snapshots.begin(), snapshots.end(),
+	          [](const Chunk& x, const Chunk& y) { return x.time < y.time; });
+}
+
+BinaryReplayReader::~BinaryReplayReader()
+{
+	// No more diffs will be made against the last loaded copies.
+	lastDeltaBlocks.clear();
+}
+
+span<const uint8_t> BinaryReplayReader::get(size_t offset, size_t size) const
+{
+	if ((offset > mmap.size()) || (size > (mmap.size() - offset))) {
+		throw MSXException("Corrupt binary replay: unexpected end of file");
+	}
+	return mmap.subspan(offset, size);
+}
+
+void BinaryReplayReader::load(
+	const Chunk& chunk, MemBuffer<uint8_t>& data, size_t& size,
+	std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks)
+{
+	ChunkHeader header;
+	memcpy(&header, get(chunk.offset, sizeof(header)).data(), sizeof(header));
+	auto stored = get(chunk.offset + sizeof(header), header.storedSize);
+	// Also protects the (unchecked) LZ4 decompression against corrupt data.
+	if (calcChecksum(header, stored) != header.checksum) {
+		throw MSXException("Corrupt binary replay: checksum mismatch");
+	}
+
+	span<const uint8_t> raw = stored;
+	MemBuffer<uint8_t> buf;
+	if (header.storedSize != header.rawSize) {
+		if (header.rawSize > size_t(std::numeric_limits<int>::max())) {
+			throw MSXException("Corrupt binary replay: invalid chunk size");
+		}
+		buf.resize(header.rawSize);
+		auto len = LZ4::decompress(stored.data(), buf.data(),
+		                           int(stored.size()), int(header.rawSize));
+		if (size_t(len) != header.rawSize) {
+			throw MSXException("Corrupt binary replay: decompression failed");
+		}
+		raw = span<const uint8_t>(buf.data(), header.rawSize);
+	}
+
+	auto take = [&](size_t n) {
+		if (n > raw.size()) {
+			throw MSXException("Corrupt binary replay: invalid chunk");
+		}
+		auto result = raw.first(n);
+		raw = raw.subspan(n);
+		return result;
+	};
+	uint64_t dataSize;
+	memcpy(&dataSize, take(sizeof(dataSize)).data(), sizeof(dataSize));
+	auto d = take(dataSize);
+	data.resize(dataSize);
+	if (dataSize) memcpy(data.data(), d.data(), dataSize);
+	size = dataSize;
+
+	uint32_t num;
+	memcpy(&num, take(sizeof(num)).data(), sizeof(num));
+	deltaBlocks.clear();
+	deltaBlocks.reserve(std::min<size_t>(num, raw.size() / sizeof(uint64_t)));
+	for (auto i : xrange(num)) {
+		uint64_t blockSize;
+		memcpy(&blockSize, take(sizeof(blockSize)).data(), sizeof(blockSize));
+		auto content = take(blockSize);
+		if (header.type == EVENT_LOG) {
+			// Unrelated to the blocks in the snapshots, don't
+			// disturb the diffs between those.
+			auto b = std::make_shared<DeltaBlockCopy>(content.data(), blockSize);
+			b->compress(blockSize);
+			deltaBlocks.push_back(std::move(b));
+			continue;
+		}
+		// The file doesn't store which memory a block belongs to, but
+		// the order of the blocks is the same in each snapshot (see
+		// MemOutputArchive). A wrong guess is only less efficient.
+		const void* id = reinterpret_cast<const void*>(uintptr_t(i));
+		deltaBlocks.push_back(lastDeltaBlocks.createNew(
+			id, content.data(), blockSize));
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,140 @@
+#ifndef BINARYREPLAY_HH
+#define BINARYREPLAY_HH
+
+#include "DeltaBlock.hh"
+#include "EmuTime.hh"
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "span.hh"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Binary (chunked) replay file format.
+  *
+  * This is an alternative for the XML replay format. Snapshots are stored in
+  * the same layout as the in-memory reverse snapshots (see MemOutputArchive
+  * and DeltaBlock), so saving and loading doesn't require to (de)serialize
+  * the machines, it's only LZ4 (de)compression and I/O. The drawback is that
+  * this layout is not versioned: a binary replay can only be loaded by the
+  * exact same openMSX version (and platform) that created it. Use the XML
+  * format to exchange replays.
+  *
+  * File layout (all values in native byte order):
+  *  - header:  magic, format version, byte order mark, creator string
+  *  - chunks:  one per snapshot, followed by one for the event log. Each
+  *             chunk has a header (type, time, event count, sizes and a
+  *             checksum), followed by the (possibly LZ4 compressed) payload:
+  *             the serialized data followed by the content of the delta
+  *             blocks.
+  *  - index:   the offsets of all chunks
+  *  - trailer: the offset of the index, magic
+  * Chunks are written one after the other, so no more than one chunk needs
+  * to be kept in memory. Via the index all chunks can be located without
+  * reading (or decompressing) their payload.
+  *
+  * The writer first writes to a temporary file, close() renames it to the
+  * final name. So a BinaryReplayReader of the same file (the snapshots of a
+  * loaded replay are only read on first use) keeps on working, and a failed
+  * save doesn't destroy an existing replay. Except on Windows: there a file
+  * can't be replaced while it's mapped in memory, so the reader must be
+  * destroyed first.
+  */
+class BinaryReplayWriter
+{
+public:
+	/** @throws FileException */
+	explicit BinaryReplayWriter(const std::string& filename);
+
+	/** Removes the temporary file when close() wasn't (successfully)
+	  * called. */
+	~BinaryReplayWriter();
+	BinaryReplayWriter(const BinaryReplayWriter&) = delete;
+	BinaryReplayWriter& operator=(const BinaryReplayWriter&) = delete;
+
+	/** @throws FileException */
+	void addSnapshot(EmuTime::param time, unsigned eventCount,
+	                 span<const uint8_t> savestate,
+	                 span<const std::shared_ptr<DeltaBlock>> deltaBlocks);
+
+	/** Should be called once, after all snapshots were added.
+	  * @throws FileException */
+	void addEventLog(span<const uint8_t> data,
+	                 span<const std::shared_ptr<DeltaBlock>> deltaBlocks);
+
+	/** Write the index and move the file to its final name. Without
+	  * this, the file is not written.
+	  * @throws FileException */
+	void close();
+
+private:
+	void writeChunk(uint32_t type, EmuTime::param time, unsigned eventCount,
+	                span<const uint8_t> data,
+	                span<const std::shared_ptr<DeltaBlock>> deltaBlocks);
+	void write(const void* data, size_t size);
+
+private:
+	const std::string filename;
+	const std::string tmpFilename;
+	File file;
+	std::vector<uint64_t> offsets;
+	uint64_t pos = 0;
+	bool closed = false;
+};
+
+class BinaryReplayReader
+{
+public:
+	struct Chunk {
+		EmuTime time;
+		unsigned eventCount;
+		size_t offset; // of the chunk header in the file
+	};
+
+	/** Does the given file start with the binary replay header? (Other
+	  * replays are in XML format.) Doesn't throw. */
+	[[nodiscard]] static bool isBinaryReplay(const std::string& filename);
+
+	/** Reads the header and the index.
+	  * @throws MSXException */
+	explicit BinaryReplayReader(const std::string& filename);
+
+	/** Compresses the blocks that were used as reference for the diffs
+	  * (see LastDeltaBlocks::clear()). */
+	~BinaryReplayReader();
+	BinaryReplayReader(const BinaryReplayReader&) = delete;
+	BinaryReplayReader& operator=(const BinaryReplayReader&) = delete;
+
+	[[nodiscard]] const std::string& getFilename() const { return filename; }
+
+	/** The snapshots in this replay, ordered by time. */
+	[[nodiscard]] span<const Chunk> getSnapshots() const { return snapshots; }
+	[[nodiscard]] const Chunk& getEventLog() const { return eventLog; }
+
+	/** Restore the serialized data and the delta blocks of a chunk.
+	  * Like for the in-memory snapshots, the blocks are stored as a diff
+	  * against the same block of the previously loaded chunk (see
+	  * LastDeltaBlocks). The blocks of the event log are stored as
+	  * (compressed) copies.
+	  * @throws MSXException */
+	void load(const Chunk& chunk, MemBuffer<uint8_t>& data, size_t& size,
+	          std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks);
+
+private:
+	[[nodiscard]] span<const uint8_t> get(size_t offset, size_t size) const;
+
+private:
+	const std::string filename;
+	File file;
+	span<const uint8_t> mmap;
+	std::vector<Chunk> snapshots;
+	Chunk eventLog = {EmuTime::zero(), 0, 0};
+	LastDeltaBlocks lastDeltaBlocks;
+};
+
+} // namespace openmsx
+
+#endif
@@ -43,6 +43,15 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 			{"hq",   ResampledSoundDevice::RESAMPLE_HQ},
 			{"fast", ResampledSoundDevice::RESAMPLE_LQ},
 			{"blip", ResampledSoundDevice::RESAMPLE_BLIP}})
+	, reverseMaxMemorySetting(commandController, "reverse_max_memory",
+		"maximum amount of memory (in MB) used by the reverse history of "
+		"each machine, older snapshots are dropped when needed (0 = unlimited)",
+		0, 0, 1024 * 1024)
+	, reverseSpillAfterSetting(commandController, "reverse_spill_after",
+		"move reverse snapshots that are older than this many seconds "
+		"(emulated time) from memory to a temporary file on disk "
+		"(0 = keep all snapshots in memory)",
+		0, 0, 1000 * 1000)
 	, speedManager(commandController)
 	, throttleManager(commandController)
 {
@@ -48,6 +48,12 @@ public:
 	[[nodiscard]] EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
+	[[nodiscard]] IntegerSetting& getReverseMaxMemorySetting() {
+		return reverseMaxMemorySetting;
+	}
+	[[nodiscard]] IntegerSetting& getReverseSpillAfterSetting() {
+		return reverseSpillAfterSetting;
+	}
 	[[nodiscard]] IntegerSetting& getJoyDeadzoneSetting(int i) {
 		return *deadzoneSettings[i];
 	}
@@ -72,6 +78,8 @@ private:
 	StringSetting  invalidPsgDirectionsSetting;
 	StringSetting  invalidPpiModeSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
+	IntegerSetting reverseMaxMemorySetting;
+	IntegerSetting reverseSpillAfterSetting;
 	std::vector<std::unique_ptr<IntegerSetting>> deadzoneSettings;
 	SpeedManager speedManager;
 	ThrottleManager throttleManager;
@@ -200,7 +200,7 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	, msxCommandController(make_unique<MSXCommandController>(
 		reactor.getGlobalCommandController(), reactor,
 		*this, *msxEventDistributor, machineID))
-	, scheduler(make_unique<Scheduler>())
+	, scheduler(make_unique<Scheduler>(&reactor.getSchedulerProfile()))
 	, msxMixer(make_unique<MSXMixer>(
 		reactor.getMixer(), *this,
 		reactor.getGlobalSettings()))
@@ -12,6 +12,7 @@
 #include "UserSettings.hh"
 #include "RomDatabase.hh"
 #include "RomInfo.hh"
+#include "Scheduler.hh"
 #include "TclCallbackMessages.hh"
 #include "MSXMotherBoard.hh"
 #include "StateChangeDistributor.hh"
@@ -231,6 +232,7 @@ void Reactor::init()
 	virtualDrive = make_unique<DiskChanger>(
 		*this, "virtual_drive");
 	filePool = make_unique<FilePool>(*globalCommandController, *this);
+	schedulerProfile = make_unique<SchedulerProfile>();
 	userSettings = make_unique<UserSettings>(
 		*globalCommandController);
 	afterCommand = make_unique<AfterCommand>(
@@ -28,6 +28,7 @@ class DiskFactory;
 class DiskManipulator;
 class DiskChanger;
 class FilePool;
+class SchedulerProfile;
 class UserSettings;
 class RomDatabase;
 class TclCallbackMessages;
@@ -101,6 +102,7 @@ public:
 
 	// convenience methods
 	[[nodiscard]] GlobalSettings& getGlobalSettings() { return *globalSettings; }
+	[[nodiscard]] SchedulerProfile& getSchedulerProfile() { return *schedulerProfile; }
 	[[nodiscard]] InfoCommand& getOpenMSXInfoCommand();
 	[[nodiscard]] CommandController& getCommandController();
 	[[nodiscard]] CliComm& getCliComm();
@@ -150,6 +152,7 @@ private:
 	std::unique_ptr<DiskManipulator> diskManipulator;
 	std::unique_ptr<DiskChanger> virtualDrive;
 	std::unique_ptr<FilePool> filePool;
+	std::unique_ptr<SchedulerProfile> schedulerProfile;
 
 	std::unique_ptr<EnumSetting<int>> machineSetting;
 	std::unique_ptr<UserSettings> userSettings;
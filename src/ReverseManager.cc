@@ -7,6 +7,7 @@
 #include "Debugger.hh"
 #include "EventDelay.hh"
 #include "MSXMixer.hh"
+#include "MSXCPU.hh"
 #include "MSXCommandController.hh"
 #include "XMLException.hh"
 #include "TclArgParser.hh"
@@ -20,11 +21,17 @@
 #include "Reactor.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
+#include "GlobalSettings.hh"
+#include "BinaryReplay.hh"
+#include "FileException.hh"
+#include "hash_map.hh"
+#include "hash_set.hh"
 #include "one_of.hh"
 #include "ranges.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include <cassert>
 #include <cmath>
 #include <iomanip>
@@ -50,6 +57,13 @@ constexpr auto MAX_DIST_1_BEFORE_LAST_SNAPSHOT = EmuDuration(30.0);
 
 constexpr const char* const REPLAY_DIR = "replays";
 
+// Windows can't replace a file while it's mapped in memory (see BinaryReplay)
+#ifdef _WIN32
+constexpr bool CAN_REPLACE_MAPPED_FILE = false;
+#else
+constexpr bool CAN_REPLACE_MAPPED_FILE = true;
+#endif
+
 // A replay is a struct that contains a vector of motherboards and an MSX event
 // log. Those combined are a replay, because you can replay the events from an
 // existing motherboard state: the vector has to have at least one motherboard
@@ -108,6 +122,7 @@ void ReverseManager::ReverseHistory::swap(ReverseHistory& other) noexcept
 {
 	std::swap(chunks, other.chunks);
 	std::swap(events, other.events);
+	std::swap(spillFile, other.spillFile);
 }
 
 void ReverseManager::ReverseHistory::clear()
@@ -115,6 +130,33 @@ void ReverseManager::ReverseHistory::clear()
 	// clear() and free storage capacity
 	Chunks().swap(chunks);
 	Events().swap(events);
+	// (spilled) blocks keep the file alive as long as they need it
+	spillFile.reset();
+}
+
+size_t ReverseManager::ReverseHistory::getMemoryUsage() const
+{
+	// Delta blocks are shared between chunks (e.g. unchanged memory reuses
+	// the previous block, and a diff keeps its reference block alive, even
+	// when the chunk that created that reference is already dropped). Count
+	// each block only once.
+	hash_set<const DeltaBlock*> seen;
+	size_t result = 0;
+	auto count = [&](const DeltaBlock& block) {
+		if (seen.insert(&block).second) {
+			result += block.getMemorySize();
+		}
+	};
+	for (const auto& [idx, chunk] : chunks) {
+		if (!chunk.spillFile) result += chunk.size;
+		for (const auto& block : chunk.deltaBlocks) {
+			count(*block);
+			if (auto* diff = dynamic_cast<const DeltaBlockDiff*>(block.get())) {
+				count(diff->getReference());
+			}
+		}
+	}
+	return result;
 }
 
 
@@ -210,6 +252,40 @@ EmuTime::param ReverseManager::getEndTime(const ReverseHistory& hist) const
 	return getCurrentTime();
 }
 
+bool ReverseManager::ReverseChunk::isCommitted() const
+{
+	return ranges::all_of(deltaBlocks, [](auto& b) { return b->isReady(); });
+}
+
+span<const uint8_t> ReverseManager::ReverseChunk::getSavestate() const
+{
+	if (spillFile) return spillFile->read(spillLoc);
+	return {savestate.data(), size};
+}
+
+void ReverseManager::ReverseChunk::spill(const std::shared_ptr<SpillFile>& file)
+{
+	if (replayFile) return; // not loaded yet, nothing to move
+	if (!spillFile) {
+		spillLoc = file->append(getSavestate());
+		spillFile = file;
+		MemBuffer<uint8_t>().swap(savestate);
+	}
+	// Also for chunks that were spilled before: blocks that are shared
+	// with newer chunks may only now be ready to be moved.
+	for (auto& block : deltaBlocks) {
+		block->spill(file);
+	}
+}
+
+void ReverseManager::ReverseChunk::load()
+{
+	if (!replayFile) return;
+	replayFile->load(replayFile->getSnapshots()[replaySnapshot],
+	                 savestate, size, deltaBlocks);
+	replayFile.reset();
+}
+
 void ReverseManager::status(TclObject& result) const
 {
 	result.addDictKeyValue("status", !isCollecting() ? "disabled"
@@ -232,6 +308,13 @@ void ReverseManager::status(TclObject& result) const
 	}));
 	result.addDictKeyValue("snapshots", snapshots);
 
+	auto pending = ranges::count_if(history.chunks, [](auto& p) {
+		return !p.second.isCommitted();
+	});
+	result.addDictKeyValue("pending_snapshots", int(pending));
+
+	result.addDictKeyValue("memory", uint64_t(history.getMemoryUsage()));
+
 	auto lastEvent = rbegin(history.events);
 	if (lastEvent != rend(history.events) && dynamic_cast<const EndLogEvent*>(lastEvent->get())) {
 		++lastEvent;
@@ -251,10 +334,15 @@ void ReverseManager::debugInfo(TclObject& result) const
 		          (chunk.time - EmuTime::zero()).toDouble(), ' ',
 		          ((chunk.time - EmuTime::zero()).toDouble() / (getCurrentTime() - EmuTime::zero()).toDouble()) * 100, "%"
 		          " (", chunk.size, ")"
-		          " (next event index: ", chunk.eventCount, ")\n");
+		          " (next event index: ", chunk.eventCount, ")",
+		          chunk.isCommitted() ? "" : " (pending)",
+		          chunk.spillFile ? " (on disk)" : "",
+		          chunk.replayFile ? " (not loaded)" : "", '\n');
 		totalSize += chunk.size;
 	}
-	strAppend(res, "total size: ", totalSize, '\n');
+	strAppend(res, "total size: ", totalSize, '\n',
+	          "total memory: ", history.getMemoryUsage(), '\n',
+	          "on disk: ", history.spillFile ? history.spillFile->getSize() : 0, '\n');
 	result = res;
 }
 
@@ -392,10 +480,11 @@ void ReverseManager::goTo(
 		} else {
 			// Note: we don't (anymore) erase future snapshots
 			// -- restore old snapshot --
+			chunk.load();
 			newBoard_ = reactor.createEmptyMotherBoard();
 			newBoard = newBoard_.get();
-			MemInputArchive in(chunk.savestate.data(),
-					   chunk.size,
+			auto savestate = chunk.getSavestate();
+			MemInputArchive in(savestate.data(), savestate.size(),
 					   chunk.deltaBlocks);
 			in.serialize("machine", *newBoard);
 
@@ -527,14 +616,18 @@ void ReverseManager::transferState(MSXMotherBoard& newBoard)
 void ReverseManager::saveReplay(
 	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
-	const auto& chunks = history.chunks;
+	auto& chunks = history.chunks;
 	if (chunks.empty()) {
 		throw CommandException("No recording...");
 	}
 
 	std::string_view filenameArg;
 	int maxNofExtraSnapshots = MAX_NOF_SNAPSHOTS;
-	ArgsInfo info[] = { valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots) };
+	bool binary = false;
+	ArgsInfo info[] = {
+		valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots),
+		flagArg("-binary", binary),
+	};
 	auto args = parseTclArgs(interp, tokens.subspan(2), info);
 	switch (args.size()) {
 		case 0: break; // nothing
@@ -548,21 +641,8 @@ void ReverseManager::saveReplay(
 	string filename = FileOperations::parseCommandFileArgument(
 		filenameArg, REPLAY_DIR, "openmsx", ".omr");
 
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
-	replay.reRecordCount = reRecordCount;
-
-	// store current time (possibly somewhere in the middle of the timeline)
-	// so that on load we can go back there
-	replay.currentTime = getCurrentTime();
-
-	// restore first snapshot to be able to serialize it to a file
-	auto initialBoard = reactor.createEmptyMotherBoard();
-	MemInputArchive in(begin(chunks)->second.savestate.data(),
-	                   begin(chunks)->second.size,
-			   begin(chunks)->second.deltaBlocks);
-	in.serialize("machine", *initialBoard);
-	replay.motherBoards.push_back(move(initialBoard));
+	// the first snapshot is always included
+	std::vector<Chunks::iterator> snapshots = {begin(chunks)};
 
 	if (maxNofExtraSnapshots > 0) {
 		// determine which extra snapshots to put in the replay
@@ -578,21 +658,14 @@ void ReverseManager::saveReplay(
 		partitionLength = std::max(MIN_PARTITION_LENGTH, partitionLength);
 		EmuTime nextPartitionEnd = startTime + partitionLength;
 		auto it = begin(chunks);
-		auto lastAddedIt = begin(chunks); // already added
 		while (it != end(chunks)) {
 			++it;
 			if (it == end(chunks) || (it->second.time > nextPartitionEnd)) {
 				--it;
 				assert(it->second.time <= nextPartitionEnd);
-				if (it != lastAddedIt) {
+				if (it != snapshots.back()) {
 					// this is a new one, add it to the list of snapshots
-					Reactor::Board board = reactor.createEmptyMotherBoard();
-					MemInputArchive in2(it->second.savestate.data(),
-							    it->second.size,
-							    it->second.deltaBlocks);
-					in2.serialize("machine", *board);
-					replay.motherBoards.push_back(move(board));
-					lastAddedIt = it;
+					snapshots.push_back(it);
 				}
 				++it;
 				while (it != end(chunks) && it->second.time > nextPartitionEnd) {
@@ -600,7 +673,7 @@ void ReverseManager::saveReplay(
 				}
 			}
 		}
-		assert(lastAddedIt == std::prev(end(chunks))); // last snapshot must be included
+		assert(snapshots.back() == std::prev(end(chunks))); // last snapshot must be included
 	}
 
 	// add sentinel when there isn't one yet
@@ -612,10 +685,28 @@ void ReverseManager::saveReplay(
 			getCurrentTime()));
 	}
 	try {
-		XmlOutputArchive out(filename);
-		replay.events = &history.events;
-		out.serialize("replay", replay);
-		out.close();
+		if constexpr (!CAN_REPLACE_MAPPED_FILE) {
+			// The snapshots of a loaded binary replay are read from
+			// the (memory mapped) file on first use. When that file
+			// gets overwritten, load them all now, that releases the
+			// file.
+			auto target = FileOperations::getAbsolutePath(filename);
+			for (auto& [idx, chunk] : chunks) {
+				if (chunk.replayFile &&
+				    (FileOperations::getAbsolutePath(
+				         chunk.replayFile->getFilename()) == target)) {
+					chunk.load();
+				}
+			}
+		}
+		for (auto& it : snapshots) {
+			it->second.load();
+		}
+		if (binary) {
+			saveBinaryReplay(filename, snapshots);
+		} else {
+			saveXmlReplay(filename, snapshots);
+		}
 	} catch (MSXException&) {
 		if (addSentinel) {
 			history.events.pop_back();
@@ -634,6 +725,104 @@ void ReverseManager::saveReplay(
 	result = tmpStrCat("Saved replay to ", filename);
 }
 
+void ReverseManager::saveXmlReplay(
+	const std::string& filename, span<const Chunks::iterator> snapshots)
+{
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	replay.reRecordCount = reRecordCount;
+
+	// store current time (possibly somewhere in the middle of the timeline)
+	// so that on load we can go back there
+	replay.currentTime = getCurrentTime();
+
+	// restore the snapshots to be able to serialize them to a file
+	for (const auto& it : snapshots) {
+		Reactor::Board board = reactor.createEmptyMotherBoard();
+		auto savestate = it->second.getSavestate();
+		MemInputArchive in(savestate.data(), savestate.size(),
+		                   it->second.deltaBlocks);
+		in.serialize("machine", *board);
+		replay.motherBoards.push_back(move(board));
+	}
+
+	// Same as in BinaryReplayWriter: write to a temporary file first, the
+	// not yet loaded snapshots may still read from the file that is being
+	// replaced.
+	auto tmpFilename = strCat(filename, ".tmp");
+	try {
+		XmlOutputArchive out(tmpFilename);
+		replay.events = &history.events;
+		out.serialize("replay", replay);
+		out.close();
+	} catch (MSXException&) {
+		FileOperations::unlink(tmpFilename);
+		throw;
+	}
+	if (FileOperations::rename(tmpFilename, filename) != 0) {
+		FileOperations::unlink(tmpFilename);
+		throw FileException("Couldn't replace ", filename,
+		                    ", is it still in use?");
+	}
+}
+
+void ReverseManager::saveBinaryReplay(
+	const std::string& filename, span<const Chunks::iterator> snapshots)
+{
+	// The snapshots are stored as-is, no need to restore them.
+	BinaryReplayWriter writer(filename);
+	for (const auto& it : snapshots) {
+		const auto& chunk = it->second;
+		writer.addSnapshot(chunk.time, chunk.eventCount,
+		                   chunk.getSavestate(), chunk.deltaBlocks);
+	}
+
+	// see Replay::serialize()
+	LastDeltaBlocks lastDeltaBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+	EmuTime currentTime = getCurrentTime();
+	out.serialize("events",        history.events,
+	              "currentTime",   currentTime,
+	              "reRecordCount", reRecordCount);
+	size_t size;
+	auto buf = out.releaseBuffer(size);
+	writer.addEventLog({buf.data(), size}, deltaBlocks);
+	writer.close();
+}
+
+void ReverseManager::loadBinaryReplay(
+	const std::string& filename, ReverseHistory& newHistory,
+	EmuTime& currentTime, unsigned& newReRecordCount)
+{
+	auto reader = std::make_shared<BinaryReplayReader>(filename);
+
+	MemBuffer<uint8_t> buf;
+	size_t size;
+	std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	reader->load(reader->getEventLog(), buf, size, deltaBlocks);
+	MemInputArchive in(buf.data(), size, deltaBlocks);
+	in.serialize("events",        newHistory.events,
+	             "currentTime",   currentTime,
+	             "reRecordCount", newReRecordCount);
+
+	// Only the index is read here. Most snapshots of a long replay are
+	// never visited, so their content is only read (and decompressed)
+	// on first use, see ReverseChunk::load(). The chunks keep the file
+	// open till then.
+	auto snapshots = reader->getSnapshots();
+	for (auto i : xrange(snapshots.size())) {
+		ReverseChunk newChunk;
+		newChunk.time = snapshots[i].time;
+		newChunk.eventCount = snapshots[i].eventCount;
+		newChunk.size = 0;
+		newChunk.replayFile = reader;
+		newChunk.replaySnapshot = i;
+		newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
+			move(newChunk);
+	}
+}
+
 void ReverseManager::loadReplay(
 	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
@@ -670,9 +859,17 @@ void ReverseManager::loadReplay(
 	Replay replay(reactor);
 	Events events;
 	replay.events = &events;
+	bool binary = BinaryReplayReader::isBinaryReplay(filename);
+	ReverseHistory binaryHistory;
+	unsigned newReRecordCount = 0;
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("replay", replay);
+		if (binary) {
+			loadBinaryReplay(filename, binaryHistory,
+			                 replay.currentTime, newReRecordCount);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("replay", replay);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load replay, bad file format: ",
 		                       e.getMessage());
@@ -697,48 +894,53 @@ void ReverseManager::loadReplay(
 	// now we can change the view only mode
 	motherBoard.getStateChangeDistributor().setViewOnlyMode(enableViewOnly);
 
-	assert(!replay.motherBoards.empty());
-	auto& newReverseManager = replay.motherBoards[0]->getReverseManager();
-	auto& newHistory = newReverseManager.history;
+	assert(binary || !replay.motherBoards.empty());
+	auto& newHistory = binary
+		? binaryHistory
+		: replay.motherBoards[0]->getReverseManager().history;
+	if (!binary) {
+		auto& newReverseManager = replay.motherBoards[0]->getReverseManager();
 
-	if (newReverseManager.reRecordCount == 0) {
-		// serialize Replay version >= 4
-		newReverseManager.reRecordCount = replay.reRecordCount;
-	} else {
-		// newReverseManager.reRecordCount is initialized via
-		// call from MSXMotherBoard to setReRecordCount()
-	}
+		if (newReverseManager.reRecordCount == 0) {
+			// serialize Replay version >= 4
+			newReverseManager.reRecordCount = replay.reRecordCount;
+		} else {
+			// newReverseManager.reRecordCount is initialized via
+			// call from MSXMotherBoard to setReRecordCount()
+		}
 
-	// Restore event log
-	swap(newHistory.events, events);
-	auto& newEvents = newHistory.events;
+		// Restore event log
+		swap(newHistory.events, events);
+		auto& newEvents = newHistory.events;
+
+		// Restore snapshots
+		unsigned replayIdx = 0;
+		for (auto& m : replay.motherBoards) {
+			ReverseChunk newChunk;
+			newChunk.time = m->getCurrentTime();
+
+			MemOutputArchive out(newHistory.lastDeltaBlocks,
+			                     newChunk.deltaBlocks, false);
+			out.serialize("machine", *m);
+			newChunk.savestate = out.releaseBuffer(newChunk.size);
+
+			// update replayIdx
+			// TODO: should we use <= instead??
+			while (replayIdx < newEvents.size() &&
+			       (newEvents[replayIdx]->getTime() < newChunk.time)) {
+				replayIdx++;
+			}
+			newChunk.eventCount = replayIdx;
 
-	// Restore snapshots
-	unsigned replayIdx = 0;
-	for (auto& m : replay.motherBoards) {
-		ReverseChunk newChunk;
-		newChunk.time = m->getCurrentTime();
-
-		MemOutputArchive out(newHistory.lastDeltaBlocks,
-		                     newChunk.deltaBlocks, false);
-		out.serialize("machine", *m);
-		newChunk.savestate = out.releaseBuffer(newChunk.size);
-
-		// update replayIdx
-		// TODO: should we use <= instead??
-		while (replayIdx < newEvents.size() &&
-		       (newEvents[replayIdx]->getTime() < newChunk.time)) {
-			replayIdx++;
+			newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
+				move(newChunk);
 		}
-		newChunk.eventCount = replayIdx;
-
-		newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
-			move(newChunk);
+		newReRecordCount = newReverseManager.reRecordCount;
 	}
 
 	// Note: until this point we didn't make any changes to the current
 	// ReverseManager/MSXMotherBoard yet
-	reRecordCount = newReverseManager.reRecordCount;
+	reRecordCount = newReRecordCount;
 	bool novideo = false;
 	goTo(destination, novideo, newHistory, false); // move to different time-line
 
@@ -853,6 +1055,8 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	//      when going back/forward in time?
 	unsigned seqNum = history.getNextSeqNum(time);
 	dropOldSnapshots<25>(seqNum);
+	dropSnapshotsForMemoryLimit(time);
+	spillOldSnapshots(time);
 
 	// During replay we might already have a snapshot with the current
 	// sequence number, though this snapshot does not necessarily have the
@@ -864,8 +1068,13 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	newChunk.deltaBlocks.clear();
 	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
 	out.serialize("machine", motherBoard);
+	// Ram with dirty tracking only notices writes via the CPU when the
+	// write cache lines are requested again, see Ram::enableDirtyTracking().
+	motherBoard.getCPU().invalidateAllSlotsRWCache(0x0000, 0x10000);
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
+	newChunk.spillFile.reset();
+	newChunk.replayFile.reset();
 	newChunk.eventCount = replayIndex;
 }
 
@@ -947,6 +1156,122 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 	}
 }
 
+/* Drop snapshots until the memory used by the reverse history is within the
+ * limit set by the 'reverse_max_memory' setting. This is checked before a new
+ * snapshot is added (then the delta blocks of the previous snapshots are
+ * finished and their size is known), so the limit can temporarily be exceeded
+ * by (the size of) one snapshot.
+ *
+ * First the history is thinned: drop the snapshot that leaves the smallest
+ * gap relative to its distance to the current time. So recent history stays
+ * dense and distant history becomes sparse (similar to dropOldSnapshots()).
+ * Only when the whole history is already sparse, the oldest snapshot is
+ * dropped. The most recent snapshot is never dropped, neither are the
+ * snapshots of a replay that weren't loaded yet (they don't use memory).
+ */
+void ReverseManager::dropSnapshotsForMemoryLimit(EmuTime::param time)
+{
+	size_t limit = size_t(motherBoard.getReactor().getGlobalSettings()
+	                          .getReverseMaxMemorySetting().getInt()) << 20;
+	if (limit == 0) return;
+
+	// Same as history.getMemoryUsage(), but calculated only once. Delta
+	// blocks can be shared between chunks, so count the references to each
+	// block. Dropping a chunk only frees the blocks that are no longer
+	// referenced by any other chunk. The size of a block can change while
+	// it's (asynchronously) being compressed, so remember the size that
+	// was counted and subtract exactly that.
+	hash_map<const DeltaBlock*, std::pair<unsigned, size_t>> refCount;
+	size_t usage = 0;
+	auto forEachBlock = [](const ReverseChunk& chunk, auto op) {
+		for (const auto& block : chunk.deltaBlocks) {
+			op(*block);
+			if (auto* diff = dynamic_cast<const DeltaBlockDiff*>(block.get())) {
+				op(diff->getReference());
+			}
+		}
+	};
+	auto addRef = [&](const DeltaBlock& block) {
+		auto& [count, size] = refCount[&block];
+		if (count++ == 0) {
+			size = block.getMemorySize();
+			usage += size;
+		}
+	};
+	auto releaseRef = [&](const DeltaBlock& block) {
+		auto& [count, size] = refCount[&block];
+		assert(count > 0);
+		if (--count == 0) usage -= size;
+	};
+
+	auto& chunks = history.chunks;
+	for (const auto& [idx, chunk] : chunks) {
+		if (!chunk.spillFile) usage += chunk.size;
+		forEachBlock(chunk, addRef);
+	}
+
+	auto toDouble = [](EmuTime::param t) { return (t - EmuTime::zero()).toDouble(); };
+	double now = toDouble(time);
+	while ((chunks.size() > 1) && (usage > limit)) {
+		// Thinning beyond this ratio (gap / distance) is worse than
+		// shortening the history.
+		double bestRatio = 0.5;
+		auto best = end(chunks);
+		auto oldest = end(chunks);
+		for (auto it = begin(chunks); std::next(it) != end(chunks); ++it) {
+			// Snapshots of a replay that weren't loaded yet don't
+			// use memory, dropping them doesn't help.
+			if (it->second.replayFile) continue;
+			if (oldest == end(chunks)) oldest = it;
+			if (it == begin(chunks)) continue;
+			double gap = toDouble(std::next(it)->second.time) -
+			             toDouble(std::prev(it)->second.time);
+			double dist = std::max(std::abs(now - toDouble(it->second.time)),
+			                       SNAPSHOT_PERIOD);
+			if (double ratio = gap / dist; ratio < bestRatio) {
+				bestRatio = ratio;
+				best = it;
+			}
+		}
+		if (best == end(chunks)) best = oldest;
+		if (best == end(chunks)) break;
+		if (!best->second.spillFile) usage -= best->second.size;
+		forEachBlock(best->second, releaseRef);
+		chunks.erase(best);
+	}
+}
+
+/* Move snapshots that are older than 'reverse_spill_after' seconds from
+ * memory to disk (see SpillFile). Recent snapshots stay in memory, so going
+ * back a short amount of time remains fast. Only snapshots of which the
+ * (background) delta calculation has finished are moved.
+ */
+void ReverseManager::spillOldSnapshots(EmuTime::param time)
+{
+	auto& setting = motherBoard.getReactor().getGlobalSettings()
+	                    .getReverseSpillAfterSetting();
+	int age = setting.getInt();
+	if (age == 0) return;
+
+	try {
+		for (auto& [idx, chunk] : history.chunks) {
+			if ((chunk.time + EmuDuration(double(age))) > time) break;
+			if (!chunk.isCommitted()) continue;
+			if (!history.spillFile) {
+				history.spillFile = std::make_shared<SpillFile>();
+			}
+			chunk.spill(history.spillFile);
+		}
+	} catch (FileException& e) {
+		// Data that was already moved remains valid, the rest simply
+		// stays in memory.
+		setting.setInt(0);
+		motherBoard.getMSXCliComm().printWarning(
+			"Couldn't move reverse history to disk, disabled "
+			"reverse_spill_after: ", e.getMessage());
+	}
+}
+
 void ReverseManager::schedule(EmuTime::param time)
 {
 	syncNewSnapshot.setSyncPoint(time + EmuDuration(SNAPSHOT_PERIOD));
@@ -1001,7 +1326,7 @@ string ReverseManager::ReverseCmd::help(span<const TclObject> /*tokens*/) const
 	       "goto <time>         go to an absolute moment in time\n"
 	       "viewonlymode <bool> switch viewonly mode on or off\n"
 	       "truncatereplay      stop replaying and remove all 'future' data\n"
-	       "savereplay [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
+	       "savereplay [-binary] [<name>] save the first snapshot and all replay data as a 'replay' (with optional name), optionally in the faster binary format\n"
 	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n";
 }
 
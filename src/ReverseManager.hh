@@ -8,6 +8,7 @@
 #include "EmuTime.hh"
 #include "MemBuffer.hh"
 #include "DeltaBlock.hh"
+#include "SpillFile.hh"
 #include "span.hh"
 #include "outer.hh"
 #include <vector>
@@ -17,6 +18,7 @@
 
 namespace openmsx {
 
+class BinaryReplayReader;
 class MSXMotherBoard;
 class Keyboard;
 class EventDelay;
@@ -56,11 +58,40 @@ private:
 	struct ReverseChunk {
 		ReverseChunk() : time(EmuTime::zero()) {}
 
+		/** Delta blocks are calculated in the background. A chunk is
+		  * 'committed' once all that work has finished. Restoring a
+		  * not yet committed chunk is possible, but will block. */
+		[[nodiscard]] bool isCommitted() const;
+
+		/** The serialized machine (without the delta blocks). For a
+		  * spilled chunk the result is only valid until the next
+		  * spill to the same file. */
+		[[nodiscard]] span<const uint8_t> getSavestate() const;
+
+		/** Move the savestate and the delta blocks from memory to
+		  * the given file (see SpillFile). */
+		void spill(const std::shared_ptr<SpillFile>& file);
+
+		/** Snapshots of a binary replay are only read from the file
+		  * when they're first needed. This reads the savestate and the
+		  * delta blocks (if not done yet).
+		  * @throws MSXException */
+		void load();
+
 		EmuTime time;
 		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
 		MemBuffer<uint8_t> savestate;
 		size_t size;
 
+		// When set, 'savestate' is empty and is stored in this file.
+		std::shared_ptr<SpillFile> spillFile;
+		SpillFile::Location spillLoc;
+
+		// When set, 'savestate' and 'deltaBlocks' are empty and still
+		// need to be read from this replay file (see load()).
+		std::shared_ptr<BinaryReplayReader> replayFile;
+		size_t replaySnapshot; // index in replayFile->getSnapshots()
+
 		// Number of recorded events (or replay index) when this
 		// snapshot was created. So when going back replay should
 		// start at this index.
@@ -73,10 +104,12 @@ private:
 		void swap(ReverseHistory& other) noexcept;
 		void clear();
 		[[nodiscard]] unsigned getNextSeqNum(EmuTime::param time) const;
+		[[nodiscard]] size_t getMemoryUsage() const;
 
 		Chunks chunks;
 		Events events;
 		LastDeltaBlocks lastDeltaBlocks;
+		std::shared_ptr<SpillFile> spillFile; // created on first use
 	};
 
 	[[nodiscard]] bool isCollecting() const { return collecting; }
@@ -91,6 +124,12 @@ private:
 	                span<const TclObject> tokens, TclObject& result);
 	void loadReplay(Interpreter& interp,
 	                span<const TclObject> tokens, TclObject& result);
+	void saveXmlReplay(const std::string& filename,
+	                   span<const Chunks::iterator> snapshots);
+	void saveBinaryReplay(const std::string& filename,
+	                      span<const Chunks::iterator> snapshots);
+	void loadBinaryReplay(const std::string& filename, ReverseHistory& newHistory,
+	                      EmuTime& currentTime, unsigned& newReRecordCount);
 
 	void signalStopReplay(EmuTime::param time);
 	[[nodiscard]] EmuTime::param getEndTime(const ReverseHistory& history) const;
@@ -104,6 +143,8 @@ private:
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
+	void dropSnapshotsForMemoryLimit(EmuTime::param time);
+	void spillOldSnapshots(EmuTime::param time);
 
 	// Schedulable
 	struct SyncNewSnapshot final : Schedulable {
@@ -1,6 +1,13 @@
 #include "Schedulable.hh"
 #include "Scheduler.hh"
+#include "StringOp.hh"
+#include "hash_map.hh"
+#include <cstdlib>
 #include <iostream>
+#include <typeindex>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
 
 namespace openmsx {
 
@@ -20,6 +27,36 @@ void Schedulable::schedulerDeleted()
 	          << "\" failed to unregister.\n";
 }
 
+// Human readable name of a type, e.g. "VDP::SyncVSync".
+[[nodiscard]] static std::string getTypeName(const std::type_info& type)
+{
+	std::string result = type.name();
+#if defined(__GNUC__)
+	int status;
+	if (char* demangled = abi::__cxa_demangle(result.c_str(), nullptr, nullptr, &status)) {
+		result = demangled;
+		free(demangled);
+	}
+#endif
+	// msvc adds "class " or "struct "
+	for (std::string_view prefix : {"class ", "struct ", "openmsx::"}) {
+		if (StringOp::startsWith(result, prefix)) {
+			result.erase(0, prefix.size());
+		}
+	}
+	return result;
+}
+
+std::string Schedulable::getProfileName() const
+{
+	// Demangling is slow, and this is called for each executed syncpoint
+	// while profiling.
+	static hash_map<std::type_index, std::string> cache;
+	auto& name = cache[std::type_index(typeid(*this))];
+	if (name.empty()) name = getTypeName(typeid(*this));
+	return name;
+}
+
 void Schedulable::setSyncPoint(EmuTime::param timestamp)
 {
 	scheduler.setSyncPoint(timestamp, *this);
@@ -6,6 +6,7 @@
 #include "serialize_meta.hh"
 #include "serialize_stl.hh"
 #include <cassert>
+#include <string>
 #include <vector>
 
 namespace openmsx {
@@ -55,6 +56,13 @@ public:
 	 */
 	virtual void schedulerDeleted();
 
+	/** Name used by 'debug scheduler_stats'. The default implementation
+	  * returns the name of the (most derived) type, e.g. "VDP::SyncVSync".
+	  * Schedulables of which a machine can contain several instances
+	  * should also include the name of the device they belong to.
+	  */
+	[[nodiscard]] virtual std::string getProfileName() const;
+
 	[[nodiscard]] Scheduler& getScheduler() const { return scheduler; }
 
 	/** Convenience method:
@@ -98,7 +106,10 @@ protected:
 	[[nodiscard]] bool pendingSyncPoint(EmuTime& result) const;
 
 private:
+	friend class Scheduler;
+
 	Scheduler& scheduler;
+	std::vector<unsigned> syncPointHandles; // see Scheduler
 };
 REGISTER_BASE_CLASS(Schedulable, "Schedulable");
 
@@ -5,27 +5,21 @@
 #include "ranges.hh"
 #include "serialize.hh"
 #include "stl.hh"
+#include "view.hh"
+#include <algorithm>
 #include <cassert>
-#include <iterator> // for back_inserter
+#include <chrono>
 
 namespace openmsx {
 
-struct EqualSchedulable {
-	explicit EqualSchedulable(const Schedulable& schedulable_)
-		: schedulable(schedulable_) {}
-	[[nodiscard]] bool operator()(const SynchronizationPoint& sp) const {
-		return sp.getDevice() == &schedulable;
-	}
-	const Schedulable& schedulable;
-};
-
-
 Scheduler::~Scheduler()
 {
 	assert(!cpu);
-	auto copy = to_vector(queue);
-	for (auto& s : copy) {
-		s.getDevice()->schedulerDeleted();
+	auto copy = to_vector(view::transform(queue, [](const auto& e) {
+		return e.value.getDevice();
+	}));
+	for (auto* device : copy) {
+		device->schedulerDeleted();
 	}
 
 	assert(queue.empty());
@@ -37,10 +31,8 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
-	queue.insert(SynchronizationPoint(time, &device),
-	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity()); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	device.syncPointHandles.push_back(
+		queue.insert(SynchronizationPoint(time, &device)));
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -52,33 +44,45 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 
 Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 {
-	SyncPoints result;
-	ranges::copy_if(queue, back_inserter(result), EqualSchedulable(device));
-	return result;
+	// in the order they will be executed
+	auto handles = device.syncPointHandles;
+	ranges::sort(handles, [&](auto x, auto y) { return queue.before(x, y); });
+	return to_vector(view::transform(handles,
+		[&](auto h) { return queue[h]; }));
 }
 
 bool Scheduler::removeSyncPoint(Schedulable& device)
 {
 	assert(Thread::isMainThread());
-	return queue.remove(EqualSchedulable(device));
+	auto& handles = device.syncPointHandles;
+	if (handles.empty()) return false;
+	// Remove the one that would be executed first (the same one as the
+	// old SchedulerQueue based implementation removed). Some devices
+	// rely on this, and it must not change for replay compatibility.
+	auto it = std::min_element(begin(handles), end(handles),
+		[&](auto x, auto y) { return queue.before(x, y); });
+	queue.remove(*it);
+	move_pop_back(handles, it);
+	return true;
 }
 
 void Scheduler::removeSyncPoints(Schedulable& device)
 {
 	assert(Thread::isMainThread());
-	queue.remove_all(EqualSchedulable(device));
+	for (auto h : device.syncPointHandles) {
+		queue.remove(h);
+	}
+	device.syncPointHandles.clear();
 }
 
 bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
 	assert(Thread::isMainThread());
-	if (auto it = ranges::find(queue, &device, &SynchronizationPoint::getDevice);
-	    it != std::end(queue)) {
-		result = it->getTime();
-		return true;
-	}
-	return false;
+	const auto& handles = device.syncPointHandles;
+	if (handles.empty()) return false;
+	result = min_value(handles, [&](auto h) { return queue[h].getTime(); });
+	return true;
 }
 
 EmuTime::param Scheduler::getCurrentTime() const
@@ -95,12 +99,17 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 		assert(scheduleTime <= next);
 		scheduleTime = next;
 
-		const auto& sp = queue.front();
-		auto* device = sp.getDevice();
-
+		auto* device = queue.front().getDevice();
+		auto handle = queue.front_handle();
 		queue.remove_front();
+		auto& handles = device->syncPointHandles;
+		move_pop_back(handles, rfind_unguarded(handles, handle));
 
-		device->executeUntil(next);
+		if (likely(!profile || !profile->isEnabled())) {
+			device->executeUntil(next);
+		} else {
+			executeProfiled(*device, next);
+		}
 
 		next = getNext();
 		if (likely(next > limit)) break;
@@ -110,6 +119,37 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 	cpu->setNextSyncPoint(next);
 }
 
+void Scheduler::executeProfiled(Schedulable& device, EmuTime::param time)
+{
+	// Determine the name upfront, executeUntil() may delete the device
+	// (e.g. AfterCommand does this).
+	auto name = device.getProfileName();
+	auto start = std::chrono::steady_clock::now();
+	device.executeUntil(time);
+	auto stop = std::chrono::steady_clock::now();
+	profile->add(name, std::chrono::duration_cast<std::chrono::nanoseconds>(
+		stop - start).count());
+}
+
+
+// class SchedulerProfile
+
+void SchedulerProfile::add(std::string_view name, uint64_t hostTime)
+{
+	auto& entry = entries[name];
+	++entry.count;
+	entry.hostTime += hostTime;
+}
+
+std::vector<std::pair<std::string, SchedulerProfile::Entry>> SchedulerProfile::getSorted() const
+{
+	auto result = to_vector<std::pair<std::string, Entry>>(entries);
+	ranges::sort(result, [](const auto& x, const auto& y) {
+		return x.second.hostTime > y.second.hostTime;
+	});
+	return result;
+}
+
 
 template<typename Archive>
 void SynchronizationPoint::serialize(Archive& ar, unsigned /*version*/)
@@ -2,8 +2,14 @@
 #define SCHEDULER_HH
 
 #include "EmuTime.hh"
-#include "SchedulerQueue.hh"
+#include "SchedulerHeap.hh"
+#include "hash_map.hh"
 #include "likely.hh"
+#include "xxhash.hh"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
@@ -11,6 +17,36 @@ namespace openmsx {
 class Schedulable;
 class MSXCPU;
 
+/** Data collected by 'debug scheduler_stats': the number of executed
+  * syncpoints and the host time spent in Schedulable::executeUntil(), per
+  * Schedulable (see Schedulable::getProfileName()).
+  * Owned by the Reactor instead of by the Scheduler, so that it survives
+  * switching machines, reverse and loading savestates (those all replace
+  * the MSXMotherBoard, and thus its Scheduler).
+  */
+class SchedulerProfile
+{
+public:
+	struct Entry {
+		uint64_t count = 0;
+		uint64_t hostTime = 0; // in ns
+	};
+
+	/** Profiling slows down scheduling a bit, so it's disabled by default. */
+	void setEnabled(bool enabled_) { enabled = enabled_; }
+	[[nodiscard]] bool isEnabled() const { return enabled; }
+
+	void add(std::string_view name, uint64_t hostTime);
+	void reset() { entries.clear(); }
+
+	/** The collected data, sorted on decreasing host time. */
+	[[nodiscard]] std::vector<std::pair<std::string, Entry>> getSorted() const;
+
+private:
+	hash_map<std::string, Entry, XXHasher> entries;
+	bool enabled = false;
+};
+
 class SynchronizationPoint
 {
 public:
@@ -29,13 +65,23 @@ private:
 	Schedulable* device = nullptr;
 };
 
+struct LessSyncPoint {
+	[[nodiscard]] bool operator()(const SynchronizationPoint& x,
+	                              const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
 
 class Scheduler
 {
 public:
 	using SyncPoints = std::vector<SynchronizationPoint>;
+	using Queue = SchedulerHeap<SynchronizationPoint, LessSyncPoint>;
 
-	Scheduler() = default;
+	/** @param profile Where to collect the profiling data, can be nullptr. */
+	explicit Scheduler(SchedulerProfile* profile_ = nullptr)
+		: profile(profile_) {}
 	~Scheduler();
 
 	void setCPU(MSXCPU* cpu_)
@@ -51,9 +97,10 @@ public:
 	/**
 	 * TODO
 	 */
-	[[nodiscard]] inline EmuTime::param getNext() const
+	[[nodiscard]] inline EmuTime getNext() const
 	{
-		return queue.front().getTime();
+		return likely(!queue.empty()) ? queue.front().getTime()
+		                              : EmuTime::infinity();
 	}
 
 	/**
@@ -90,8 +137,7 @@ private: // -> intended for Schedulable
 	/**
 	 * Removes a syncPoint of a given device.
 	 * If there is more than one match only one will be removed,
-	 * there is no guarantee that the earliest syncPoint is
-	 * removed.
+	 * the one that would be executed first.
 	 * Returns false <=> if there was no match (so nothing removed)
 	 */
 	bool removeSyncPoint(Schedulable& device);
@@ -107,15 +153,17 @@ private: // -> intended for Schedulable
 
 private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
+	void executeProfiled(Schedulable& device, EmuTime::param time);
 
 private:
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	/** Each Schedulable keeps the handles of its own syncpoints, so
+	  * removing a syncpoint doesn't require a search in the queue.
 	  */
-	SchedulerQueue<SynchronizationPoint> queue;
+	Queue queue;
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
+	SchedulerProfile* profile;
 };
 
 } // namespace openmsx
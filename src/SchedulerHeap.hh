@@ -0,0 +1,155 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+// Priority queue (binary min-heap stored in a flat vector) where each element
+// gets a handle when it's inserted. Via that handle the element can later be
+// looked up in O(1) and be removed in O(log N). SchedulerQueue instead needs
+// a linear search to find the element to remove.
+//
+// Like in SchedulerQueue, two elements that are equivalent according to LESS
+// keep their relative order (in a plain heap that's not the case): newly
+// inserted elements come after existing equivalent elements.
+//
+// Handles of removed elements are reused for later insertions.
+template<typename T, typename LESS> class SchedulerHeap
+{
+public:
+	using Handle = unsigned;
+
+	struct Entry {
+		T value;
+		uint64_t seq; // insertion order, to break ties
+		Handle handle;
+	};
+
+	[[nodiscard]] size_t size()  const { return heap.size(); }
+	[[nodiscard]] bool   empty() const { return heap.empty(); }
+
+	// Returns reference to the smallest element.
+	[[nodiscard]] const T& front() const { assert(!empty()); return heap.front().value; }
+	[[nodiscard]] Handle front_handle() const { assert(!empty()); return heap.front().handle; }
+
+	[[nodiscard]] const T& operator[](Handle h) const
+	{
+		assert(h < positions.size());
+		return heap[positions[h]].value;
+	}
+
+	// Does the element with handle 'x' come before the one with handle 'y'?
+	// That is the same order in which remove_front() would remove them.
+	[[nodiscard]] bool before(Handle x, Handle y) const
+	{
+		assert(x < positions.size());
+		assert(y < positions.size());
+		return less(heap[positions[x]], heap[positions[y]]);
+	}
+
+	// Iterate over all elements (in no particular order).
+	[[nodiscard]] const Entry* begin() const { return heap.data(); }
+	[[nodiscard]] const Entry* end()   const { return heap.data() + heap.size(); }
+
+	// Insert a new element, returns the handle for that element.
+	Handle insert(const T& t)
+	{
+		Handle h;
+		if (freeHandles.empty()) {
+			h = Handle(positions.size());
+			positions.push_back(0);
+		} else {
+			h = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		heap.push_back(Entry{t, counter++, h});
+		siftUp(heap.size() - 1);
+		return h;
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		remove(front_handle());
+	}
+
+	// Remove the element with the given handle.
+	void remove(Handle h)
+	{
+		assert(h < positions.size());
+		size_t pos = positions[h];
+		assert(heap[pos].handle == h);
+		freeHandles.push_back(h);
+
+		size_t last = heap.size() - 1;
+		if (pos != last) {
+			heap[pos] = heap[last];
+			heap.pop_back();
+			if ((pos != 0) && less(heap[pos], heap[(pos - 1) / 2])) {
+				siftUp(pos);
+			} else {
+				siftDown(pos);
+			}
+		} else {
+			heap.pop_back();
+		}
+	}
+
+private:
+	[[nodiscard]] static bool less(const Entry& x, const Entry& y)
+	{
+		LESS l;
+		if (l(x.value, y.value)) return true;
+		if (l(y.value, x.value)) return false;
+		return x.seq < y.seq;
+	}
+
+	void siftUp(size_t pos)
+	{
+		Entry e = heap[pos];
+		while (pos != 0) {
+			size_t parent = (pos - 1) / 2;
+			if (!less(e, heap[parent])) break;
+			place(pos, heap[parent]);
+			pos = parent;
+		}
+		place(pos, e);
+	}
+
+	void siftDown(size_t pos)
+	{
+		Entry e = heap[pos];
+		size_t n = heap.size();
+		while (true) {
+			size_t child = 2 * pos + 1;
+			if (child >= n) break;
+			if (((child + 1) < n) && less(heap[child + 1], heap[child])) {
+				++child;
+			}
+			if (!less(heap[child], e)) break;
+			place(pos, heap[child]);
+			pos = child;
+		}
+		place(pos, e);
+	}
+
+	void place(size_t pos, const Entry& e)
+	{
+		heap[pos] = e;
+		positions[e.handle] = unsigned(pos);
+	}
+
+private:
+	std::vector<Entry> heap;
+	std::vector<unsigned> positions; // indexed by handle, position in 'heap'
+	std::vector<Handle> freeHandles;
+	uint64_t counter = 0;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
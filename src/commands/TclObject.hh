@@ -216,6 +216,9 @@ private:
 	[[nodiscard]] static Tcl_Obj* newObj(unsigned u) {
 		return Tcl_NewIntObj(u);
 	}
+	[[nodiscard]] static Tcl_Obj* newObj(uint64_t u) {
+		return Tcl_NewWideIntObj(Tcl_WideInt(u));
+	}
 	[[nodiscard]] static Tcl_Obj* newObj(float f) {
 		return Tcl_NewDoubleObj(double(f));
 	}
@@ -5,13 +5,15 @@
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            MSXMotherBoard& motherBoard) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
 	try {
+		if (compiled) return compiled->evalBool(motherBoard);
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
 		cliComm.printWarning(e.getMessage());
@@ -19,14 +21,25 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+bool BreakPointBase::mightTrigger(MSXMotherBoard& motherBoard) const
+{
+	if (!compiled) return true;
+	try {
+		return compiled->evalBool(motherBoard);
+	} catch (CommandException&) {
+		return true; // let checkAndExecute() report the error
+	}
+}
+
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     MSXMotherBoard& motherBoard)
 {
 	if (executing) {
 		// no recursive execution
 		return;
 	}
 	ScopedAssign sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	if (isTrue(cliComm, interp, motherBoard)) {
 		try {
 			command.executeCommand(interp, true); // compile command
 		} catch (CommandException& e) {
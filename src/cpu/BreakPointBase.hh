@@ -1,13 +1,16 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
+#include <memory>
 #include <string_view>
 
 namespace openmsx {
 
 class Interpreter;
 class GlobalCliComm;
+class MSXMotherBoard;
 
 /** Base class for CPU break and watch points.
  */
@@ -20,7 +23,13 @@ public:
 	[[nodiscard]] TclObject getCommandObj()   const { return command; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     MSXMotherBoard& motherBoard);
+
+	/** Quick check (without Tcl) whether checkAndExecute() could trigger.
+	  * Only returns false for compiled conditions that evaluate to false.
+	  */
+	[[nodiscard]] bool mightTrigger(MSXMotherBoard& motherBoard) const;
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -29,14 +38,19 @@ protected:
 	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
 		: command(std::move(command_))
 		, condition(std::move(condition_))
+		, compiled(condition.getString().empty()
+		           ? nullptr
+		           : CompiledCondition::compile(condition.getString()))
 		, once(once_) {}
 
 private:
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          MSXMotherBoard& motherBoard) const;
 
 private:
 	TclObject command;
 	TclObject condition;
+	std::shared_ptr<const CompiledCondition> compiled; // nullptr if not compilable
 	bool once;
 	bool executing = false;
 };
@@ -38,6 +38,11 @@ protected:
 		return clock.getFastAdd(limit - remaining + cc);
 	}
 	void setTime(EmuTime::param time) { sync(); clock.reset(time); }
+	/** Total number of cycles, only meaningful to measure the duration
+	  * of (a sequence of) instructions, e.g. for profiling. */
+	[[nodiscard]] uint64_t getTotalTicks() const {
+		return clock.getTotalTicks() + (limit - remaining);
+	}
 	void setFreq(unsigned freq) { clock.setFreq(freq); }
 	void advanceTime(EmuTime::param time);
 	[[nodiscard]] EmuTime calcTime(EmuTime::param time, unsigned ticks) const {
@@ -16,6 +16,8 @@
 namespace openmsx {
 
 class MSXCPUInterface;
+class CPUProfiler;
+class InstructionTrace;
 class Scheduler;
 class MSXMotherBoard;
 class TclCallback;
@@ -55,7 +57,8 @@ class CPUCore final : public CPUBase, public CPURegs, public CPU_POLICY
 {
 public:
 	CPUCore(MSXMotherBoard& motherboard, const std::string& name,
-	        const BooleanSetting& traceSetting,
+	        const BooleanSetting& traceSetting, CPUProfiler& profiler,
+	        InstructionTrace& instructionTrace,
 	        TclCallback& diHaltCallback, EmuTime::param time);
 
 	void setInterface(MSXCPUInterface* interf) { interface = interf; }
@@ -144,6 +147,8 @@ private:
 	MSXCPUInterface* interface;
 
 	const BooleanSetting& traceSetting;
+	CPUProfiler& profiler;
+	InstructionTrace& instructionTrace;
 	TclCallback& diHaltCallback;
 
 	Probe<int> IRQStatus;
@@ -170,6 +175,16 @@ private:
 	/** In sync with traceSetting.getBoolean(). */
 	bool tracingEnabled;
 
+	/** Start of the current instruction, only used while profiling. */
+	uint64_t profileStartTicks;
+	int profileStartSlot;
+
+	/** Start of the current instruction, only used by the instruction trace. */
+	uint64_t traceStartTime;
+	/** Opcode bytes of the current instruction, read before it's executed
+	  * (it can modify itself, or switch the slot/mapper of its own page). */
+	byte traceOpcode[4];
+
 	/** 'normal' Z80 and Z80 in a turboR behave slightly different */
 	const bool isTurboR;
 
@@ -177,6 +192,8 @@ private:
 	inline void cpuTracePre();
 	inline void cpuTracePost();
 	void cpuTracePost_slow();
+	void peekOpcode(unsigned address, byte opcode[4]) const;
+	void instructionTracePost();
 
 	inline byte READ_PORT(unsigned port, unsigned cc);
 	inline void WRITE_PORT(unsigned port, byte value, unsigned cc);
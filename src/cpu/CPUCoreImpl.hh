@@ -1,3 +1,15 @@
+#ifndef CPUCOREIMPL_HH
+#define CPUCOREIMPL_HH
+
+// The implementation of the CPUCore class template. This file is only
+// included from CPUCoreZ80.cc and CPUCoreR800.cc, those each instantiate
+// CPUCore for one CPU type. Compiling executeInstructions() (the main
+// emulation loop, with all instructions inlined) is expensive. This split
+// only helps a little: the R800 instantiation alone still takes about as
+// long as both together, and needs about 10% less memory (see below). A
+// finer split (e.g. per opcode group) is not possible, because all opcode
+// routines must be part of the same function for the computed goto's.
+
 // MEMORY EMULATION
 // ----------------
 //
@@ -159,6 +171,8 @@
 // instructions too late.
 
 #include "CPUCore.hh"
+#include "CPUProfiler.hh"
+#include "InstructionTrace.hh"
 #include "MSXCPUInterface.hh"
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
@@ -173,28 +187,39 @@
 #include "inline.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <iostream>
 #include <type_traits>
 #include <cassert>
 
 
 //
-// #define USE_COMPUTED_GOTO
+// USE_COMPUTED_GOTO
 //
-// Computed goto's are not enabled by default:
-// - Computed goto's are a gcc extension, it's not part of the official c++
-//   standard. So this will only work if you use gcc as your compiler (it
-//   won't work with visual c++ for example)
-// - This is only beneficial on CPUs with branch prediction for indirect jumps
-//   and a reasonable amount of cache. For example it is very benefical for a
-//   intel core2 cpu (10% faster), but not for a ARM920 (a few percent slower)
-// - Compiling src/cpu/CPUCore.cc with computed goto's enabled is very demanding
-//   on the compiler. On older gcc versions it requires up to 1.5GB of memory.
-//   But even on more recent gcc versions it still requires around 700MB.
+// The main emulation loop can either dispatch the instructions via a switch
+// statement or via computed goto's. With computed goto's there's one
+// indirect jump per instruction at the end of each opcode routine, which is
+// easier to predict than the one shared jump of the switch. They're used by
+// default on x86 when the compiler supports them:
+// - Computed goto's are a gcc extension (also supported by clang), it's not
+//   part of the official c++ standard. It won't work with visual c++.
+// - It's only beneficial on CPUs with branch prediction for indirect jumps
+//   and a reasonable amount of cache. For example it is very beneficial for
+//   an intel core2 cpu (10% faster), but not for an ARM920 (a few percent
+//   slower). On other architectures pass the -DUSE_COMPUTED_GOTO flag to the
+//   compiler to enable it, on x86 -DNO_COMPUTED_GOTO disables it.
+// - Compiling with computed goto's is demanding for the compiler. Measured
+//   with gcc-12 (-O3), time and peak memory:
+//     both instantiations in one file:  45s / 871MB
+//     Z80 instantiation:                18s / 500MB
+//     R800 instantiation:               48s / 783MB
+//   (with the switch statement, both together: 21s / 524MB)
 //
-// Probably the easiest way to enable this, is to pass the -DUSE_COMPUTED_GOTO
-// flag to the compiler. This is for example done in the super-opt flavour.
-// See build/flavour-super-opt.mk
+// Use the 'cpu_benchmark' script command to measure the emulation speed.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(NO_COMPUTED_GOTO) && !defined(USE_COMPUTED_GOTO)
+#define USE_COMPUTED_GOTO
+#endif
 
 
 using std::string;
@@ -281,7 +306,8 @@ struct CondTrue { bool operator()(byte /*f*/) const { return true; } };
 
 template<typename T> CPUCore<T>::CPUCore(
 		MSXMotherBoard& motherboard_, const string& name,
-		const BooleanSetting& traceSetting_,
+		const BooleanSetting& traceSetting_, CPUProfiler& profiler_,
+		InstructionTrace& instructionTrace_,
 		TclCallback& diHaltCallback_, EmuTime::param time)
 	: CPURegs(T::IS_R800)
 	, T(time, motherboard_.getScheduler())
@@ -289,6 +315,8 @@ template<typename T> CPUCore<T>::CPUCore(
 	, scheduler(motherboard.getScheduler())
 	, interface(nullptr)
 	, traceSetting(traceSetting_)
+	, profiler(profiler_)
+	, instructionTrace(instructionTrace_)
 	, diHaltCallback(diHaltCallback_)
 	, IRQStatus(motherboard.getDebugger(), name + ".pendingIRQ",
 	            "Non-zero if there are pending IRQs (thus CPU would enter "
@@ -311,6 +339,9 @@ template<typename T> CPUCore<T>::CPUCore(
 	, nmiEdge(false)
 	, exitLoop(false)
 	, tracingEnabled(traceSetting.getBoolean())
+	, profileStartTicks(0)
+	, profileStartSlot(0)
+	, traceStartTime(0)
 	, isTurboR(motherboard.isTurboR())
 {
 	static_assert(!std::is_polymorphic_v<CPUCore<T>>,
@@ -513,9 +544,9 @@ template<typename T> void CPUCore<T>::disasmCommand(
 {
 	word address = (tokens.size() < 3) ? getPC() : tokens[2].getInt(interp);
 	byte outBuf[4];
+	peekOpcode(address, outBuf);
 	std::string dasmOutput;
-	unsigned len = dasm(*interface, address, outBuf, dasmOutput,
-	               T::getTimeFast());
+	unsigned len = dasm(outBuf, address, dasmOutput);
 	result.addListElement(dasmOutput);
 	char tmp[3]; tmp[2] = 0;
 	for (auto i : xrange(len)) {
@@ -2436,18 +2467,36 @@ xx_cb: {
 template<typename T> inline void CPUCore<T>::cpuTracePre()
 {
 	start_pc = getPC();
+	if (unlikely(instructionTrace.isEnabled())) {
+		traceStartTime = (T::getTimeFast() - EmuTime::zero()).length();
+		peekOpcode(start_pc, traceOpcode);
+	}
+	if (unlikely(profiler.isEnabled())) {
+		profileStartTicks = T::getTotalTicks();
+		profileStartSlot = profiler.getSlot(start_pc);
+	}
 }
 template<typename T> inline void CPUCore<T>::cpuTracePost()
 {
 	if (unlikely(tracingEnabled)) {
 		cpuTracePost_slow();
 	}
+	if (unlikely(instructionTrace.isEnabled())) {
+		instructionTracePost();
+	}
+	if (unlikely(profiler.isEnabled())) {
+		// (total ticks can jump backwards on a frequency switch)
+		auto ticks = T::getTotalTicks();
+		profiler.record(profileStartSlot, start_pc,
+		                (ticks > profileStartTicks) ? (ticks - profileStartTicks) : 0);
+	}
 }
 template<typename T> void CPUCore<T>::cpuTracePost_slow()
 {
 	byte opBuf[4];
+	peekOpcode(start_pc, opBuf);
 	string dasmOutput;
-	dasm(*interface, start_pc, opBuf, dasmOutput, T::getTimeFast());
+	dasm(opBuf, start_pc, dasmOutput);
 	std::cout << strCat(hex_string<4>(start_pc),
 	                    " : ", dasmOutput,
 	                    " AF=", hex_string<4>(getAF()),
@@ -2461,6 +2510,30 @@ template<typename T> void CPUCore<T>::cpuTracePost_slow()
 	          << std::flush;
 }
 
+template<typename T> void CPUCore<T>::peekOpcode(unsigned address, byte opcode[4]) const
+{
+	const byte* line = readCacheLine[address >> CacheLine::BITS];
+	if ((uintptr_t(line) > 1) && ((address & CacheLine::LOW) <= (CacheLine::SIZE - 4))) {
+		// common case: plain memory, no need to go via the device
+		std::copy_n(&line[address], 4, opcode);
+	} else {
+		auto time = T::getTimeFast();
+		for (auto i : xrange(4)) {
+			opcode[i] = interface->peekMem(word(address + i), time);
+		}
+	}
+}
+template<typename T> void CPUCore<T>::instructionTracePost()
+{
+	auto& r = instructionTrace.next();
+	r.time = traceStartTime;
+	r.pc = start_pc;
+	r.af = getAF(); r.bc = getBC(); r.de = getDE(); r.hl = getHL();
+	r.ix = getIX(); r.iy = getIY(); r.sp = getSP();
+	std::copy_n(traceOpcode, 4, r.opcode);
+	instructionTrace.commit();
+}
+
 template<typename T> ExecIRQ CPUCore<T>::getExecIRQ() const
 {
 	if (unlikely(nmiEdge)) return ExecIRQ::NMI;
@@ -2561,8 +2634,9 @@ template<typename T> void CPUCore<T>::execute2(bool fastForward)
 	// deciding between executeFast() and executeSlow() (because a
 	// SyncPoint could set an IRQ and then we must choose executeSlow())
 	if (fastForward ||
-	    (!interface->anyBreakPoints() && !tracingEnabled)) {
-		// fast path, no breakpoints, no tracing
+	    (!interface->anyBreakPoints() && !tracingEnabled &&
+	     !profiler.isEnabled() && !instructionTrace.isEnabled())) {
+		// fast path, no breakpoints, no tracing, no profiling
 		do {
 			if (slowInstructions) {
 				--slowInstructions;
@@ -4425,11 +4499,6 @@ void CPUCore<T>::serialize(Archive& ar, unsigned version)
 	}
 }
 
-// Force template instantiation
-template class CPUCore<Z80TYPE>;
-template class CPUCore<R800TYPE>;
-
-INSTANTIATE_SERIALIZE_METHODS(CPUCore<Z80TYPE>);
-INSTANTIATE_SERIALIZE_METHODS(CPUCore<R800TYPE>);
-
 } // namespace openmsx
+
+#endif
@@ -0,0 +1,10 @@
+// Instantiation of CPUCore for the R800, see CPUCoreImpl.hh.
+
+#include "CPUCoreImpl.hh"
+
+namespace openmsx {
+
+template class CPUCore<R800TYPE>;
+INSTANTIATE_SERIALIZE_METHODS(CPUCore<R800TYPE>);
+
+} // namespace openmsx
@@ -0,0 +1,10 @@
+// Instantiation of CPUCore for the Z80, see CPUCoreImpl.hh.
+
+#include "CPUCoreImpl.hh"
+
+namespace openmsx {
+
+template class CPUCore<Z80TYPE>;
+INSTANTIATE_SERIALIZE_METHODS(CPUCore<Z80TYPE>);
+
+} // namespace openmsx
@@ -0,0 +1,56 @@
+#include "CPUProfiler.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <fstream>
+#include <ostream>
+
+namespace openmsx {
+
+void CPUProfiler::reset()
+{
+	for (auto& t : tables) t.reset();
+}
+
+std::vector<CPUProfiler::Result> CPUProfiler::getResults() const
+{
+	std::vector<Result> result;
+	for (auto slot : xrange(16)) {
+		const auto& table = tables[slot];
+		if (!table) continue;
+		for (auto address : xrange(0x10000u)) {
+			const auto& e = (*table)[address];
+			if (e.count) result.push_back({slot, address, e});
+		}
+	}
+	ranges::stable_sort(result, [](const Result& x, const Result& y) {
+		return x.entry.cycles > y.entry.cycles;
+	});
+	return result;
+}
+
+void CPUProfiler::writeFolded(std::ostream& os) const
+{
+	for (const auto& r : getResults()) {
+		os << strCat("slot ", r.slot / 4, '-', r.slot % 4,
+		             ";0x", hex_string<4>(r.address),
+		             ' ', r.entry.cycles, '\n');
+	}
+}
+
+void CPUProfiler::saveFolded(const std::string& filename) const
+{
+	std::ofstream file;
+	FileOperations::openofstream(file, filename);
+	if (!file.is_open()) {
+		throw FileException("Couldn't open file for writing: ", filename);
+	}
+	writeFolded(file);
+	if (!file) {
+		throw FileException("Error while writing file: ", filename);
+	}
+}
+
+} // namespace openmsx
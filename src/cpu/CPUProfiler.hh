@@ -0,0 +1,83 @@
+#ifndef CPUPROFILER_HH
+#define CPUPROFILER_HH
+
+#include "openmsx.hh"
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Collects per address statistics of the executed Z80/R800 instructions:
+  * how many times each instruction was executed and how many CPU cycles
+  * (T-states) were spent in it. Addresses are kept separately per slot, so
+  * e.g. code in page 1 of a ROM cartridge is distinguished from code at
+  * the same address in RAM.
+  *
+  * When profiling is enabled CPUCore executes instructions one by one (like
+  * it already does for tracing or when there are breakpoints). So when it's
+  * disabled the profiler has no cost in the emulation loop.
+  */
+class CPUProfiler
+{
+public:
+	struct Entry {
+		uint64_t count = 0;  // number of executions
+		uint64_t cycles = 0; // total number of T-states
+	};
+	struct Result {
+		int slot; // 4 * primary + secondary slot
+		unsigned address;
+		Entry entry;
+	};
+
+	void setEnabled(bool enabled_) { enabled = enabled_; }
+	[[nodiscard]] bool isEnabled() const { return enabled; }
+
+	/** Discard all collected data. */
+	void reset();
+
+	/** Keep track of the active slot per page, see MSXCPU. */
+	void updateVisiblePage(byte page, byte slot) { slots[page] = slot; }
+
+	/** Slot that's currently visible at the given address. */
+	[[nodiscard]] int getSlot(unsigned address) const {
+		return slots[(address >> 14) & 3];
+	}
+
+	/** Account one execution of the instruction at the given slot and
+	  * address that took the given number of cycles. */
+	void record(int slot, unsigned address, uint64_t cycles) {
+		auto& table = tables[slot];
+		if (!table) table = std::make_unique<Table>();
+		auto& e = (*table)[address & 0xFFFF];
+		++e.count;
+		e.cycles += cycles;
+	}
+
+	/** All addresses that have been executed, sorted on decreasing number
+	  * of cycles. */
+	[[nodiscard]] std::vector<Result> getResults() const;
+
+	/** Write the results in the 'folded stacks' format, the input format
+	  * of flame graph tools (e.g. flamegraph.pl or speedscope). Each line
+	  * has the form "slot 1-2;0x4010 1234" (the number is in T-states). */
+	void writeFolded(std::ostream& os) const;
+
+	/** Same as above, but write to the given file.
+	  * @throws FileException */
+	void saveFolded(const std::string& filename) const;
+
+private:
+	using Table = std::array<Entry, 0x10000>;
+	std::array<std::unique_ptr<Table>, 16> tables; // allocated on first use
+	byte slots[4] = {0, 0, 0, 0}; // active slot per page (4 * primary + secondary)
+	bool enabled = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,78 @@
+#include "InstructionTrace.hh"
+#include "EmuDuration.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "ranges.hh"
+#include <cassert>
+#include <fstream>
+#include <new>
+
+namespace openmsx {
+
+void InstructionTrace::start(size_t size)
+{
+	assert(size != 0);
+	assert(size <= MAX_SIZE);
+	if (size != buffer.size()) {
+		// Free the old buffer first, but when allocating the new one
+		// fails, keep a valid (small) buffer.
+		buffer.clear();
+		buffer.shrink_to_fit();
+		try {
+			buffer.resize(size);
+		} catch (std::bad_alloc&) {
+			buffer.resize(1);
+			clear();
+			enabled = false;
+			throw MSXException("Not enough memory for an instruction trace of ",
+			                   size, " instructions");
+		}
+		clear();
+	}
+	enabled = true;
+}
+
+void InstructionTrace::clear()
+{
+	pos = 0;
+	total = 0;
+}
+
+std::vector<InstructionTrace::Record> InstructionTrace::getRecords() const
+{
+	std::vector<Record> result;
+	result.reserve(size());
+	if (total > buffer.size()) {
+		// wrapped around, oldest record is at 'pos'
+		result.insert(result.end(), buffer.begin() + pos, buffer.end());
+	}
+	result.insert(result.end(), buffer.begin(), buffer.begin() + pos);
+	return result;
+}
+
+void InstructionTrace::save(const std::string& filename) const
+{
+	std::ofstream file;
+	FileOperations::openofstream(file, filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw FileException("Couldn't open file for writing: ", filename);
+	}
+
+	auto records = getRecords();
+	Header header;
+	ranges::copy(MAGIC, header.magic);
+	header.version = VERSION;
+	header.recordSize = sizeof(Record);
+	header.numRecords = records.size();
+	header.totalRecords = total;
+	header.ticksPerSecond = MAIN_FREQ;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(records.data()),
+	           records.size() * sizeof(Record));
+	if (!file) {
+		throw FileException("Error while writing file: ", filename);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,97 @@
+#ifndef INSTRUCTIONTRACE_HH
+#define INSTRUCTIONTRACE_HH
+
+#include "endian.hh"
+#include "openmsx.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Records the most recently executed Z80/R800 instructions in a fixed size
+  * ring buffer. When the buffer is full, the oldest records are overwritten.
+  * The buffer is allocated once (when recording starts), recording itself
+  * only copies a few bytes, so it can stay enabled for a long time. On
+  * request (e.g. from a breakpoint command) the content is written to a
+  * file, see Contrib/cputrace-reader.cc for a tool to read such a file.
+  *
+  * Only the emulation thread accesses the buffer, so no locking is needed.
+  *
+  * File layout: a Header followed by the records, oldest first. All values
+  * are stored in little endian byte order.
+  */
+class InstructionTrace
+{
+public:
+	struct Header {
+		char magic[8]; // "oMSXtrc" (including zero terminator)
+		Endian::L32 version;
+		Endian::L32 recordSize; // sizeof(Record)
+		Endian::L64 numRecords; // number of records in the file
+		Endian::L64 totalRecords; // number of recorded instructions,
+		                          // larger than numRecords when the
+		                          // ring buffer wrapped around
+		Endian::L64 ticksPerSecond; // unit of 'Record::time'
+	};
+	static constexpr const char MAGIC[8] = "oMSXtrc";
+	static constexpr uint32_t VERSION = 1;
+
+	struct Record {
+		Endian::L64 time; // EmuTime at the start of the instruction
+		Endian::L16 pc;
+		// registers after executing the instruction
+		Endian::L16 af, bc, de, hl, ix, iy, sp;
+		byte opcode[4]; // only the first 'length' bytes belong to the instruction
+		byte reserved[4];
+	};
+	static_assert(sizeof(Header) == 40);
+	static_assert(sizeof(Record) == 32);
+
+	/** Upper limit for the buffer size (in records, 2GB). */
+	static constexpr size_t MAX_SIZE = size_t(1) << 26;
+
+	/** Start recording, (re)allocates the buffer when the size changes.
+	  * @param size Maximum number of records kept in the buffer, at most
+	  *             MAX_SIZE.
+	  * @throws MSXException when the buffer can't be allocated. Then
+	  *         recording is stopped and the old records are gone. */
+	void start(size_t size);
+	void stop() { enabled = false; }
+	[[nodiscard]] bool isEnabled() const { return enabled; }
+
+	/** Discard all records. */
+	void clear();
+
+	[[nodiscard]] size_t capacity() const { return buffer.size(); }
+	/** Number of records currently in the buffer. */
+	[[nodiscard]] size_t size() const {
+		return (total < buffer.size()) ? size_t(total) : buffer.size();
+	}
+	/** Number of instructions recorded since the last clear(). */
+	[[nodiscard]] uint64_t totalRecorded() const { return total; }
+
+	/** Returns the record that should be filled in next. Only after
+	  * commit() it becomes part of the trace. */
+	[[nodiscard]] Record& next() { return buffer[pos]; }
+	void commit() {
+		++total;
+		if (++pos == buffer.size()) pos = 0;
+	}
+
+	/** The records in the buffer, oldest first. */
+	[[nodiscard]] std::vector<Record> getRecords() const;
+
+	/** @throws FileException */
+	void save(const std::string& filename) const;
+
+private:
+	std::vector<Record> buffer;
+	size_t pos = 0; // index in 'buffer' of the next record
+	uint64_t total = 0;
+	bool enabled = false;
+};
+
+} // namespace openmsx
+
+#endif
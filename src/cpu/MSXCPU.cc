@@ -4,6 +4,7 @@
 #include "Debugger.hh"
 #include "Scheduler.hh"
 #include "IntegerSetting.hh"
+#include "MSXException.hh"
 #include "CPUCore.hh"
 #include "Z80.hh"
 #include "R800.hh"
@@ -30,11 +31,11 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 		motherboard.getCommandController(), "di_halt_callback",
 		"Tcl proc called when the CPU executed a DI/HALT sequence")
 	, z80(std::make_unique<CPUCore<Z80TYPE>>(
-		motherboard, "z80", traceSetting,
+		motherboard, "z80", traceSetting, profiler, instructionTrace,
 		diHaltCallback, EmuTime::zero()))
 	, r800(motherboard.isTurboR()
 		? std::make_unique<CPUCore<R800TYPE>>(
-			motherboard, "r800", traceSetting,
+			motherboard, "r800", traceSetting, profiler, instructionTrace,
 			diHaltCallback, EmuTime::zero())
 		: nullptr)
 	, timeInfo(motherboard.getMachineInfoCommand())
@@ -154,6 +155,7 @@ void MSXCPU::setNextSyncPoint(EmuTime::param time)
 void MSXCPU::invalidateMemCacheSlot()
 {
 	ranges::fill(slots, 0);
+	for (auto page : xrange(byte(4))) profiler.updateVisiblePage(page, 0);
 
 	// nullptr: means not a valid entry and not yet attempted to fill this entry
 	for (auto i : xrange(16)) {
@@ -167,6 +169,7 @@ void MSXCPU::updateVisiblePage(byte page, byte primarySlot, byte secondarySlot)
 	byte from = slots[page];
 	byte to = 4 * primarySlot + secondarySlot;
 	slots[page] = to;
+	profiler.updateVisiblePage(page, to);
 
 	auto [cpuReadLines, cpuWriteLines] = z80Active ? z80->getCacheLines() : r800->getCacheLines();
 
@@ -344,6 +347,29 @@ CPURegs& MSXCPU::getRegisters()
 	}
 }
 
+void MSXCPU::setProfiling(bool enabled)
+{
+	profiler.setEnabled(enabled);
+	exitCPULoopSync(); // switch between the fast and slow emulation loop
+}
+
+void MSXCPU::startInstructionTrace(size_t size)
+{
+	try {
+		instructionTrace.start(size);
+	} catch (MSXException&) {
+		exitCPULoopSync(); // recording was stopped
+		throw;
+	}
+	exitCPULoopSync();
+}
+
+void MSXCPU::stopInstructionTrace()
+{
+	instructionTrace.stop();
+	exitCPULoopSync();
+}
+
 void MSXCPU::update(const Setting& setting) noexcept
 {
 	          z80 ->update(setting);
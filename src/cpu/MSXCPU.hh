@@ -1,7 +1,9 @@
 #ifndef MSXCPU_HH
 #define MSXCPU_HH
 
+#include "CPUProfiler.hh"
 #include "InfoTopic.hh"
+#include "InstructionTrace.hh"
 #include "SimpleDebuggable.hh"
 #include "Observer.hh"
 #include "BooleanSetting.hh"
@@ -144,6 +146,16 @@ public:
 
 	[[nodiscard]] CPURegs& getRegisters();
 
+	/** Start/stop collecting per address execution statistics. */
+	void setProfiling(bool enabled);
+	[[nodiscard]] CPUProfiler& getProfiler() { return profiler; }
+
+	/** Start/stop recording the executed instructions, see InstructionTrace.
+	  * @throws MSXException when the buffer can't be allocated. */
+	void startInstructionTrace(size_t size);
+	void stopInstructionTrace();
+	[[nodiscard]] InstructionTrace& getInstructionTrace() { return instructionTrace; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -171,6 +183,8 @@ private:
 private:
 	MSXMotherBoard& motherboard;
 	BooleanSetting traceSetting;
+	CPUProfiler profiler;
+	InstructionTrace instructionTrace;
 	TclCallback diHaltCallback;
 	const std::unique_ptr<CPUCore<Z80TYPE>> z80;
 	const std::unique_ptr<CPUCore<R800TYPE>> r800; // can be nullptr
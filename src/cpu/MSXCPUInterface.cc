@@ -810,6 +810,14 @@ void MSXCPUInterface::checkBreakPoints(
 	          BreakPoints::const_iterator> range,
 	MSXMotherBoard& motherBoard)
 {
+	// Typically there are only (compiled) conditions and they're all false,
+	// avoid copying the collections and calling into Tcl in that case.
+	if ((range.first == range.second) &&
+	    ranges::none_of(conditions, [&](const DebugCondition& c) {
+	            return c.mightTrigger(motherBoard); })) {
+		return;
+	}
+
 	// create copy for the case that breakpoint/condition removes itself
 	//  - keeps object alive by holding a shared_ptr to it
 	//  - avoids iterating over a changing collection
@@ -817,14 +825,14 @@ void MSXCPUInterface::checkBreakPoints(
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	for (auto& p : bpCopy) {
-		p.checkAndExecute(globalCliComm, interp);
+		p.checkAndExecute(globalCliComm, interp, motherBoard);
 		if (p.onlyOnce()) {
 			removeBreakPoint(p.getId());
 		}
 	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		c.checkAndExecute(globalCliComm, interp);
+		c.checkAndExecute(globalCliComm, interp, motherBoard);
 		if (c.onlyOnce()) {
 			removeCondition(c.getId());
 		}
@@ -986,7 +994,7 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		if ((w->getBeginAddress() <= address) &&
 		    (w->getEndAddress()   >= address) &&
 		    (w->getType()         == type)) {
-			w->checkAndExecute(globalCliComm, interp);
+			w->checkAndExecute(globalCliComm, interp, motherBoard);
 			if (w->onlyOnce()) {
 				removeWatchPoint(w);
 			}
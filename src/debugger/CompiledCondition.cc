@@ -0,0 +1,611 @@
+#include "CompiledCondition.hh"
+#include "CommandException.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
+#include "StringOp.hh"
+#include "ranges.hh"
+#include "unreachable.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <optional>
+
+namespace openmsx {
+
+// Indices in the "CPU regs" debuggable, see the 'reg' proc.
+struct RegInfo {
+	std::string_view name;
+	int index;
+	bool word;
+};
+static constexpr std::array regInfos = {
+	RegInfo{"A",    0, false}, RegInfo{"F",    1, false},
+	RegInfo{"B",    2, false}, RegInfo{"C",    3, false},
+	RegInfo{"D",    4, false}, RegInfo{"E",    5, false},
+	RegInfo{"H",    6, false}, RegInfo{"L",    7, false},
+	RegInfo{"A2",   8, false}, RegInfo{"F2",   9, false},
+	RegInfo{"B2",  10, false}, RegInfo{"C2",  11, false},
+	RegInfo{"D2",  12, false}, RegInfo{"E2",  13, false},
+	RegInfo{"H2",  14, false}, RegInfo{"L2",  15, false},
+	RegInfo{"IXH", 16, false}, RegInfo{"IXL", 17, false},
+	RegInfo{"IYH", 18, false}, RegInfo{"IYL", 19, false},
+	RegInfo{"PCH", 20, false}, RegInfo{"PCL", 21, false},
+	RegInfo{"SPH", 22, false}, RegInfo{"SPL", 23, false},
+	RegInfo{"I",   24, false}, RegInfo{"R",   25, false},
+	RegInfo{"IM",  26, false}, RegInfo{"IFF", 27, false},
+	RegInfo{"AF",   0, true }, RegInfo{"BC",   2, true },
+	RegInfo{"DE",   4, true }, RegInfo{"HL",   6, true },
+	RegInfo{"AF2",  8, true }, RegInfo{"BC2", 10, true },
+	RegInfo{"DE2", 12, true }, RegInfo{"HL2", 14, true },
+	RegInfo{"IX",  16, true }, RegInfo{"IY",  18, true },
+	RegInfo{"PC",  20, true }, RegInfo{"SP",  22, true },
+};
+static constexpr std::string_view CPU_REGS = "CPU regs";
+static constexpr int X = -1; // "X" argument of pc_in_slot, any slot
+
+// Recursive descent parser for (a subset of) Tcl expressions, see
+// CompiledCondition.hh. All parse functions return false when the input
+// can't be compiled.
+class ConditionCompiler
+{
+	using Op = CompiledCondition::Op;
+
+public:
+	ConditionCompiler(std::string_view input_, CompiledCondition& result_)
+		: input(input_), result(result_) {}
+
+	[[nodiscard]] bool compileExpression()
+	{
+		if (!parseTernary()) return false;
+		skipSpace();
+		return input.empty();
+	}
+
+private:
+	// A word in a Tcl command.
+	struct Word {
+		std::string_view text;
+		enum Type { BARE, QUOTED, BRACED, COMMAND } type;
+	};
+
+	void skipSpace()
+	{
+		while (!input.empty() && isspace(uint8_t(input.front()))) {
+			input.remove_prefix(1);
+		}
+	}
+	[[nodiscard]] bool accept(std::string_view op)
+	{
+		skipSpace();
+		if (!StringOp::startsWith(input, op)) return false;
+		input.remove_prefix(op.size());
+		return true;
+	}
+	// Accept 'op', but not when it's the start of 'longer' (e.g. '&'
+	// versus '&&').
+	[[nodiscard]] bool accept(std::string_view op, std::string_view longer)
+	{
+		skipSpace();
+		if (StringOp::startsWith(input, longer)) return false;
+		return accept(op);
+	}
+
+	[[nodiscard]] bool emit(Op op, int64_t arg = 0)
+	{
+		switch (op) {
+		case Op::PUSH:
+		case Op::PC_IN_SLOT:
+			++depth;
+			break;
+		case Op::MUL: case Op::DIV: case Op::MOD: case Op::ADD: case Op::SUB:
+		case Op::SHL: case Op::SHR: case Op::LT: case Op::GT: case Op::LE:
+		case Op::GE: case Op::EQ: case Op::NE: case Op::BITAND:
+		case Op::BITXOR: case Op::BITOR:
+		case Op::JUMP_IF_FALSE: case Op::JUMP_IF_TRUE:
+			--depth;
+			break;
+		default:
+			break; // READ*, unary operators, JUMP
+		}
+		if (depth > CompiledCondition::MAX_STACK) return false;
+		result.code.push_back({op, arg});
+		return true;
+	}
+	[[nodiscard]] size_t here() const { return result.code.size(); }
+	void patch(size_t jump) { result.code[jump].arg = int64_t(here()); }
+
+	[[nodiscard]] bool parseTernary()
+	{
+		if (!parseOr()) return false;
+		if (!accept("?")) return true;
+		auto jumpElse = here();
+		if (!emit(Op::JUMP_IF_FALSE)) return false;
+		if (!parseTernary()) return false;
+		if (!accept(":")) return false;
+		auto jumpEnd = here();
+		if (!emit(Op::JUMP)) return false;
+		--depth; // only one of both branches is executed
+		patch(jumpElse);
+		if (!parseTernary()) return false;
+		patch(jumpEnd);
+		return true;
+	}
+
+	// 'a && b' becomes:  a; JUMP_IF_FALSE L1; b; BOOL; JUMP L2;
+	//                    L1: PUSH 0; L2:
+	// and similar for 'a || b'.
+	[[nodiscard]] bool parseLogical(std::string_view op, bool (ConditionCompiler::*next)(),
+	                                Op jumpOp, int64_t shortValue)
+	{
+		if (!(this->*next)()) return false;
+		while (accept(op)) {
+			auto jumpShort = here();
+			if (!emit(jumpOp)) return false;
+			if (!(this->*next)()) return false;
+			if (!emit(Op::BOOL)) return false;
+			auto jumpEnd = here();
+			if (!emit(Op::JUMP)) return false;
+			--depth; // only one of both paths is executed
+			patch(jumpShort);
+			if (!emit(Op::PUSH, shortValue)) return false;
+			patch(jumpEnd);
+		}
+		return true;
+	}
+	[[nodiscard]] bool parseOr()
+	{
+		return parseLogical("||", &ConditionCompiler::parseAnd, Op::JUMP_IF_TRUE, 1);
+	}
+	[[nodiscard]] bool parseAnd()
+	{
+		return parseLogical("&&", &ConditionCompiler::parseBitOr, Op::JUMP_IF_FALSE, 0);
+	}
+
+	[[nodiscard]] bool parseBitOr()
+	{
+		if (!parseBitXor()) return false;
+		while (accept("|", "||")) {
+			if (!parseBitXor() || !emit(Op::BITOR)) return false;
+		}
+		return true;
+	}
+	[[nodiscard]] bool parseBitXor()
+	{
+		if (!parseBitAnd()) return false;
+		while (accept("^")) {
+			if (!parseBitAnd() || !emit(Op::BITXOR)) return false;
+		}
+		return true;
+	}
+	[[nodiscard]] bool parseBitAnd()
+	{
+		if (!parseEquality()) return false;
+		while (accept("&", "&&")) {
+			if (!parseEquality() || !emit(Op::BITAND)) return false;
+		}
+		return true;
+	}
+	[[nodiscard]] bool parseEquality()
+	{
+		if (!parseRelational()) return false;
+		while (true) {
+			Op op;
+			if      (accept("==")) op = Op::EQ;
+			else if (accept("!=")) op = Op::NE;
+			else return true;
+			if (!parseRelational() || !emit(op)) return false;
+		}
+	}
+	[[nodiscard]] bool parseRelational()
+	{
+		if (!parseShift()) return false;
+		while (true) {
+			Op op;
+			if      (accept("<=")) op = Op::LE;
+			else if (accept(">=")) op = Op::GE;
+			else if (accept("<", "<<")) op = Op::LT;
+			else if (accept(">", ">>")) op = Op::GT;
+			else return true;
+			if (!parseShift() || !emit(op)) return false;
+		}
+	}
+	[[nodiscard]] bool parseShift()
+	{
+		if (!parseAdditive()) return false;
+		while (true) {
+			Op op;
+			if      (accept("<<")) op = Op::SHL;
+			else if (accept(">>")) op = Op::SHR;
+			else return true;
+			if (!parseAdditive() || !emit(op)) return false;
+		}
+	}
+	[[nodiscard]] bool parseAdditive()
+	{
+		if (!parseMultiplicative()) return false;
+		while (true) {
+			Op op;
+			if      (accept("+")) op = Op::ADD;
+			else if (accept("-")) op = Op::SUB;
+			else return true;
+			if (!parseMultiplicative() || !emit(op)) return false;
+		}
+	}
+	[[nodiscard]] bool parseMultiplicative()
+	{
+		if (!parseUnary()) return false;
+		while (true) {
+			Op op;
+			if (accept("**")) return false; // not supported
+			if      (accept("*")) op = Op::MUL;
+			else if (accept("/")) op = Op::DIV;
+			else if (accept("%")) op = Op::MOD;
+			else return true;
+			if (!parseUnary() || !emit(op)) return false;
+		}
+	}
+	[[nodiscard]] bool parseUnary()
+	{
+		if (accept("-")) return parseUnary() && emit(Op::NEG);
+		if (accept("+")) return parseUnary();
+		if (accept("~")) return parseUnary() && emit(Op::BITNOT);
+		if (accept("!")) return parseUnary() && emit(Op::NOT);
+		return parsePrimary();
+	}
+	[[nodiscard]] bool parsePrimary()
+	{
+		skipSpace();
+		if (input.empty()) return false;
+		if (accept("(")) {
+			return parseTernary() && accept(")");
+		}
+		if (input.front() == '[') {
+			auto w = parseWord();
+			return w && compileWord(*w);
+		}
+		if (isdigit(uint8_t(input.front()))) {
+			auto len = std::min(input.find_first_not_of(
+				"0123456789abcdefABCDEFxXoO"), input.size());
+			if ((len < input.size()) && (input[len] == '.')) return false;
+			auto value = parseInteger(input.substr(0, len));
+			input.remove_prefix(len);
+			return value && emit(Op::PUSH, *value);
+		}
+		return false; // e.g. variables, strings, functions
+	}
+
+	// Parse a literal as in Tcl, but leading zeros (octal in Tcl 8) are
+	// not supported.
+	[[nodiscard]] static std::optional<int64_t> parseInteger(std::string_view s)
+	{
+		int base = 10;
+		if ((s.size() > 2) && (s[0] == '0')) {
+			switch (s[1]) {
+				case 'x': case 'X': base = 16; break;
+				case 'b': case 'B': base = 2; break;
+				case 'o': case 'O': base = 8; break;
+				default: return {};
+			}
+			s.remove_prefix(2);
+		} else if (s.empty() || ((s.size() > 1) && (s[0] == '0'))) {
+			return {};
+		}
+		uint64_t value = 0;
+		for (char c : s) {
+			int digit = isdigit(uint8_t(c)) ? (c - '0')
+			          : isxdigit(uint8_t(c)) ? (tolower(c) - 'a' + 10)
+			          : base;
+			if (digit >= base) return {};
+			if (value > (uint64_t(INT64_MAX) - digit) / base) return {};
+			value = value * base + digit;
+		}
+		return int64_t(value);
+	}
+
+	// Parse one word of a Tcl command, 'input' must not start with
+	// whitespace.
+	[[nodiscard]] std::optional<Word> parseWord()
+	{
+		auto matching = [&](char open, char close) -> std::optional<std::string_view> {
+			int level = 0;
+			for (auto i : xrange(input.size())) {
+				char c = input[i];
+				if (c == '\\') return {};
+				if (c == open) ++level;
+				if ((c == close) && (--level == 0)) {
+					auto text = input.substr(1, i - 1);
+					input.remove_prefix(i + 1);
+					return text;
+				}
+			}
+			return {};
+		};
+		switch (input.front()) {
+		case '[':
+			if (auto text = matching('[', ']')) return Word{*text, Word::COMMAND};
+			return {};
+		case '{':
+			if (auto text = matching('{', '}')) return Word{*text, Word::BRACED};
+			return {};
+		case '"': {
+			auto end = input.find('"', 1);
+			if (end == std::string_view::npos) return {};
+			auto text = input.substr(1, end - 1);
+			if (text.find_first_of("[$\\") != std::string_view::npos) return {};
+			input.remove_prefix(end + 1);
+			return Word{text, Word::QUOTED};
+		}
+		default: {
+			auto end = std::min(input.find_first_of(" \t\r\n]"), input.size());
+			auto text = input.substr(0, end);
+			if (text.find_first_of("[{}\"$\\;") != std::string_view::npos) return {};
+			input.remove_prefix(end);
+			return Word{text, Word::BARE};
+		}
+		}
+	}
+
+	// Emit the code to calculate the value of a word: a command or an
+	// integer literal.
+	[[nodiscard]] bool compileWord(const Word& w)
+	{
+		if (w.type == Word::COMMAND) {
+			ConditionCompiler sub(w.text, result);
+			sub.depth = depth;
+			if (!sub.compileCommand()) return false;
+			depth = sub.depth;
+			return true;
+		}
+		auto value = parseInteger(w.text);
+		return value && emit(Op::PUSH, *value);
+	}
+
+	[[nodiscard]] size_t nameIndex(std::string_view name)
+	{
+		if (auto it = ranges::find(result.names, name); it != end(result.names)) {
+			return it - begin(result.names);
+		}
+		result.names.emplace_back(name);
+		return result.names.size() - 1;
+	}
+
+	// Compile the content of a '[...]' command substitution.
+	[[nodiscard]] bool compileCommand()
+	{
+		std::vector<Word> words;
+		while (true) {
+			skipSpace();
+			if (input.empty()) break;
+			auto w = parseWord();
+			if (!w) return false;
+			words.push_back(*w);
+		}
+		if (words.empty()) return false;
+		auto isLiteral = [](const Word& w) { return w.type != Word::COMMAND; };
+		auto cmd = words[0].text;
+		if (!isLiteral(words[0])) return false;
+
+		if (cmd == "reg") {
+			// with 3 words it's a write
+			if ((words.size() != 2) || !isLiteral(words[1])) return false;
+			std::string name(words[1].text);
+			for (auto& c : name) c = char(toupper(uint8_t(c)));
+			auto it = ranges::find(regInfos, std::string_view(name), &RegInfo::name);
+			if (it == end(regInfos)) return false;
+			return emit(Op::PUSH, it->index) &&
+			       emit(it->word ? Op::READ16BE : Op::READ8, nameIndex(CPU_REGS));
+		}
+		if (StringOp::startsWith(cmd, "peek")) {
+			struct PeekInfo { std::string_view name; Op read; bool sign8; bool sign16; };
+			static constexpr std::array peekInfos = {
+				PeekInfo{"peek",       Op::READ8,    false, false},
+				PeekInfo{"peek8",      Op::READ8,    false, false},
+				PeekInfo{"peek_u8",    Op::READ8,    false, false},
+				PeekInfo{"peek_s8",    Op::READ8,    true,  false},
+				PeekInfo{"peek16",     Op::READ16LE, false, false},
+				PeekInfo{"peek16_LE",  Op::READ16LE, false, false},
+				PeekInfo{"peek16_BE",  Op::READ16BE, false, false},
+				PeekInfo{"peek_u16",   Op::READ16LE, false, false},
+				PeekInfo{"peek_u16LE", Op::READ16LE, false, false},
+				PeekInfo{"peek_u16BE", Op::READ16BE, false, false},
+				PeekInfo{"peek_s16",   Op::READ16LE, false, true },
+				PeekInfo{"peek_s16LE", Op::READ16LE, false, true },
+				PeekInfo{"peek_s16BE", Op::READ16BE, false, true },
+			};
+			auto it = ranges::find(peekInfos, cmd, &PeekInfo::name);
+			if (it == end(peekInfos)) return false;
+			if ((words.size() < 2) || (words.size() > 3)) return false;
+			std::string_view debuggable = "memory";
+			if (words.size() == 3) {
+				if (!isLiteral(words[2])) return false;
+				debuggable = words[2].text;
+			}
+			return compileWord(words[1]) &&
+			       emit(it->read, nameIndex(debuggable)) &&
+			       (!it->sign8  || emit(Op::SEXT8)) &&
+			       (!it->sign16 || emit(Op::SEXT16));
+		}
+		if (cmd == "debug") {
+			if ((words.size() != 4) || (words[1].text != "read") ||
+			    !isLiteral(words[1]) || !isLiteral(words[2])) return false;
+			return compileWord(words[3]) &&
+			       emit(Op::READ8, nameIndex(words[2].text));
+		}
+		if (cmd == "pc_in_slot") {
+			// the 'mapper' argument is not supported
+			if ((words.size() < 2) || (words.size() > 3)) return false;
+			auto slot = [&](const Word& w) -> std::optional<int> {
+				if (!isLiteral(w)) return {};
+				if (w.text == "X") return X;
+				auto value = parseInteger(w.text);
+				if (!value || (*value < 0) || (*value > 3)) return {};
+				return int(*value);
+			};
+			auto ps = slot(words[1]);
+			auto ss = (words.size() == 3) ? slot(words[2]) : std::optional<int>(X);
+			if (!ps || !ss) return false;
+			return emit(Op::PC_IN_SLOT, (*ps + 1) + 8 * (*ss + 1));
+		}
+		if (cmd == "expr") {
+			if ((words.size() != 2) || !isLiteral(words[1])) return false;
+			ConditionCompiler sub(words[1].text, result);
+			sub.depth = depth;
+			if (!sub.compileExpression()) return false;
+			depth = sub.depth;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	std::string_view input;
+	CompiledCondition& result;
+	int depth = 0; // stack depth at this point in the code
+};
+
+std::unique_ptr<CompiledCondition> CompiledCondition::compile(std::string_view expr)
+{
+	auto result = std::make_unique<CompiledCondition>();
+	ConditionCompiler compiler(expr, *result);
+	if (!compiler.compileExpression()) return nullptr;
+	return result;
+}
+
+// Tcl semantics: rounds towards negative infinity
+[[nodiscard]] static int64_t floorDiv(int64_t x, int64_t y)
+{
+	if (y == 0) throw CommandException("divide by zero");
+	if ((x == INT64_MIN) && (y == -1)) return x; // wraps
+	auto q = x / y;
+	if (((x % y) != 0) && ((x < 0) != (y < 0))) --q;
+	return q;
+}
+// Tcl semantics: the result has the same sign as the divisor
+[[nodiscard]] static int64_t floorMod(int64_t x, int64_t y)
+{
+	if (y == 0) throw CommandException("divide by zero");
+	if (y == -1) return 0;
+	auto r = x % y;
+	if ((r != 0) && ((r < 0) != (y < 0))) r += y;
+	return r;
+}
+
+int64_t CompiledCondition::eval(Context& context) const
+{
+	std::array<int64_t, MAX_STACK> stack;
+	int sp = 0;
+	auto pop = [&] { return stack[--sp]; };
+	auto push = [&](int64_t v) { stack[sp++] = v; };
+	auto read = [&](int64_t name, int64_t addr) -> int64_t {
+		return context.read(names[name], addr);
+	};
+
+	size_t pc = 0;
+	while (pc < code.size()) {
+		const auto& [op, arg] = code[pc++];
+		switch (op) {
+		case Op::PUSH: push(arg); break;
+		case Op::READ8: push(read(arg, pop())); break;
+		case Op::READ16LE: {
+			auto addr = pop();
+			push(read(arg, addr) + 256 * read(arg, addr + 1));
+			break;
+		}
+		case Op::READ16BE: {
+			auto addr = pop();
+			push(256 * read(arg, addr) + read(arg, addr + 1));
+			break;
+		}
+		case Op::PC_IN_SLOT: {
+			// see 'address_in_slot' and 'get_selected_slot' procs
+			int ps = int(arg % 8) - 1;
+			int ss = int(arg / 8) - 1;
+			auto pc_ = 256 * context.read(CPU_REGS, 20) + context.read(CPU_REGS, 21);
+			int page = pc_ >> 14;
+			int pcPs = (context.read("ioports", 0xA8) >> (2 * page)) & 3;
+			int pcSs = X;
+			if (context.isExpanded(pcPs)) {
+				auto ssReg = context.read("slotted memory", 0x40000 * pcPs + 0xFFFF);
+				pcSs = ((ssReg ^ 255) >> (2 * page)) & 3;
+			}
+			push(((ps == X) || (pcPs == ps)) &&
+			     ((ss == X) || (pcSs == X) || (pcSs == ss)));
+			break;
+		}
+		case Op::NEG:    push(int64_t(0 - uint64_t(pop()))); break;
+		case Op::BITNOT: push(~pop()); break;
+		case Op::NOT:    push(pop() == 0); break;
+		case Op::BOOL:   push(pop() != 0); break;
+		case Op::SEXT8:  push(int8_t(pop())); break;
+		case Op::SEXT16: push(int16_t(pop())); break;
+		case Op::JUMP: pc = size_t(arg); break;
+		case Op::JUMP_IF_FALSE: if (pop() == 0) pc = size_t(arg); break;
+		case Op::JUMP_IF_TRUE:  if (pop() != 0) pc = size_t(arg); break;
+		default: {
+			auto y = pop();
+			auto x = pop();
+			auto ux = uint64_t(x);
+			auto uy = uint64_t(y);
+			switch (op) {
+			case Op::MUL: push(int64_t(ux * uy)); break;
+			case Op::DIV: push(floorDiv(x, y)); break;
+			case Op::MOD: push(floorMod(x, y)); break;
+			case Op::ADD: push(int64_t(ux + uy)); break;
+			case Op::SUB: push(int64_t(ux - uy)); break;
+			case Op::SHL:
+				if (y < 0) throw CommandException("negative shift argument");
+				push((y >= 64) ? 0 : int64_t(ux << y));
+				break;
+			case Op::SHR:
+				if (y < 0) throw CommandException("negative shift argument");
+				push(x >> std::min<int64_t>(y, 63));
+				break;
+			case Op::LT:     push(x <  y); break;
+			case Op::GT:     push(x >  y); break;
+			case Op::LE:     push(x <= y); break;
+			case Op::GE:     push(x >= y); break;
+			case Op::EQ:     push(x == y); break;
+			case Op::NE:     push(x != y); break;
+			case Op::BITAND: push(x & y); break;
+			case Op::BITXOR: push(x ^ y); break;
+			case Op::BITOR:  push(x | y); break;
+			default: UNREACHABLE;
+			}
+		}
+		}
+	}
+	assert(sp == 1);
+	return stack[0];
+}
+
+bool CompiledCondition::evalBool(MSXMotherBoard& motherBoard) const
+{
+	struct MotherBoardContext final : Context {
+		explicit MotherBoardContext(MSXMotherBoard& motherBoard_)
+			: motherBoard(motherBoard_) {}
+
+		// same checks and messages as 'debug read'
+		uint8_t read(std::string_view name, int64_t address) override {
+			auto* debuggable = motherBoard.getDebugger().findDebuggable(name);
+			if (!debuggable) {
+				throw CommandException("No such debuggable: ", name);
+			}
+			if ((address < 0) || (address >= debuggable->getSize())) {
+				throw CommandException("Invalid address");
+			}
+			return debuggable->read(unsigned(address));
+		}
+		bool isExpanded(int ps) override {
+			return motherBoard.getCPUInterface().isExpanded(ps);
+		}
+
+		MSXMotherBoard& motherBoard;
+	} context(motherBoard);
+	return evalBool(context);
+}
+
+} // namespace openmsx
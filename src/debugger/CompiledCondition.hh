@@ -0,0 +1,85 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+
+/** Debug conditions (and the conditions of break- and watchpoints) are Tcl
+  * expressions. Conditions are checked before every instruction, evaluating
+  * them via the Tcl interpreter makes emulation a lot slower. This class
+  * compiles the commonly used subset of these expressions into a simple
+  * bytecode that can be evaluated without Tcl:
+  *  - integer literals (decimal, 0x.., 0b.., 0o..)
+  *  - the operators  - + ~ !  * / %  + -  << >>  < > <= >=  == !=  & ^ |
+  *    && ||  ?:  and parentheses
+  *  - [reg <name>]
+  *  - [peek <addr> ?<debuggable>?], also peek8, peek_u8, peek_s8, peek16,
+  *    peek_u16, peek_s16 and their _LE/_BE variants
+  *  - [debug read <debuggable> <addr>]
+  *  - [pc_in_slot <ps> ?<ss>?]
+  *  - [expr {...}]
+  * Arguments can again be commands, e.g. [peek [reg HL]].
+  * This assumes that the procs above have their standard definitions (from
+  * the scripts that come with openMSX). Expressions that use anything else
+  * (e.g. variables) can't be compiled, they're still evaluated by Tcl.
+  *
+  * Values are 64-bit integers (Tcl uses arbitrary precision, but that makes
+  * no difference for the values conditions typically work with).
+  */
+class CompiledCondition
+{
+public:
+	/** The MSX state an expression is evaluated against. */
+	class Context
+	{
+	public:
+		/** Same as 'debug read <debuggable> <address>'.
+		  * @throws CommandException */
+		[[nodiscard]] virtual uint8_t read(std::string_view debuggable, int64_t address) = 0;
+		/** Same as 'machine_info issubslotted <ps>'. */
+		[[nodiscard]] virtual bool isExpanded(int ps) = 0;
+
+	protected:
+		~Context() = default;
+	};
+
+	/** Returns nullptr when the expression can't be compiled. */
+	[[nodiscard]] static std::unique_ptr<CompiledCondition> compile(std::string_view expr);
+
+	/** Evaluate the expression. Like in Tcl, errors are reported via an
+	  * exception, e.g. an invalid address or a division by zero.
+	  * @throws CommandException */
+	[[nodiscard]] int64_t eval(Context& context) const;
+	[[nodiscard]] bool evalBool(Context& context) const { return eval(context) != 0; }
+	[[nodiscard]] bool evalBool(MSXMotherBoard& motherBoard) const;
+
+private:
+	friend class ConditionCompiler;
+
+	enum class Op : uint8_t {
+		PUSH, READ8, READ16LE, READ16BE, PC_IN_SLOT,
+		NEG, BITNOT, NOT, BOOL, SEXT8, SEXT16,
+		MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+		LT, GT, LE, GE, EQ, NE, BITAND, BITXOR, BITOR,
+		JUMP, JUMP_IF_FALSE, JUMP_IF_TRUE,
+	};
+	struct Instr {
+		Op op;
+		int64_t arg; // constant, index in 'names' or jump target
+	};
+	static constexpr int MAX_STACK = 16;
+
+	std::vector<Instr> code;
+	std::vector<std::string> names; // debuggables
+};
+
+} // namespace openmsx
+
+#endif
@@ -2,14 +2,19 @@
 #include "Debuggable.hh"
 #include "ProbeBreakPoint.hh"
 #include "MSXMotherBoard.hh"
+#include "Reactor.hh"
 #include "MSXCPU.hh"
 #include "MSXCPUInterface.hh"
 #include "BreakPoint.hh"
 #include "DebugCondition.hh"
 #include "MSXWatchIODevice.hh"
+#include "Scheduler.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
 #include "MemBuffer.hh"
 #include "one_of.hh"
 #include "ranges.hh"
@@ -241,7 +246,10 @@ void Debugger::Cmd::execute(
 		"set_condition",     [&]{ setCondition(tokens, result); },
 		"remove_condition",  [&]{ removeCondition(tokens, result); },
 		"list_conditions",   [&]{ listConditions(tokens, result); },
-		"probe",             [&]{ probe(tokens, result); });
+		"probe",             [&]{ probe(tokens, result); },
+		"scheduler_stats",   [&]{ schedulerStats(tokens, result); },
+		"cpu_profile",       [&]{ cpuProfile(tokens, result); },
+		"instruction_trace", [&]{ instructionTrace(tokens, result); });
 }
 
 void Debugger::Cmd::list(TclObject& result)
@@ -614,6 +622,111 @@ void Debugger::Cmd::probe(span<const TclObject> tokens, TclObject& result)
 		"remove_bp", [&]{ probeRemoveBreakPoint(tokens, result); },
 		"list_bp",   [&]{ probeListBreakPoints(tokens, result); });
 }
+void Debugger::Cmd::schedulerStats(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 3}, Prefix{2}, "?start|stop|reset?");
+	auto& profile = debugger().motherBoard.getReactor().getSchedulerProfile();
+	if (tokens.size() == 3) {
+		executeSubCommand(tokens[2].getString(),
+			"start", [&]{ profile.setEnabled(true); },
+			"stop",  [&]{ profile.setEnabled(false); },
+			"reset", [&]{ profile.reset(); });
+		return;
+	}
+	for (const auto& [name, entry] : profile.getSorted()) {
+		result.addListElement(makeTclList(
+			name, entry.count, double(entry.hostTime) * 1e-9));
+	}
+}
+
+void Debugger::Cmd::cpuProfile(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 4}, Prefix{2}, "?start|stop|reset|save filename?");
+	auto& cpu = *debugger().cpu;
+	if (tokens.size() > 2) {
+		executeSubCommand(tokens[2].getString(),
+			"start", [&]{
+				checkNumArgs(tokens, 3, Prefix{2}, "start");
+				cpu.setProfiling(true);
+			},
+			"stop",  [&]{
+				checkNumArgs(tokens, 3, Prefix{2}, "stop");
+				cpu.setProfiling(false);
+			},
+			"reset", [&]{
+				checkNumArgs(tokens, 3, Prefix{2}, "reset");
+				cpu.getProfiler().reset();
+			},
+			"save",  [&]{
+				checkNumArgs(tokens, 4, Prefix{2}, "save filename");
+				auto filename = FileOperations::expandTilde(
+					string(tokens[3].getString()));
+				try {
+					cpu.getProfiler().saveFolded(filename);
+				} catch (FileException& e) {
+					throw CommandException(e.getMessage());
+				}
+			});
+		return;
+	}
+	for (const auto& r : cpu.getProfiler().getResults()) {
+		result.addListElement(makeTclList(
+			r.slot / 4, r.slot % 4, r.address,
+			r.entry.count, r.entry.cycles));
+	}
+}
+
+void Debugger::Cmd::instructionTrace(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 4}, Prefix{2}, "?start ?size?|stop|clear|save filename?");
+	auto& cpu = *debugger().cpu;
+	auto& trace = cpu.getInstructionTrace();
+	if (tokens.size() > 2) {
+		executeSubCommand(tokens[2].getString(),
+			"start", [&]{
+				checkNumArgs(tokens, Between{3, 4}, Prefix{2}, "start ?size?");
+				int size = (tokens.size() == 4)
+				         ? tokens[3].getInt(getInterpreter())
+				         : 1000000;
+				if (size <= 0) {
+					throw CommandException("Size must be positive");
+				}
+				if (size_t(size) > InstructionTrace::MAX_SIZE) {
+					throw CommandException(
+						"Size can be at most ", InstructionTrace::MAX_SIZE);
+				}
+				try {
+					cpu.startInstructionTrace(size);
+				} catch (MSXException& e) {
+					throw CommandException(e.getMessage());
+				}
+			},
+			"stop",  [&]{
+				checkNumArgs(tokens, 3, Prefix{2}, "stop");
+				cpu.stopInstructionTrace();
+			},
+			"clear", [&]{
+				checkNumArgs(tokens, 3, Prefix{2}, "clear");
+				trace.clear();
+			},
+			"save",  [&]{
+				checkNumArgs(tokens, 4, Prefix{2}, "save filename");
+				auto filename = FileOperations::expandTilde(
+					string(tokens[3].getString()));
+				try {
+					trace.save(filename);
+				} catch (FileException& e) {
+					throw CommandException(e.getMessage());
+				}
+			});
+		return;
+	}
+	result.addDictKeyValues("enabled",  trace.isEnabled(),
+	                        "capacity", uint64_t(trace.capacity()),
+	                        "size",     uint64_t(trace.size()),
+	                        "total",    trace.totalRecorded());
+}
+
 void Debugger::Cmd::probeList(span<const TclObject> /*tokens*/, TclObject& result)
 {
 	result.addListElements(view::transform(debugger().probes,
@@ -709,6 +822,9 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"    break             break CPU at current position\n"
 		"    breaked           query CPU breaked status\n"
 		"    disasm            disassemble instructions\n"
+		"    scheduler_stats   profile the scheduled devices\n"
+		"    cpu_profile       profile the executed MSX code\n"
+		"    instruction_trace record the most recently executed instructions\n"
 		"  The arguments are specific for each subcommand.\n"
 		"  Type 'help debug <subcommand>' for help about a specific subcommand.\n";
 
@@ -869,6 +985,50 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"instruction).\n"
 		"  Note that openMSX comes with a 'disasm' Tcl script that is much "
 		"more convenient to use than this subcommand.";
+	auto schedulerStatsHelp =
+		"debug scheduler_stats [start|stop|reset]\n"
+		"  Profile which devices cause the most scheduler activity.\n"
+		"    start  start collecting data, this slows down emulation a bit\n"
+		"    stop   stop collecting data, the data collected so far remains\n"
+		"    reset  clear the collected data\n"
+		"  Without argument this returns the collected data: a list with "
+		"for each device a list of 3 elements: the name, the number of "
+		"times it was executed and the total (host) time spent in it (in "
+		"seconds). The list is sorted on decreasing time.\n"
+		"  The name is the type of the scheduled object, followed by the "
+		"name of the device it belongs to (when a machine can have several "
+		"of them), e.g. \"EmuTimer MSX-AUDIO\". The data is kept when "
+		"switching machines, going back in time or loading a savestate.\n";
+	auto cpuProfileHelp =
+		"debug cpu_profile [start|stop|reset|save <filename>]\n"
+		"  Profile in which parts of the MSX program the (emulated) time "
+		"is spent.\n"
+		"    start  start collecting data, this slows down emulation\n"
+		"    stop   stop collecting data, the data collected so far remains\n"
+		"    reset  clear the collected data\n"
+		"    save   write the data to a file in the 'folded stacks' format, "
+		"this can be visualized with flame graph tools\n"
+		"  Without argument this returns the collected data: a list with "
+		"for each executed instruction a list of 5 elements: the primary "
+		"and secondary slot, the address, the number of times it was "
+		"executed and the total number of CPU cycles spent in it. The list "
+		"is sorted on decreasing number of cycles.\n";
+	auto instructionTraceHelp =
+		"debug instruction_trace [start [<size>]|stop|clear|save <filename>]\n"
+		"  Record the most recently executed instructions (address, opcode, "
+		"registers and time) in a ring buffer.\n"
+		"    start  start recording, the buffer holds the last <size> "
+		"instructions (default 1000000, at most 67108864)\n"
+		"    stop   stop recording, the recorded data remains\n"
+		"    clear  clear the recorded data\n"
+		"    save   write the recorded data to a (binary) file, see "
+		"Contrib/cputrace-reader.cc to read it\n"
+		"  Without argument this returns a dict with the status: 'enabled', "
+		"'capacity' (size of the buffer), 'size' (number of instructions in "
+		"the buffer) and 'total' (number of recorded instructions).\n"
+		"  To save the trace when a breakpoint is hit, use a breakpoint "
+		"command like:\n"
+		"    debug set_bp 0x1234 {} {debug instruction_trace save crash.trace; debug break}\n";
 	auto unknownHelp =
 		"Unknown subcommand, use 'help debug' to see a list of valid "
 		"subcommands.\n";
@@ -919,6 +1079,12 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		return breakedHelp;
 	} else if (tokens[1] == "disasm") {
 		return disasmHelp;
+	} else if (tokens[1] == "scheduler_stats") {
+		return schedulerStatsHelp;
+	} else if (tokens[1] == "cpu_profile") {
+		return cpuProfileHelp;
+	} else if (tokens[1] == "instruction_trace") {
+		return instructionTraceHelp;
 	} else {
 		return unknownHelp;
 	}
@@ -957,7 +1123,8 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 	static constexpr std::array otherCmds = {
 		"disasm"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
 		"remove_watchpoint"sv, "set_condition"sv, "remove_condition"sv,
-		"probe"sv,
+		"probe"sv, "scheduler_stats"sv, "cpu_profile"sv,
+		"instruction_trace"sv,
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -991,6 +1158,21 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 					"remove_bp"sv, "list_bp"sv,
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "scheduler_stats") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "reset"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "cpu_profile") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "reset"sv, "save"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "instruction_trace") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "clear"sv, "save"sv,
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -1001,6 +1183,9 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 				debugger().probes,
 				[](auto* p) { return p->getName(); }));
 			completeString(tokens, probeNames);
+		} else if ((tokens[1] == one_of("cpu_profile", "instruction_trace")) &&
+		           (tokens[2] == "save")) {
+			completeFileName(tokens, userFileContext());
 		}
 		break;
 	}
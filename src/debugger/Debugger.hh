@@ -99,6 +99,9 @@ private:
 		void probeSetBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(span<const TclObject> tokens, TclObject& result);
+		void schedulerStats(span<const TclObject> tokens, TclObject& result);
+		void cpuProfile(span<const TclObject> tokens, TclObject& result);
+		void instructionTrace(span<const TclObject> tokens, TclObject& result);
 	} cmd;
 
 	struct NameFromProbe {
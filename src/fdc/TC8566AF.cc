@@ -11,6 +11,7 @@
 #include "MSXException.hh"
 #include "one_of.hh"
 #include "serialize.hh"
+#include "strCat.hh"
 #include "xrange.hh"
 
 namespace openmsx {
@@ -62,9 +63,10 @@ constexpr byte ST3_FLT = 0x80; // Fault
 
 
 TC8566AF::TC8566AF(Scheduler& scheduler_, DiskDrive* drv[4], CliComm& cliComm_,
-                   EmuTime::param time)
+                   EmuTime::param time, const std::string& name_)
 	: Schedulable(scheduler_)
 	, cliComm(cliComm_)
+	, name(name_)
 	, delayTime(EmuTime::zero())
 	, headUnloadTime(EmuTime::zero()) // head not loaded
 {
@@ -728,6 +730,11 @@ void TC8566AF::doSeek(int n)
 	setSyncPoint(si.time);
 }
 
+std::string TC8566AF::getProfileName() const
+{
+	return strCat(Schedulable::getProfileName(), ' ', name);
+}
+
 void TC8566AF::executeUntil(EmuTime::param time)
 {
 	for (auto n : xrange(4)) {
@@ -16,8 +16,9 @@ class CliComm;
 class TC8566AF final : public Schedulable
 {
 public:
+	/** @param name Name of the FDC device, see getProfileName(). */
 	TC8566AF(Scheduler& scheduler, DiskDrive* drv[4], CliComm& cliComm,
-	         EmuTime::param time);
+	         EmuTime::param time, const std::string& name);
 
 	void reset(EmuTime::param time);
 	[[nodiscard]] byte peekDataPort(EmuTime::param time) const;
@@ -67,6 +68,7 @@ public:
 private:
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
+	[[nodiscard]] std::string getProfileName() const override;
 
 	[[nodiscard]] byte executionPhasePeek(EmuTime::param time) const;
 	byte executionPhaseRead(EmuTime::param time);
@@ -94,6 +96,7 @@ private:
 
 private:
 	CliComm& cliComm;
+	const std::string name;
 	DiskDrive* drive[4];
 	DynamicClock delayTime;
 	EmuTime headUnloadTime; // Before this time head is loaded, after
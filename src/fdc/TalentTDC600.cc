@@ -10,7 +10,7 @@ namespace openmsx {
 TalentTDC600::TalentTDC600(const DeviceConfig& config)
 	: MSXFDC(config)
 	, controller(getScheduler(), reinterpret_cast<DiskDrive**>(drives),
-	             getCliComm(), getCurrentTime())
+	             getCliComm(), getCurrentTime(), getName())
 {
 	reset(getCurrentTime());
 }
@@ -40,7 +40,7 @@ namespace openmsx {
 TurboRFDC::TurboRFDC(const DeviceConfig& config)
 	: MSXFDC(config)
 	, controller(getScheduler(), reinterpret_cast<DiskDrive**>(drives),
-	             getCliComm(), getCurrentTime())
+	             getCliComm(), getCurrentTime(), getName())
 	, romBlockDebug(*this, &bank, 0x4000, 0x4000, 14)
 	, blockMask((rom->getSize() / 0x4000) - 1)
 	, type(parseType(config))
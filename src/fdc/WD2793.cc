@@ -4,6 +4,7 @@
 #include "Clock.hh"
 #include "MSXException.hh"
 #include "serialize.hh"
+#include "strCat.hh"
 #include "unreachable.hh"
 #include <iostream>
 
@@ -45,10 +46,11 @@ constexpr auto IDLE = EmuDuration::sec(3);
  * signal yet).
  */
 WD2793::WD2793(Scheduler& scheduler_, DiskDrive& drive_, CliComm& cliComm_,
-               EmuTime::param time, bool isWD1770_)
+               EmuTime::param time, bool isWD1770_, const std::string& name_)
 	: Schedulable(scheduler_)
 	, drive(drive_)
 	, cliComm(cliComm_)
+	, name(name_)
 	, drqTime(EmuTime::infinity())
 	, irqTime(EmuTime::infinity())
 	, pulse5(EmuTime::infinity())
@@ -342,6 +344,11 @@ void WD2793::schedule(FSMState state, EmuTime::param time)
 	setSyncPoint(time);
 }
 
+std::string WD2793::getProfileName() const
+{
+	return strCat(Schedulable::getProfileName(), ' ', name);
+}
+
 void WD2793::executeUntil(EmuTime::param time)
 {
 	FSMState state = fsmState;
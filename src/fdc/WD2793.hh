@@ -16,8 +16,9 @@ class CliComm;
 class WD2793 final : public Schedulable
 {
 public:
+	/** @param name Name of the FDC device, see getProfileName(). */
 	WD2793(Scheduler& scheduler, DiskDrive& drive, CliComm& cliComm,
-	       EmuTime::param time, bool isWD1770);
+	       EmuTime::param time, bool isWD1770, const std::string& name);
 
 	void reset(EmuTime::param time);
 
@@ -65,6 +66,7 @@ public:
 
 private:
 	void executeUntil(EmuTime::param time) override;
+	[[nodiscard]] std::string getProfileName() const override;
 
 	void startType1Cmd(EmuTime::param time);
 
@@ -105,6 +107,7 @@ private:
 private:
 	DiskDrive& drive;
 	CliComm& cliComm;
+	const std::string name;
 
 	// DRQ is high iff current time is past this time.
 	//  This clock ticks at the 'byte-rate' of the current track,
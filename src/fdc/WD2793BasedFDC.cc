@@ -10,7 +10,7 @@ WD2793BasedFDC::WD2793BasedFDC(const DeviceConfig& config, const std::string& ro
 	, multiplexer(reinterpret_cast<DiskDrive**>(drives))
 	, controller(
 		getScheduler(), multiplexer, getCliComm(), getCurrentTime(),
-		config.getXML()->getName() == "WD1770")
+		config.getXML()->getName() == "WD1770", getName())
 {
 }
 
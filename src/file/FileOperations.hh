@@ -63,6 +63,13 @@ namespace openmsx::FileOperations {
 	 */
 	int unlink(zstring_view path);
 
+	/**
+	 * Rename a file, replaces 'newPath' when it already exists. This is
+	 * atomic on POSIX systems.
+	 * @result 0 on success, -1 on failure (like rename())
+	 */
+	int rename(zstring_view oldPath, zstring_view newPath);
+
 	/**
 	 * Call rmdir() in a platform-independent manner
 	 */
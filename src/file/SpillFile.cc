@@ -0,0 +1,58 @@
+#include "SpillFile.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include <cassert>
+
+namespace openmsx {
+
+SpillFile::~SpillFile()
+{
+	if (!filename.empty()) {
+		file.close();
+		FileOperations::unlink(filename);
+	}
+}
+
+void SpillFile::create()
+{
+	assert(!file.is_open());
+	{
+		auto fp = FileOperations::openUniqueFile(
+			FileOperations::getTempDir(), filename);
+		if (!fp) {
+			filename.clear();
+			throw FileException("Couldn't create temp file");
+		}
+	}
+	try {
+		// reopen so that we can also read (mmap) the file
+		file = File(filename, "wb+");
+	} catch (FileException&) {
+		FileOperations::unlink(filename);
+		filename.clear();
+		throw;
+	}
+}
+
+SpillFile::Location SpillFile::append(span<const uint8_t> data)
+{
+	if (!file.is_open()) create();
+
+	// The file grows, so the current mapping becomes invalid.
+	file.munmap();
+	file.seek(fileSize);
+	file.write(data.data(), data.size());
+	file.flush(); // mmap() must see the new data
+	Location result{fileSize, data.size()};
+	fileSize += data.size();
+	return result;
+}
+
+span<const uint8_t> SpillFile::read(const Location& loc)
+{
+	assert((loc.offset + loc.size) <= fileSize);
+	if (loc.size == 0) return {};
+	return file.mmap().subspan(loc.offset, loc.size);
+}
+
+} // namespace openmsx
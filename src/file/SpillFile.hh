@@ -0,0 +1,62 @@
+#ifndef SPILLFILE_HH
+#define SPILLFILE_HH
+
+#include "File.hh"
+#include "span.hh"
+#include <cstdint>
+#include <string>
+
+namespace openmsx {
+
+/** An append-only temporary file. Used to move (large amounts of) data out
+  * of RAM that is only rarely needed again, e.g. old reverse snapshots. The
+  * data is read back via a memory mapping, so only the parts that are
+  * actually accessed are loaded (by the OS).
+  *
+  * The file is created on the first append() and removed again when this
+  * object is destroyed. Data is never removed from the file, so it only
+  * grows.
+  *
+  * This class is not thread safe.
+  */
+class SpillFile
+{
+public:
+	struct Location {
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	SpillFile() = default;
+	~SpillFile();
+
+	SpillFile(const SpillFile&) = delete;
+	SpillFile& operator=(const SpillFile&) = delete;
+
+	/** Append a block of data to the file.
+	  * @result The location of this block, to be passed to read().
+	  * @throws FileException
+	  */
+	[[nodiscard]] Location append(span<const uint8_t> data);
+
+	/** Access a block that was written earlier.
+	  * The result is only valid until the next call to append().
+	  * @throws FileException
+	  */
+	[[nodiscard]] span<const uint8_t> read(const Location& loc);
+
+	/** The total size of the data written to this file. */
+	[[nodiscard]] size_t getSize() const { return fileSize; }
+
+private:
+	void create();
+
+private:
+	File file;
+	std::string filename;
+	size_t fileSize = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -53,11 +53,15 @@ const byte* CheckedRam::getReadCacheLine(unsigned addr) const
 
 byte* CheckedRam::getWriteCacheLine(unsigned addr) const
 {
-	return (completely_initialized_cacheline[addr >> CacheLine::BITS])
-	     ? const_cast<byte*>(&ram[addr]) : nullptr;
+	if (!completely_initialized_cacheline[addr >> CacheLine::BITS]) {
+		return nullptr;
+	}
+	// The CPU may write via this pointer without notifying us.
+	const_cast<Ram&>(ram).markDirty(addr);
+	return const_cast<byte*>(&ram[addr]);
 }
 
-byte* CheckedRam::getRWCacheLines(unsigned addr, unsigned size) const
+const byte* CheckedRam::getReadCacheLines(unsigned addr, unsigned size) const
 {
 	// TODO optimize
 	unsigned num = size >> CacheLine::BITS;
@@ -67,7 +71,15 @@ byte* CheckedRam::getRWCacheLines(unsigned addr, unsigned size) const
 			return nullptr;
 		}
 	}
-	return const_cast<byte*>(&ram[addr]);
+	return &ram[addr];
+}
+
+byte* CheckedRam::getRWCacheLines(unsigned addr, unsigned size) const
+{
+	const byte* data = getReadCacheLines(addr, size);
+	if (!data) return nullptr;
+	const_cast<Ram&>(ram).markDirty(addr, size);
+	return const_cast<byte*>(data);
 }
 
 void CheckedRam::write(unsigned addr, const byte value)
@@ -88,6 +100,7 @@ void CheckedRam::write(unsigned addr, const byte value)
 			msxcpu.invalidateAllSlotsRWCache(0, 0x10000);
 		}
 	}
+	ram.markDirty(addr);
 	ram[addr] = value;
 }
 
@@ -37,6 +37,7 @@ public:
 
 	[[nodiscard]] const byte* getReadCacheLine(unsigned addr) const;
 	[[nodiscard]] byte* getWriteCacheLine(unsigned addr) const;
+	[[nodiscard]] const byte* getReadCacheLines(unsigned addr, unsigned size) const;
 	[[nodiscard]] byte* getRWCacheLines(unsigned addr, unsigned size) const;
 
 	[[nodiscard]] unsigned getSize() const { return ram.getSize(); }
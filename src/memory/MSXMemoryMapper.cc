@@ -6,14 +6,20 @@ namespace openmsx {
 MSXMemoryMapper::MSXMemoryMapper(const DeviceConfig& config)
 	: MSXMemoryMapperBase(config)
 {
+	// all writes go via checkedRam
+	checkedRam.getUncheckedRam().enableDirtyTracking();
 }
 
 void MSXMemoryMapper::writeIO(word port, byte value, EmuTime::param time)
 {
 	MSXMemoryMapperBase::writeIOImpl(port, value, time);
 	byte page = port & 3;
-	if (byte* data = checkedRam.getRWCacheLines(segmentOffset(page), 0x4000)) {
-		fillDeviceRWCache(page * 0x4000, 0x4000, data);
+	if (const byte* data = checkedRam.getReadCacheLines(segmentOffset(page), 0x4000)) {
+		// Only fill the read cache. Write cache lines are requested
+		// on demand, so that only the actually written pages are
+		// marked dirty (and need to be compared in reverse snapshots).
+		fillDeviceRCache(page * 0x4000, 0x4000, data);
+		invalidateDeviceWCache(page * 0x4000, 0x4000);
 	} else {
 		invalidateDeviceRWCache(page * 0x4000, 0x4000);
 	}
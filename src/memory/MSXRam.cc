@@ -30,6 +30,8 @@ void MSXRam::init()
 
 	checkedRam = std::make_unique<CheckedRam>(
 		getDeviceConfig2(), getName(), "ram", size);
+	// all writes go via checkedRam
+	checkedRam->getUncheckedRam().enableDirtyTracking();
 }
 
 void MSXRam::powerUp(EmuTime::param /*time*/)
@@ -90,7 +90,12 @@ void Ram::clear(byte c)
 		// no init pattern specified
 		memset(ram.data(), c, size);
 	}
+	dirty.markAll();
+}
 
+void Ram::enableDirtyTracking()
+{
+	if (!dirty.isTracking()) dirty = DirtyPages(size);
 }
 
 const string& Ram::getName() const
@@ -114,13 +119,14 @@ byte RamDebuggable::read(unsigned address)
 void RamDebuggable::write(unsigned address, byte value)
 {
 	ram[address] = value;
+	ram.markDirty(address);
 }
 
 
 template<typename Archive>
 void Ram::serialize(Archive& ar, unsigned /*version*/)
 {
-	ar.serialize_blob("ram", ram.data(), size);
+	serializeBlob(ar, "ram", size);
 }
 INSTANTIATE_SERIALIZE_METHODS(Ram);
 
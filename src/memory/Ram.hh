@@ -1,6 +1,7 @@
 #ifndef RAM_HH
 #define RAM_HH
 
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
 #include "openmsx.hh"
 #include "static_string_view.hh"
@@ -38,12 +39,45 @@ public:
 	[[nodiscard]] const std::string& getName() const;
 	void clear(byte c = 0xff);
 
+	/** Keep track of which pages are written, this allows reverse
+	  * snapshots to skip the unchanged pages. Only enable this when ALL
+	  * writes are reported via markDirty(). In particular a device that
+	  * hands out (CPU) write cache lines must mark the corresponding page
+	  * each time such a cache line is requested (ReverseManager invalidates
+	  * all CPU caches after taking a snapshot). Writes via the debugger
+	  * and via clear() are already tracked.
+	  */
+	void enableDirtyTracking();
+	void markDirty(unsigned addr) { dirty.mark(addr); }
+	void markDirty(unsigned addr, unsigned num) { dirty.mark(addr, num); }
+	void markAllDirty() { dirty.markAll(); }
+
+	/** Serialize (the first 'num' bytes of) the content as a blob. Also
+	  * used by devices that serialize their Ram as part of their own
+	  * state, so that they as well benefit from dirty tracking.
+	  */
+	template<typename Archive>
+	void serializeBlob(Archive& ar, const char* tag, unsigned num)
+	{
+		if (!dirty.isTracking()) {
+			ar.serialize_blob(tag, ram.data(), num);
+			return;
+		}
+		ar.serialize_blob(tag, ram.data(), num, dirty);
+		if constexpr (Archive::IS_LOADER) {
+			dirty.markAll();
+		} else if (ar.isReverseSnapshot()) {
+			dirty.clear();
+		}
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
 	const XMLElement& xml;
 	MemBuffer<byte> ram;
+	DirtyPages dirty; // not tracking by default
 	unsigned size; // must come before debuggable
 	const std::unique_ptr<RamDebuggable> debuggable; // can be nullptr
 };
@@ -213,6 +213,20 @@ string_view MemInputArchive::loadStr()
 // semi-arbitrary. I only made it >= 52 so that the (incompressible) RP5C01
 // registers won't be compressed.
 constexpr size_t SMALL_SIZE = 64;
+void MemOutputArchive::serialize_blob(const char* tag, const void* data,
+                                      size_t len, const DirtyPages& dirty)
+{
+	if (len > SMALL_SIZE) {
+		auto deltaBlockIdx = unsigned(deltaBlocks.size());
+		save(deltaBlockIdx); // see comment below in MemInputArchive
+		deltaBlocks.push_back(lastDeltaBlocks.createNew(
+			data, static_cast<const uint8_t*>(data), len,
+			dirty.isTracking() ? &dirty : nullptr));
+	} else {
+		serialize_blob(tag, data, len);
+	}
+}
+
 void MemOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
                                       size_t len, bool diff)
 {
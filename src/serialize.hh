@@ -23,6 +23,7 @@ namespace openmsx {
 
 class LastDeltaBlocks;
 class DeltaBlock;
+class DirtyPages;
 
 // TODO move somewhere in utils once we use this more often
 struct HashPair {
@@ -146,6 +147,15 @@ public:
 	//   type).
 	//
 	//
+	// void serialize_blob(const char* tag, const void* data, size_t len,
+	//                     const DirtyPages& dirty)
+	//
+	//   Same as above, but 'dirty' tells which pages of the blob were
+	//   written since the previous reverse snapshot. Only the in-memory
+	//   (reverse) archive uses this information, the other archives ignore
+	//   it. See Ram::serializeBlob().
+	//
+	//
 	// template<typename T> void serialize(const char* tag, const T& t)
 	//
 	//   This is much like the serializeWithID() method above, but it doesn't
@@ -460,6 +470,11 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const DirtyPages& /*dirty*/)
+	{
+		serialize_blob(tag, data, len);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -555,6 +570,11 @@ public:
 	}
 	void serialize_blob(const char* tag, void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    const DirtyPages& /*dirty*/)
+	{
+		serialize_blob(tag, data, len);
+	}
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -665,6 +685,8 @@ public:
 	void save(const std::string& s);
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const DirtyPages& dirty);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -777,6 +799,11 @@ public:
 	[[nodiscard]] std::string_view loadStr();
 	void serialize_blob(const char* tag, void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    const DirtyPages& /*dirty*/)
+	{
+		serialize_blob(tag, data, len);
+	}
 
 	using InputArchiveBase<MemInputArchive>::serialize;
 	template<typename T, typename ...Args>
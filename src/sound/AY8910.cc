@@ -21,6 +21,7 @@
 #include "one_of.hh"
 #include "outer.hh"
 #include "random.hh"
+#include "ranges.hh"
 #include "xrange.hh"
 #include <cassert>
 #include <cstring>
@@ -678,17 +679,37 @@ void AY8910::wrtReg(unsigned reg, byte value, EmuTime::param time)
 	}
 }
 
+inline bool AY8910::isChannelSilent(unsigned chan) const
+{
+	return (!amplitude.followsEnvelope(chan) &&
+	        (amplitude.getVolume(chan) == 0.0f)) ||
+	       (amplitude.followsEnvelope(chan) &&
+	        !envelope.isChanging() &&
+	        (envelope.getVolume() == 0.0f));
+}
+
+bool AY8910::allChannelsIdle() const
+{
+	return ranges::all_of(xrange(3), [&](auto chan) { return isChannelSilent(chan); });
+}
+
+void AY8910::skipChannels(unsigned num)
+{
+	// Same as generateChannels() with all channels silent.
+	for (auto& t : tone) t.advance(num);
+	noise.advance(num);
+	if (envelope.isChanging()) {
+		envelope.advance(num);
+	}
+}
+
 void AY8910::generateChannels(float** bufs, unsigned num)
 {
 	// Disable channels with volume 0: since the sample value doesn't matter,
 	// we can use the fastest path.
 	unsigned chanEnable = regs[AY_ENABLE];
 	for (auto chan : xrange(3)) {
-		if ((!amplitude.followsEnvelope(chan) &&
-		     (amplitude.getVolume(chan) == 0.0f)) ||
-		    (amplitude.followsEnvelope(chan) &&
-		     !envelope.isChanging() &&
-		     (envelope.getVolume() == 0.0f))) {
+		if (isChannelSilent(chan)) {
 			bufs[chan] = nullptr;
 			tone[chan].advance(num);
 			chanEnable |= 0x09 << chan;
@@ -161,8 +161,12 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool allChannelsIdle() const override;
+	void skipChannels(unsigned num) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
+	[[nodiscard]] inline bool isChannelSilent(unsigned chan) const;
+
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
@@ -30,6 +30,10 @@ public:
 	template<unsigned PITCH>
 	bool readSamples(float* out, unsigned samples);
 
+	// Would readSamples() only produce silence (as long as no new deltas
+	// are added)?
+	[[nodiscard]] bool isMuted() const;
+
 private:
 	template<unsigned PITCH>
 	void readSamplesHelper(float* out, unsigned samples) __restrict;
@@ -1,5 +1,6 @@
 #include "EmuTimer.hh"
 #include "serialize.hh"
+#include "strCat.hh"
 #include <memory>
 
 using std::unique_ptr;
@@ -89,6 +90,11 @@ void EmuTimer::unschedule()
 	removeSyncPoint();
 }
 
+std::string EmuTimer::getProfileName() const
+{
+	return strCat(Schedulable::getProfileName(), ' ', cb.getTimerOwnerName());
+}
+
 void EmuTimer::executeUntil(EmuTime::param time)
 {
 	cb.callback(flag);
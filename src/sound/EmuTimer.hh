@@ -5,6 +5,8 @@
 #include "DynamicClock.hh"
 #include "openmsx.hh"
 #include <memory>
+#include <string>
+#include <string_view>
 
 namespace openmsx {
 
@@ -13,6 +15,10 @@ class EmuTimerCallback
 public:
 	virtual void callback(byte value) = 0;
 
+	/** Name of the device the timer belongs to, used for
+	  * EmuTimer::getProfileName(). */
+	[[nodiscard]] virtual std::string_view getTimerOwnerName() const = 0;
+
 protected:
 	~EmuTimerCallback() = default;
 };
@@ -38,6 +44,8 @@ public:
 	[[nodiscard]] static std::unique_ptr<EmuTimer> createOPL4_2(
 		Scheduler& scheduler, EmuTimerCallback& cb);
 
+	[[nodiscard]] std::string getProfileName() const override;
+
 	void setValue(int value);
 	void setStart(bool start, EmuTime::param time);
 
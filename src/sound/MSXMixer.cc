@@ -14,8 +14,10 @@
 #include "Filename.hh"
 #include "FileOperations.hh"
 #include "CliComm.hh"
+#include "ThreadPool.hh"
 #include "stl.hh"
 #include "aligned.hh"
+#include "enumerate.hh"
 #include "one_of.hh"
 #include "outer.hh"
 #include "ranges.hh"
@@ -27,6 +29,7 @@
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <thread>
 #include <tuple>
 
 #ifdef __SSE2__
@@ -433,36 +436,51 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	VLA_SSE_ALIGNED(float, stereoBuf, 2 * samples + 3);
 	VLA_SSE_ALIGNED(float, tmpBuf,    2 * samples + 3);
 
+	// Devices that were already generated (in parallel) are only mixed
+	// here. Mixing is still done in the same order, so the result is the
+	// same as when all devices are generated in this loop.
+	VLA(float*, generated, infos.size());
+	bool parallel = generateParallel(time, samples, generated);
+	auto updateBuffer = [&](unsigned i, float* buf) {
+		auto& device = *infos[i].device;
+		if (!parallel || !device.canGenerateInParallel()) {
+			return device.updateBuffer(samples, buf, time);
+		}
+		if (!generated[i]) return false;
+		unsigned num = device.isStereo() ? 2 * samples : samples;
+		memcpy(buf, generated[i], num * sizeof(float));
+		return true;
+	};
+
 	constexpr unsigned HAS_MONO_FLAG = 1;
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
-		SoundDevice& device = *info.device;
+	for (auto [i, info] : enumerate(infos)) {
 		auto l1 = info.left1;
 		auto r1 = info.right1;
-		if (!device.isStereo()) {
+		if (!info.device->isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (updateBuffer(i, monoBuf)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulAcc(monoBuf, tmpBuf, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
 					}
 				}
@@ -474,23 +492,23 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0.0f);
 				assert(r1 == 0.0f);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (updateBuffer(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
+					if (updateBuffer(i, tmpBuf)) {
 						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
 					}
 				}
@@ -537,6 +555,50 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	}
 }
 
+bool MSXMixer::generateParallel(EmuTime::param time, unsigned samples,
+                                float** generated)
+{
+	static const bool multiCore = std::thread::hardware_concurrency() > 1;
+	if (!multiCore || (samples < MIN_PARALLEL_SAMPLES)) return false;
+
+	VLA(unsigned, parallelDevices, infos.size());
+	VLA(unsigned, idleDevices, infos.size());
+	unsigned numParallel = 0;
+	unsigned numIdle = 0;
+	for (auto [i, info] : enumerate(infos)) {
+		if (!info.device->canGenerateInParallel()) continue;
+		if (info.device->isIdle()) {
+			idleDevices[numIdle++] = unsigned(i);
+		} else {
+			parallelDevices[numParallel++] = unsigned(i);
+		}
+	}
+	if (numParallel < 2) return false;
+
+	// Room for stereo, +3 to process samples in groups of 4, and rounded
+	// up to keep each buffer SSE aligned.
+	unsigned pitch = (2 * samples + 3 + 3) & ~3;
+	size_t size = size_t(numParallel) * pitch;
+	if (parallelBufferSize < size) {
+		parallelBufferSize = size;
+		parallelBuffer.resize(size);
+	}
+	// Idle devices only advance their state, that's not worth a task.
+	for (auto i : xrange(numIdle)) {
+		auto& device = *infos[idleDevices[i]].device;
+		bool notSilent = device.updateBuffer(samples, parallelBuffer.data(), time);
+		assert(!notSilent); (void)notSilent;
+		generated[idleDevices[i]] = nullptr;
+	}
+	ThreadPool::instance().parallelFor(numParallel, [&](unsigned j) {
+		unsigned i = parallelDevices[j];
+		float* buf = &parallelBuffer[j * pitch];
+		generated[i] = infos[i].device->updateBuffer(samples, buf, time)
+		             ? buf : nullptr;
+	});
+	return true;
+}
+
 bool MSXMixer::needStereoRecording() const
 {
 	return ranges::any_of(infos, [](auto& info) {
@@ -6,6 +6,8 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
+#include "aligned.hh"
 #include <vector>
 #include <memory>
 
@@ -135,6 +137,15 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(float* output, EmuTime::param time, unsigned samples);
+	/** Generate the samples of all devices that support it (see
+	  * SoundDevice::enableParallelGeneration()) on the ThreadPool. Idle
+	  * ones (see SoundDevice::isIdle()) are still updated on this thread.
+	  * @param generated Per device: the generated samples, or nullptr when
+	  *                  they are all zero.
+	  * @result false iff nothing was generated (e.g. too few samples)
+	  */
+	[[nodiscard]] bool generateParallel(EmuTime::param time, unsigned samples,
+	                                    float** generated);
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -150,6 +161,12 @@ private:
 	void changeMuteSetting(const Setting& setting);
 
 private:
+	/** Only generate the sound devices in parallel for updates of at least
+	  * this many samples, for smaller updates the synchronization costs
+	  * more than it gains.
+	  */
+	static constexpr unsigned MIN_PARALLEL_SAMPLES = 64;
+
 	unsigned fragmentSize;
 	unsigned hostSampleRate; // requested freq by sound driver,
 	                         // not compensated for speed
@@ -166,6 +183,9 @@ private:
 
 	DynamicClock prevTime;
 
+	MemBuffer<float, SSE_ALIGNMENT> parallelBuffer; // see generateParallel()
+	size_t parallelBufferSize = 0;
+
 	struct SoundDeviceInfoTopic final : InfoTopic {
 		explicit SoundDeviceInfoTopic(InfoCommand& machineInfoCommand);
 		void execute(span<const TclObject> tokens,
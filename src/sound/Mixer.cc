@@ -4,8 +4,11 @@
 #include "SDLSoundDriver.hh"
 #include "CommandController.hh"
 #include "CliComm.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
 #include "MSXException.hh"
 #include "one_of.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -47,11 +50,17 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, latencySetting(
+		commandController, "sound_latency",
+		"target latency of the sound output in milliseconds, "
+		"0 means three times the 'samples' setting", 0, 0, 1000)
+	, soundBufferInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
 	samplesSetting    .attach(*this);
+	latencySetting    .attach(*this);
 	soundDriverSetting.attach(*this);
 
 	// Set correct initial mute state.
@@ -66,6 +75,7 @@ Mixer::~Mixer()
 	driver.reset();
 
 	soundDriverSetting.detach(*this);
+	latencySetting    .detach(*this);
 	samplesSetting    .detach(*this);
 	frequencySetting  .detach(*this);
 	muteSetting       .detach(*this);
@@ -88,7 +98,8 @@ void Mixer::reloadDriver()
 			driver = std::make_unique<SDLSoundDriver>(
 				reactor,
 				frequencySetting.getInt(),
-				samplesSetting.getInt());
+				samplesSetting.getInt(),
+				latencySetting.getInt());
 			break;
 		default:
 			UNREACHABLE;
@@ -161,11 +172,43 @@ void Mixer::update(const Setting& setting) noexcept
 		} else {
 			unmute();
 		}
-	} else if (&setting == one_of(&samplesSetting, &soundDriverSetting, &frequencySetting)) {
+	} else if (&setting == one_of(&samplesSetting, &soundDriverSetting, &frequencySetting,
+	                                 &latencySetting)) {
 		reloadDriver();
 	} else {
 		UNREACHABLE;
 	}
 }
 
+
+// class SoundBufferInfoTopic
+
+Mixer::SoundBufferInfoTopic::SoundBufferInfoTopic(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_buffer")
+{
+}
+
+void Mixer::SoundBufferInfoTopic::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, soundBufferInfo);
+	auto stats = mixer.driver->getBufferStats();
+	result.addDictKeyValues("latency",          stats.latency,
+	                        "min_latency",      stats.minLatency,
+	                        "target_latency",   stats.targetLatency,
+	                        "buffer_size",      stats.bufferSize,
+	                        "frequency",        mixer.driver->getFrequency(),
+	                        "underruns",        stats.underruns,
+	                        "underrun_samples", stats.underrunSamples,
+	                        "dropped_samples",  stats.droppedSamples,
+	                        "waits",            stats.waits);
+}
+
+std::string Mixer::SoundBufferInfoTopic::help(span<const TclObject> /*tokens*/) const
+{
+	return "Shows the fill level and underrun statistics of the sound "
+	       "output buffer, counted since the sound was last unmuted. "
+	       "Latencies and sizes are in samples.\n";
+}
+
 } // namespace openmsx
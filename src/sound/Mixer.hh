@@ -5,6 +5,7 @@
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
+#include "InfoTopic.hh"
 #include <vector>
 #include <memory>
 
@@ -66,6 +67,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting latencySetting;
+
+	struct SoundBufferInfoTopic final : InfoTopic {
+		explicit SoundBufferInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} soundBufferInfo;
 
 	int muteCount;
 };
@@ -1,12 +1,28 @@
 #ifndef RESAMPLEALGO_HH
 #define RESAMPLEALGO_HH
 
+#include "DynamicClock.hh"
 #include "EmuTime.hh"
-#include "ResampledSoundDevice.hh"
+#include <cassert>
 
 namespace openmsx {
 
-class DynamicClock;
+/** The samples that are resampled (normally a ResampledSoundDevice).
+  */
+class ResampleInput
+{
+public:
+	/** Generate 'num' (mono or interleaved stereo) samples.
+	  * @see ResampledSoundDevice::generateInput()
+	  */
+	virtual bool generateInput(float* buffer, unsigned num) = 0;
+
+	/** Time of the last generated sample, ticks once per sample. */
+	[[nodiscard]] virtual DynamicClock& getEmuClock() = 0;
+
+protected:
+	~ResampleInput() = default;
+};
 
 class ResampleAlgo
 {
@@ -22,14 +38,20 @@ public:
 		return result;
 	}
 
+	/** Has all (non-silent) input been processed? IOW as long as the
+	  * input stays silent, does the output stay silent as well?
+	  * See ResampledSoundDevice::isIdle().
+	  */
+	[[nodiscard]] virtual bool isDrained() const = 0;
+
 protected:
-	ResampleAlgo(ResampledSoundDevice& input_) : input(input_) {}
+	ResampleAlgo(ResampleInput& input_) : input(input_) {}
 	[[nodiscard]] DynamicClock& getEmuClock() const { return input.getEmuClock(); }
 	virtual bool generateOutputImpl(float* dataOut, unsigned num,
 	                                EmuTime::param time) = 0;
 
 protected:
-	ResampledSoundDevice& input;
+	ResampleInput& input;
 };
 
 } // namespace openmsx
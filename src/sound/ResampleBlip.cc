@@ -1,5 +1,4 @@
 #include "ResampleBlip.hh"
-#include "ResampledSoundDevice.hh"
 #include "likely.hh"
 #include "one_of.hh"
 #include "ranges.hh"
@@ -11,7 +10,7 @@ namespace openmsx {
 
 template<unsigned CHANNELS>
 ResampleBlip<CHANNELS>::ResampleBlip(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
+		ResampleInput& input_, const DynamicClock& hostClock_)
 	: ResampleAlgo(input_)
 	, hostClock(hostClock_)
 	, step([&]{ // calculate 'hostClock.getFreq() / getEmuClock().getFreq()', but with less rounding errors
@@ -106,6 +105,14 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, unsigned hostNum
 	}
 }
 
+template<unsigned CHANNELS>
+bool ResampleBlip<CHANNELS>::isDrained() const
+{
+	return ranges::all_of(xrange(CHANNELS), [&](auto ch) {
+		return (lastInput[ch] == 0.0f) && blip[ch].isMuted();
+	});
+}
+
 // Force template instantiation.
 template class ResampleBlip<1>;
 template class ResampleBlip<2>;
@@ -7,16 +7,16 @@
 namespace openmsx {
 
 class DynamicClock;
-class ResampledSoundDevice;
 
 template<unsigned CHANNELS>
 class ResampleBlip final : public ResampleAlgo
 {
 public:
-	ResampleBlip(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	ResampleBlip(ResampleInput& input, const DynamicClock& hostClock);
 
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	[[nodiscard]] bool isDrained() const override;
 
 private:
 	BlipBuffer blip[CHANNELS];
@@ -10,7 +10,6 @@
 //     (e.g. remove all error checking)
 
 #include "ResampleHQ.hh"
-#include "ResampledSoundDevice.hh"
 #include "FixedPoint.hh"
 #include "MemBuffer.hh"
 #include "aligned.hh"
@@ -20,13 +19,16 @@
 #include "vla.hh"
 #include "xrange.hh"
 #include "build-info.hh"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <cassert>
 #include <iterator>
-#ifdef __SSE2__
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #endif
 
@@ -58,6 +60,9 @@ public:
 	void releaseCoeffs(double ratio);
 
 private:
+	// Number of tables that are kept while not in use (see releaseCoeffs()).
+	static constexpr int MAX_UNUSED = 8;
+
 	using Table = MemBuffer<float, SSE_ALIGNMENT>;
 	using PermuteTable = MemBuffer<int16_t>;
 
@@ -73,12 +78,12 @@ private:
 		unsigned filterLen;
 		unsigned count;
 	};
-	std::vector<Element> cache; // typically 1-4 entries -> unsorted vector
+	std::vector<Element> cache; // typically 1-12 entries -> unsorted vector
 };
 
 ResampleCoeffs::~ResampleCoeffs()
 {
-	assert(cache.empty());
+	assert(ranges::all_of(cache, [](auto& e) { return e.count == 0; }));
 }
 
 ResampleCoeffs& ResampleCoeffs::instance()
@@ -114,7 +119,15 @@ void ResampleCoeffs::releaseCoeffs(double ratio)
 	auto it = rfind_unguarded(cache, ratio, &Element::ratio);
 	it->count--;
 	if (it->count == 0) {
-		move_pop_back(cache, it);
+		// Calculating a table takes a while, and the same ratios are
+		// often needed again soon (e.g. each change of the emulation
+		// speed recreates all resamplers). So keep the table, but move
+		// it to the back: the first unused ones are the oldest.
+		std::rotate(it, it + 1, end(cache));
+		auto unused = [](auto& e) { return e.count == 0; };
+		if (ranges::count_if(cache, unused) > MAX_UNUSED) {
+			cache.erase(ranges::find_if(cache, unused));
+		}
 	}
 }
 
@@ -371,26 +384,13 @@ ResampleCoeffs::Table ResampleCoeffs::calcTable(
 }
 
 
-template<unsigned CHANNELS>
-ResampleHQ<CHANNELS>::ResampleHQ(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
-	: ResampleAlgo(input_)
-	, hostClock(hostClock_)
-	, ratio(float(hostClock.getPeriod().toDouble() / getEmuClock().getPeriod().toDouble()))
+ResampleHQFilter::ResampleHQFilter(float ratio_)
+	: ratio(ratio_)
 {
 	ResampleCoeffs::instance().getCoeffs(double(ratio), permute, table, filterLen);
-
-	// fill buffer with 'enough' zero's
-	unsigned extra = int(filterLen + 1 + ratio + 1);
-	bufStart = 0;
-	bufEnd   = extra;
-	nonzeroSamples = 0;
-	unsigned initialSize = 4000; // buffer grows dynamically if this is too small
-	buffer.resize((initialSize + extra) * CHANNELS); // zero-initialized
 }
 
-template<unsigned CHANNELS>
-ResampleHQ<CHANNELS>::~ResampleHQ()
+ResampleHQFilter::~ResampleHQFilter()
 {
 	ResampleCoeffs::instance().releaseCoeffs(double(ratio));
 }
@@ -524,24 +524,104 @@ static inline void calcSseStereo(const float* buf_, const float* tab_, size_t le
 
 #endif
 
-template<unsigned CHANNELS>
-void ResampleHQ<CHANNELS>::calcOutput(
-	float pos, float* __restrict output)
+#ifdef __AVX2__
+// Same as the SSE2 versions above, but 8 coefficients at a time (the table
+// rows are a multiple of 4 long, so there's possibly a tail of 4).
+static inline __m256 mulAdd(__m256 a, __m256 b, __m256 acc)
 {
-	assert((filterLen & 3) == 0);
+#ifdef __FMA__
+	return _mm256_fmadd_ps(a, b, acc);
+#else
+	return _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+#endif
+}
+
+template<bool REVERSE>
+static inline void calcAvxMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	auto loadTab = [&](size_t i) {
+		return REVERSE ? _mm256_permutevar8x32_ps(_mm256_loadu_ps(tab - i - 8), rev)
+		               : _mm256_loadu_ps(tab + i);
+	};
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 16) <= len; i += 16) {
+		a0 = mulAdd(_mm256_loadu_ps(buf + i + 0), loadTab(i + 0), a0);
+		a1 = mulAdd(_mm256_loadu_ps(buf + i + 8), loadTab(i + 8), a1);
+	}
+	if (len & 8) {
+		a0 = mulAdd(_mm256_loadu_ps(buf + i), loadTab(i), a0);
+		i += 8;
+	}
+	__m256 a8 = _mm256_add_ps(a0, a1);
+	__m128 a = _mm_add_ps(_mm256_castps256_ps128(a8), _mm256_extractf128_ps(a8, 1));
+	if (len & 4) {
+		__m128 t0 = REVERSE ? _mm_loadr_ps(tab - i - 4) : _mm_load_ps(tab + i);
+		a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(buf + i), t0));
+	}
+	__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	__m128 s = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+	_mm_store_ss(out, s);
+}
 
-	int bufIdx = int(pos) + bufStart;
-	assert((bufIdx + filterLen) <= bufEnd);
-	bufIdx *= CHANNELS;
-	const float* buf = &buffer[bufIdx];
+template<bool REVERSE>
+static inline void calcAvxStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	// Each coefficient is used for a left and a right sample.
+	const __m256i lo = REVERSE ? _mm256_setr_epi32(7, 7, 6, 6, 5, 5, 4, 4)
+	                           : _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256i hi = REVERSE ? _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0)
+	                           : _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 8) <= len; i += 8) {
+		__m256 t = _mm256_loadu_ps(REVERSE ? (tab - i - 8) : (tab + i));
+		a0 = mulAdd(_mm256_loadu_ps(buf + 2 * i + 0), _mm256_permutevar8x32_ps(t, lo), a0);
+		a1 = mulAdd(_mm256_loadu_ps(buf + 2 * i + 8), _mm256_permutevar8x32_ps(t, hi), a1);
+	}
+	if (len & 4) {
+		// only the low 4 elements of 't' are used
+		__m256 t = _mm256_castps128_ps256(REVERSE ? _mm_loadr_ps(tab - i - 4)
+		                                          : _mm_load_ps (tab + i));
+		const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+		a0 = mulAdd(_mm256_loadu_ps(buf + 2 * i), _mm256_permutevar8x32_ps(t, dup), a0);
+	}
+	__m256 a8 = _mm256_add_ps(a0, a1);
+	__m128 a = _mm_add_ps(_mm256_castps256_ps128(a8), _mm256_extractf128_ps(a8, 1));
+	__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], shuffle<0x55>(s));
+}
+#endif
 
+// Calculate one output sample, 'buf' points to the first input sample that
+// contributes to it.
+template<unsigned CHANNELS>
+static inline void calcOutput(
+	const float* buf, const float* table, const int16_t* permute,
+	unsigned filterLen, float pos, float* __restrict output)
+{
 	int t = unsigned(lrintf(pos * TAB_LEN)) % TAB_LEN;
 	if (!(t & HALF_TAB_LEN)) {
 		// first half, begin of row 't'
 		t = permute[t];
 		const float* tab = &table[t * filterLen];
 
-#ifdef __SSE2__
+#ifdef __AVX2__
+		if constexpr (CHANNELS == 1) {
+			calcAvxMono  <false>(buf, tab, filterLen, output);
+		} else {
+			calcAvxStereo<false>(buf, tab, filterLen, output);
+		}
+		return;
+#elif defined(__SSE2__)
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <false>(buf, tab, filterLen, output);
 		} else {
@@ -570,7 +650,14 @@ void ResampleHQ<CHANNELS>::calcOutput(
 		t = permute[TAB_LEN - 1 - t];
 		const float* tab = &table[(t + 1) * filterLen];
 
-#ifdef __SSE2__
+#ifdef __AVX2__
+		if constexpr (CHANNELS == 1) {
+			calcAvxMono  <true>(buf, tab, filterLen, output);
+		} else {
+			calcAvxStereo<true>(buf, tab, filterLen, output);
+		}
+		return;
+#elif defined(__SSE2__)
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <true>(buf, tab, filterLen, output);
 		} else {
@@ -597,6 +684,61 @@ void ResampleHQ<CHANNELS>::calcOutput(
 	}
 }
 
+template<unsigned CHANNELS>
+void ResampleHQFilter::calcOutputs(
+	const float* buf, float pos, float* __restrict output, unsigned num) const
+{
+	assert((filterLen & 3) == 0);
+	// Process the whole block in one go, with the table parameters in
+	// local variables (they can't alias the output).
+	const float* tab = table;
+	const int16_t* perm = permute;
+	unsigned len = filterLen;
+	float r = ratio;
+	for (auto i : xrange(num)) {
+		calcOutput<CHANNELS>(&buf[int(pos) * CHANNELS], tab, perm, len,
+		                     pos, &output[i * CHANNELS]);
+		pos += r;
+	}
+}
+
+void ResampleHQFilter::getCoeffs(float pos, float* coeffs) const
+{
+	// same row selection as calcOutput()
+	int t = unsigned(lrintf(pos * TAB_LEN)) % TAB_LEN;
+	if (!(t & HALF_TAB_LEN)) {
+		const float* tab = &table[permute[t] * filterLen];
+		for (auto i : xrange(filterLen)) coeffs[i] = tab[i];
+	} else {
+		const float* tab = &table[(permute[TAB_LEN - 1 - t] + 1) * filterLen];
+		for (auto i : xrange(filterLen)) coeffs[i] = tab[-int(i) - 1];
+	}
+}
+
+// Force template instantiation.
+template void ResampleHQFilter::calcOutputs<1>(const float*, float, float*, unsigned) const;
+template void ResampleHQFilter::calcOutputs<2>(const float*, float, float*, unsigned) const;
+
+
+template<unsigned CHANNELS>
+ResampleHQ<CHANNELS>::ResampleHQ(
+		ResampleInput& input_, const DynamicClock& hostClock_)
+	: ResampleAlgo(input_)
+	, hostClock(hostClock_)
+	, filter(float(hostClock.getPeriod().toDouble() / getEmuClock().getPeriod().toDouble()))
+{
+	// fill buffer with 'enough' zero's
+	unsigned extra = int(filter.getFilterLen() + 1 + filter.getRatio() + 1);
+	bufStart = 0;
+	bufEnd   = extra;
+	nonzeroSamples = 0;
+	unsigned initialSize = 4000; // buffer grows dynamically if this is too small
+	buffer.resize((initialSize + extra) * CHANNELS); // zero-initialized
+}
+
+template<unsigned CHANNELS>
+ResampleHQ<CHANNELS>::~ResampleHQ() = default;
+
 template<unsigned CHANNELS>
 void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 {
@@ -656,11 +798,9 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 		EmuTime host1 = hostClock.getFastAdd(1);
 		assert(host1 > emuClk.getTime());
 		float pos = emuClk.getTicksTillDouble(host1);
-		assert(pos <= (ratio + 2));
-		for (auto i : xrange(hostNum)) {
-			calcOutput(pos, &dataOut[i * CHANNELS]);
-			pos += ratio;
-		}
+		assert(pos <= (filter.getRatio() + 2));
+		filter.calcOutputs<CHANNELS>(&buffer[bufStart * CHANNELS], pos,
+		                             dataOut, hostNum);
 	}
 	emuClk += emuNum;
 	bufStart += emuNum;
@@ -668,7 +808,7 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 
 	assert(bufStart <= bufEnd);
 	unsigned available = bufEnd - bufStart;
-	unsigned extra = int(filterLen + 1 + ratio + 1);
+	unsigned extra = int(filter.getFilterLen() + 1 + filter.getRatio() + 1);
 	assert(available == extra); (void)available; (void)extra;
 
 	return notMuted;
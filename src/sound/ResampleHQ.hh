@@ -8,34 +8,78 @@
 namespace openmsx {
 
 class DynamicClock;
-class ResampledSoundDevice;
+
+/** The band limited (polyphase) filter used by ResampleHQ, for one fixed
+  * resample ratio. The coefficient tables are shared between all filters
+  * with the same ratio, and remain cached for a while after the last filter
+  * that used them is gone (e.g. toggling fast-forward switches between a
+  * few ratios).
+  */
+class ResampleHQFilter
+{
+public:
+	/** @param ratio Number of input samples per output sample. */
+	explicit ResampleHQFilter(float ratio);
+	~ResampleHQFilter();
+	ResampleHQFilter(const ResampleHQFilter&) = delete;
+	ResampleHQFilter& operator=(const ResampleHQFilter&) = delete;
+
+	[[nodiscard]] float getRatio() const { return ratio; }
+
+	/** Number of input samples that contribute to one output sample.
+	  * Always a multiple of 4.
+	  */
+	[[nodiscard]] unsigned getFilterLen() const { return filterLen; }
+
+	/** Calculate a block of output samples.
+	  * @param buf Input samples (for stereo: interleaved left and right).
+	  * @param pos Position in 'buf' of the first output sample. The next
+	  *            output samples are each 'ratio' further.
+	  * @param output Buffer for 'num' output samples.
+	  * @param num Number of output samples.
+	  * Output sample 'i' uses the input samples starting at index
+	  * 'int(pos + i * ratio)' (with 'pos' accumulated as a float), 'buf'
+	  * must contain 'getFilterLen()' samples from there on.
+	  */
+	template<unsigned CHANNELS>
+	void calcOutputs(const float* buf, float pos, float* output, unsigned num) const;
+
+	/** The 'getFilterLen()' coefficients that calcOutputs() multiplies
+	  * with the input samples for an output sample at position 'pos'.
+	  * Only meant to verify the (SIMD) calculations.
+	  */
+	void getCoeffs(float pos, float* coeffs) const;
+
+private:
+	const float ratio;
+	unsigned filterLen;
+	float* table;
+	int16_t* permute;
+};
 
 template<unsigned CHANNELS>
 class ResampleHQ final : public ResampleAlgo
 {
 public:
-	ResampleHQ(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	ResampleHQ(ResampleInput& input, const DynamicClock& hostClock);
 	~ResampleHQ() override;
 	ResampleHQ(const ResampleHQ&) = delete;
 	ResampleHQ& operator=(const ResampleHQ&) = delete;
 
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	[[nodiscard]] bool isDrained() const override { return nonzeroSamples == 0; }
 
 private:
-	void calcOutput(float pos, float* output);
 	void prepareData(unsigned emuNum);
 
 private:
 	const DynamicClock& hostClock;
-	const float ratio;
+	const ResampleHQFilter filter;
 	unsigned bufStart;
 	unsigned bufEnd;
 	unsigned nonzeroSamples;
-	unsigned filterLen;
 	std::vector<float> buffer;
-	float* table;
-	int16_t* permute;
 };
 
 } // namespace openmsx
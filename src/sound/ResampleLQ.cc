@@ -1,5 +1,4 @@
 #include "ResampleLQ.hh"
-#include "ResampledSoundDevice.hh"
 #include "likely.hh"
 #include "ranges.hh"
 #include "xrange.hh"
@@ -10,16 +9,17 @@
 
 namespace openmsx {
 
-// 16-byte aligned buffer of ints (shared among all instances of this resampler)
-static std::vector<float> bufferStorage; // (possibly) unaligned storage
-static unsigned bufferSize = 0; // usable buffer size (aligned portion)
-static float* aBuffer = nullptr; // pointer to aligned sub-buffer
+// 16-byte aligned buffer of ints (shared among all instances of this resampler
+// on the same thread, see SoundDevice::enableParallelGeneration())
+static thread_local std::vector<float> bufferStorage; // (possibly) unaligned storage
+static thread_local unsigned bufferSize = 0; // usable buffer size (aligned portion)
+static thread_local float* aBuffer = nullptr; // pointer to aligned sub-buffer
 
 ////
 
 template<unsigned CHANNELS>
 std::unique_ptr<ResampleLQ<CHANNELS>> ResampleLQ<CHANNELS>::create(
-		ResampledSoundDevice& input, const DynamicClock& hostClock)
+		ResampleInput& input, const DynamicClock& hostClock)
 {
 	std::unique_ptr<ResampleLQ<CHANNELS>> result;
 	if (input.getEmuClock().getPeriod() >= hostClock.getPeriod()) {
@@ -32,7 +32,7 @@ std::unique_ptr<ResampleLQ<CHANNELS>> ResampleLQ<CHANNELS>::create(
 
 template<unsigned CHANNELS>
 ResampleLQ<CHANNELS>::ResampleLQ(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
+		ResampleInput& input_, const DynamicClock& hostClock_)
 	: ResampleAlgo(input_)
 	, hostClock(hostClock_)
 	, step([&]{ // calculate 'getEmuClock().getFreq() / hostClock.getFreq()', but with less rounding errors
@@ -52,6 +52,13 @@ ResampleLQ<CHANNELS>::ResampleLQ(
 	return std::abs(x) < threshold;
 }
 
+template<unsigned CHANNELS>
+bool ResampleLQ<CHANNELS>::isDrained() const
+{
+	// see fetchData()
+	return ranges::all_of(lastInput, [](auto& l) { return isSilent(l); });
+}
+
 template<unsigned CHANNELS>
 bool ResampleLQ<CHANNELS>::fetchData(EmuTime::param time, unsigned& valid)
 {
@@ -96,7 +103,7 @@ bool ResampleLQ<CHANNELS>::fetchData(EmuTime::param time, unsigned& valid)
 
 template<unsigned CHANNELS>
 ResampleLQUp<CHANNELS>::ResampleLQUp(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
+		ResampleInput& input_, const DynamicClock& hostClock_)
 	: ResampleLQ<CHANNELS>(input_, hostClock_)
 {
 	assert(input_.getEmuClock().getFreq() <= hostClock_.getFreq()); // only upsampling
@@ -136,7 +143,7 @@ bool ResampleLQUp<CHANNELS>::generateOutputImpl(
 
 template<unsigned CHANNELS>
 ResampleLQDown<CHANNELS>::ResampleLQDown(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
+		ResampleInput& input_, const DynamicClock& hostClock_)
 	: ResampleLQ<CHANNELS>(input_, hostClock_)
 {
 	assert(input_.getEmuClock().getFreq() >= hostClock_.getFreq()); // can only do downsampling
@@ -8,17 +8,18 @@
 namespace openmsx {
 
 class DynamicClock;
-class ResampledSoundDevice;
 
 template<unsigned CHANNELS>
 class ResampleLQ : public ResampleAlgo
 {
 public:
 	static std::unique_ptr<ResampleLQ<CHANNELS>> create(
-		ResampledSoundDevice& input, const DynamicClock& hostClock);
+		ResampleInput& input, const DynamicClock& hostClock);
+
+	[[nodiscard]] bool isDrained() const override;
 
 protected:
-	ResampleLQ(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	ResampleLQ(ResampleInput& input, const DynamicClock& hostClock);
 	[[nodiscard]] bool fetchData(EmuTime::param time, unsigned& valid);
 
 protected:
@@ -32,7 +33,7 @@ template<unsigned CHANNELS>
 class ResampleLQDown final : public ResampleLQ<CHANNELS>
 {
 public:
-	ResampleLQDown(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	ResampleLQDown(ResampleInput& input, const DynamicClock& hostClock);
 private:
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
@@ -43,7 +44,7 @@ template<unsigned CHANNELS>
 class ResampleLQUp final : public ResampleLQ<CHANNELS>
 {
 public:
-	ResampleLQUp(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	ResampleLQUp(ResampleInput& input, const DynamicClock& hostClock);
 private:
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
@@ -1,10 +1,9 @@
 #include "ResampleTrivial.hh"
-#include "ResampledSoundDevice.hh"
 #include <cassert>
 
 namespace openmsx {
 
-ResampleTrivial::ResampleTrivial(ResampledSoundDevice& input_)
+ResampleTrivial::ResampleTrivial(ResampleInput& input_)
 	: ResampleAlgo(input_)
 {
 }
@@ -5,14 +5,14 @@
 
 namespace openmsx {
 
-class ResampledSoundDevice;
 
 class ResampleTrivial final : public ResampleAlgo
 {
 public:
-	explicit ResampleTrivial(ResampledSoundDevice& input);
+	explicit ResampleTrivial(ResampleInput& input);
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	[[nodiscard]] bool isDrained() const override { return true; }
 };
 
 } // namespace openmsx
@@ -7,8 +7,13 @@
 #include "Reactor.hh"
 #include "GlobalSettings.hh"
 #include "EnumSetting.hh"
+#include "serialize.hh"
+#include "serialize_stl.hh"
 #include "unreachable.hh"
+#include "vla.hh"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <memory>
 
 namespace openmsx {
@@ -21,6 +26,7 @@ ResampledSoundDevice::ResampledSoundDevice(
 	              channels, inputSampleRate_, stereo_)
 	, resampleSetting(motherBoard.getReactor().getGlobalSettings().getResampleSetting())
 	, emuClock(EmuTime::zero())
+	, writeClock(EmuTime::zero())
 {
 	resampleSetting.attach(*this);
 }
@@ -39,12 +45,87 @@ void ResampledSoundDevice::setOutputRate(unsigned /*sampleRate*/)
 bool ResampledSoundDevice::updateBuffer(unsigned length, float* buffer,
                                         EmuTime::param time)
 {
+	if (isIdle()) {
+		// Nothing to resample, only advance the state of the device.
+		unsigned num = emuClock.getTicksTill(time);
+		skipChannels(num);
+		emuClock += num;
+		return false;
+	}
+
+	// The resample algorithms don't all advance emuClock at the same
+	// moment, so remember where the input they request starts.
+	if (!deferredWrites.empty()) writeClock = emuClock;
 	return algo->generateOutput(buffer, length, time);
 }
 
+bool ResampledSoundDevice::isIdle() const
+{
+	// Queued writes may end the idle state halfway, and the resampler
+	// may still have to output the tail of earlier input.
+	return deferredWrites.empty() && algo->isDrained() && canSkipChannels();
+}
+
 bool ResampledSoundDevice::generateInput(float* buffer, unsigned num)
 {
-	return mixChannels(buffer, num);
+	if (deferredWrites.empty()) {
+		return mixChannels(buffer, num);
+	}
+
+	// Generate the samples in parts, apply the queued writes in between.
+	unsigned channels = isStereo() ? 2 : 1;
+	bool result = false;
+	unsigned done = 0;
+	auto generatePart = [&](unsigned end) {
+		if (end == done) return;
+		unsigned n = end - done;
+		VLA_SSE_ALIGNED(float, tmp, n * channels + 3);
+		float* dst = &buffer[done * channels];
+		if (mixChannels(tmp, n)) {
+			memcpy(dst, tmp, n * channels * sizeof(float));
+			result = true;
+		} else {
+			memset(dst, 0, n * channels * sizeof(float));
+		}
+		done = end;
+	};
+
+	auto it = begin(deferredWrites);
+	for (/**/; it != end(deferredWrites); ++it) {
+		unsigned pos = 0;
+		float fraction = 0.0f;
+		if (it->time > writeClock.getTime()) {
+			auto [integral, fractional] = writeClock.getTicksTillAsIntFloat(it->time);
+			if (integral > num) break;
+			pos = integral;
+			fraction = fractional;
+		}
+		generatePart(std::max(pos, done));
+		applyDeferredWrite(it->reg, it->value, it->time, fraction);
+	}
+	deferredWrites.erase(begin(deferredWrites), it);
+	generatePart(num);
+	writeClock += num;
+	return result;
+}
+
+void ResampledSoundDevice::deferWrite(unsigned reg, uint8_t value, EmuTime::param time)
+{
+	assert(deferredWrites.empty() || (deferredWrites.back().time <= time));
+	deferredWrites.push_back({time, reg, value});
+}
+
+void ResampledSoundDevice::applyDeferredWrite(
+	unsigned /*reg*/, uint8_t /*value*/, EmuTime::param /*time*/, float /*fraction*/)
+{
+	UNREACHABLE; // only called for devices that use deferWrite()
+}
+
+void ResampledSoundDevice::flushDeferredWrites(EmuTime::param time)
+{
+	if (!deferredWrites.empty()) {
+		updateStream(time);
+	}
 }
 
 
@@ -57,6 +138,13 @@ void ResampledSoundDevice::update(const Setting& setting) noexcept
 
 void ResampledSoundDevice::createResampler()
 {
+	// The queued writes can't be positioned relative to the new clock,
+	// apply them right away.
+	for (const auto& w : deferredWrites) {
+		applyDeferredWrite(w.reg, w.value, w.time, 0.0f);
+	}
+	deferredWrites.clear();
+
 	const DynamicClock& hostClock = getHostSampleClock();
 	EmuDuration outputPeriod = hostClock.getPeriod();
 	EmuDuration inputPeriod(getEffectiveSpeed() / double(getInputRate()));
@@ -94,4 +182,23 @@ void ResampledSoundDevice::createResampler()
 	}
 }
 
+template<typename Archive>
+void ResampledSoundDevice::DeferredWrite::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("time",  time,
+	             "reg",   reg,
+	             "value", value);
+}
+INSTANTIATE_SERIALIZE_METHODS(ResampledSoundDevice::DeferredWrite);
+
+template<typename Archive>
+void ResampledSoundDevice::serializeDeferredWrites(Archive& ar)
+{
+	ar.serialize("deferredWrites", deferredWrites);
+}
+template void ResampledSoundDevice::serializeDeferredWrites(MemInputArchive&);
+template void ResampledSoundDevice::serializeDeferredWrites(MemOutputArchive&);
+template void ResampledSoundDevice::serializeDeferredWrites(XmlInputArchive&);
+template void ResampledSoundDevice::serializeDeferredWrites(XmlOutputArchive&);
+
 } // namespace openmsx
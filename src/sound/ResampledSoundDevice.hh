@@ -2,18 +2,21 @@
 #define RESAMPLEDSOUNDDEVICE_HH
 
 #include "SoundDevice.hh"
+#include "ResampleAlgo.hh"
 #include "DynamicClock.hh"
 #include "Observer.hh"
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
-class ResampleAlgo;
 class Setting;
 template<typename T> class EnumSetting;
 
-class ResampledSoundDevice : public SoundDevice, protected Observer<Setting>
+class ResampledSoundDevice : public SoundDevice, public ResampleInput
+                           , protected Observer<Setting>
 {
 public:
 	enum ResampleType { RESAMPLE_HQ, RESAMPLE_LQ, RESAMPLE_BLIP };
@@ -22,9 +25,21 @@ public:
 	  * allowed to generate up to 3 extra sample.
 	  * @see SoundDevice::updateBuffer()
 	  */
-	bool generateInput(float* buffer, unsigned num);
+	bool generateInput(float* buffer, unsigned num) override;
 
-	[[nodiscard]] DynamicClock& getEmuClock() { return emuClock; }
+	[[nodiscard]] DynamicClock& getEmuClock() override { return emuClock; }
+
+	/** A register write that is applied while generating the samples.
+	  * @see deferWrite()
+	  */
+	struct DeferredWrite {
+		EmuTime time = EmuTime::zero();
+		unsigned reg = 0;
+		uint8_t value = 0;
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
 
 protected:
 	ResampledSoundDevice(MSXMotherBoard& motherBoard, std::string_view name,
@@ -36,17 +51,47 @@ protected:
 	void setOutputRate(unsigned sampleRate) override;
 	bool updateBuffer(unsigned length, float* buffer,
 	                  EmuTime::param time) override;
+	[[nodiscard]] bool isIdle() const override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
 	void createResampler();
 
+	/** Queue a write to a register that only influences the generated
+	  * sound, instead of calling updateStream() and applying it directly.
+	  * updateStream() generates the samples of _all_ sound devices up to
+	  * 'time', so for chips that are written often that means many small
+	  * (and serial) updates. The queued writes are instead applied (via
+	  * applyDeferredWrite()) while generating the samples of this device,
+	  * exactly in between the samples before and after 'time'. So the
+	  * result is the same, also when the samples are generated on a
+	  * worker thread (see MSXMixer::generate()).
+	  * Reading back chip state that is changed by these writes requires a
+	  * call to flushDeferredWrites() first.
+	  */
+	void deferWrite(unsigned reg, uint8_t value, EmuTime::param time);
+
+	/** Apply a write that was queued with deferWrite().
+	  * @param fraction Position of the write in between the previous and
+	  *                 the next generated sample, in range [0, 1).
+	  */
+	virtual void applyDeferredWrite(unsigned reg, uint8_t value,
+	                                EmuTime::param time, float fraction);
+
+	/** Make sure all queued writes up to 'time' have been applied. */
+	void flushDeferredWrites(EmuTime::param time);
+
+	template<typename Archive>
+	void serializeDeferredWrites(Archive& ar);
+
 private:
 	EnumSetting<ResampleType>& resampleSetting;
 	std::unique_ptr<ResampleAlgo> algo;
 	DynamicClock emuClock; // time of the last produced emu-sample,
 	                       //    ticks once per emu-sample
+	DynamicClock writeClock; // emuClock at the start of updateBuffer()
+	std::vector<DeferredWrite> deferredWrites; // sorted on time
 };
 
 } // namespace openmsx
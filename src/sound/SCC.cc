@@ -132,6 +132,7 @@ SCC::SCC(const string& name_, const DeviceConfig& config,
 	ranges::fill(orgPeriod, 0);
 
 	powerUp(time);
+	enableParallelGeneration();
 	registerSound(config);
 }
 
@@ -461,11 +462,35 @@ void SCC::setDeformRegHelper(byte value)
 	}
 }
 
+bool SCC::isChannelSilent(unsigned channel) const
+{
+	return !((ch_enable & (1 << channel)) && (volume[channel] || out[channel]));
+}
+
+void SCC::skipChannel(unsigned channel, unsigned num)
+{
+	// Update phase counter.
+	unsigned newCount = count[channel] + num * incr[channel];
+	count[channel] = newCount % (period[channel] + 1);
+	pos[channel] = (pos[channel] + newCount / (period[channel] + 1)) % 32;
+	// Channel stays off until next waveform index.
+	out[channel] = 0.0f;
+}
+
+bool SCC::allChannelsIdle() const
+{
+	return ranges::all_of(xrange(5), [&](auto i) { return isChannelSilent(i); });
+}
+
+void SCC::skipChannels(unsigned num)
+{
+	for (auto i : xrange(5)) skipChannel(i, num);
+}
+
 void SCC::generateChannels(float** bufs, unsigned num)
 {
-	unsigned enable = ch_enable;
-	for (unsigned i = 0; i < 5; ++i, enable >>= 1) {
-		if ((enable & 1) && (volume[i] || out[i])) {
+	for (auto i : xrange(5)) {
+		if (!isChannelSilent(i)) {
 			auto out2 = out[i];
 			unsigned count2 = count[i];
 			unsigned pos2 = pos[i];
@@ -487,12 +512,7 @@ void SCC::generateChannels(float** bufs, unsigned num)
 			pos[i] = pos2;
 		} else {
 			bufs[i] = nullptr; // channel muted
-			// Update phase counter.
-			unsigned newCount = count[i] + num * incr[i];
-			count[i] = newCount % (period[i] + 1);
-			pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
-			// Channel stays off until next waveform index.
-			out[i] = 0.0f;
+			skipChannel(i, num);
 		}
 	}
 }
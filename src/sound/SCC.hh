@@ -32,6 +32,11 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool allChannelsIdle() const override;
+	void skipChannels(unsigned num) override;
+
+	[[nodiscard]] bool isChannelSilent(unsigned channel) const;
+	void skipChannel(unsigned channel, unsigned num);
 
 	[[nodiscard]] byte readWave(unsigned channel, unsigned address, EmuTime::param time) const;
 	void writeWave(unsigned channel, unsigned address, byte value);
@@ -15,7 +15,8 @@
 namespace openmsx {
 
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
-                               unsigned wantedFreq, unsigned wantedSamples)
+                               unsigned wantedFreq, unsigned wantedSamples,
+                               unsigned latency)
 	: reactor(reactor_)
 	, muted(true)
 {
@@ -37,8 +38,12 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = 3 * (obtained.size / sizeof(float)) + 2;
-	mixBuffer.resize(mixBufferSize);
+	// With less than two fragments buffered the audio callback would
+	// (almost) always run out of samples.
+	targetLatency = (latency == 0)
+	              ? 3 * fragmentSize
+	              : std::max(latency * frequency / 1000, 2 * fragmentSize);
+	mixBuffer.resize(2 * targetLatency);
 	reInit();
 }
 
@@ -49,10 +54,14 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
-	SDL_LockAudioDevice(deviceID);
-	readIdx  = 0;
-	writeIdx = 0;
-	SDL_UnlockAudioDevice(deviceID);
+	// only called while the audio device is paused
+	mixBuffer.clear();
+	underruns = 0;
+	underrunSamples = 0;
+	minLatency = unsigned(-1);
+	droppedSamples = 0;
+	waits = 0;
+	primed = false;
 }
 
 void SDLSoundDriver::mute()
@@ -89,81 +98,74 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
-{
-	int result = writeIdx - readIdx;
-	if (result < 0) result += mixBufferSize;
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
-}
-
-unsigned SDLSoundDriver::getBufferFree() const
-{
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 2) == readIdx' (note that index
-	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
-}
-
 void SDLSoundDriver::audioCallback(float* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
-	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(float));
-		readIdx += num;
-	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(float));
-		unsigned len2 = num - len1;
-		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(float));
-		readIdx = len2;
+	auto available = unsigned(mixBuffer.size());
+	auto num = unsigned(mixBuffer.pop(stream, len));
+	if (num) primed = true;
+	if (!primed) {
+		// nothing uploaded yet since the device got unpaused
+		memset(stream, 0, len * sizeof(float));
+		return;
 	}
-	int missing = len - available;
-	if (missing > 0) {
+
+	auto relaxed = std::memory_order_relaxed;
+	if ((available / 2) < minLatency.load(relaxed)) {
+		minLatency.store(available / 2, relaxed);
+	}
+	if (unsigned missing = len - num) {
 		// buffer underrun
-		memset(&stream[available], 0, missing * sizeof(float));
+		underruns.store(underruns.load(relaxed) + 1, relaxed);
+		underrunSamples.store(underrunSamples.load(relaxed) + missing / 2, relaxed);
+		memset(&stream[num], 0, missing * sizeof(float));
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(float* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
+	// Don't run ahead more than 'targetLatency' of the audio output.
+	unsigned target = 2 * targetLatency; // stereo
+	auto getBufferFree = [&] {
+		auto filled = unsigned(mixBuffer.size());
+		return (filled < target) ? (target - filled) : 0;
+	};
+
+	auto relaxed = std::memory_order_relaxed;
 	len *= 2; // stereo
-	unsigned free = getBufferFree();
-	if (len > free) {
+	while (true) {
+		auto num = unsigned(mixBuffer.push(buffer, std::min(len, getBufferFree())));
+		buffer += num;
+		len -= num;
+		if (len == 0) break;
+
 		auto* board = reactor.getMotherBoard();
 		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
 		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
-			do {
-				SDL_UnlockAudioDevice(deviceID);
-				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
-				board->getRealTime().resync();
-				free = getBufferFree();
-			} while (len > free);
+			waits.store(waits.load(relaxed) + 1, relaxed);
+			Timer::sleep(5000); // 5ms
+			board->getRealTime().resync();
 		} else {
 			// drop excess samples
-			len = free;
+			droppedSamples.store(droppedSamples.load(relaxed) + len / 2, relaxed);
+			break;
 		}
 	}
-	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(float));
-		writeIdx += len;
-	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(float));
-		unsigned len2 = len - len1;
-		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(float));
-		writeIdx = len2;
-	}
+}
 
-	SDL_UnlockAudioDevice(deviceID);
+SoundDriver::BufferStats SDLSoundDriver::getBufferStats() const
+{
+	BufferStats result;
+	result.latency = unsigned(mixBuffer.size() / 2);
+	auto minL = minLatency.load();
+	result.minLatency = (minL == unsigned(-1)) ? 0 : minL;
+	result.targetLatency = targetLatency;
+	result.bufferSize = unsigned(mixBuffer.capacity() / 2);
+	result.underruns = underruns;
+	result.underrunSamples = underrunSamples;
+	result.droppedSamples = droppedSamples;
+	result.waits = waits;
+	return result;
 }
 
 } // namespace openmsx
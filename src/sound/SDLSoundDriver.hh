@@ -3,8 +3,10 @@
 
 #include "SoundDriver.hh"
 #include "SDLSurfacePtr.hh"
-#include "MemBuffer.hh"
+#include "SPSCRingBuffer.hh"
 #include <SDL.h>
+#include <atomic>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -16,7 +18,9 @@ public:
 	SDLSoundDriver(const SDLSoundDriver&) = delete;
 	SDLSoundDriver& operator=(const SDLSoundDriver&) = delete;
 
-	SDLSoundDriver(Reactor& reactor, unsigned wantedFreq, unsigned samples);
+	/** @param latency Target latency in ms, 0 means three fragments. */
+	SDLSoundDriver(Reactor& reactor, unsigned wantedFreq, unsigned samples,
+	               unsigned latency);
 	~SDLSoundDriver() override;
 
 	void mute() override;
@@ -26,23 +30,32 @@ public:
 	[[nodiscard]] unsigned getSamples() const override;
 
 	void uploadBuffer(float* buffer, unsigned len) override;
+	[[nodiscard]] BufferStats getBufferStats() const override;
 
 private:
 	void reInit();
-	[[nodiscard]] unsigned getBufferFilled() const;
-	[[nodiscard]] unsigned getBufferFree() const;
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(float* stream, unsigned len);
 
 private:
 	Reactor& reactor;
 	SDL_AudioDeviceID deviceID;
-	MemBuffer<float> mixBuffer;
-	unsigned mixBufferSize;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+	unsigned targetLatency; // in samples
+	// The audio callback runs on a thread of SDL, it never locks the
+	// audio device, neither does uploadBuffer().
+	SPSCRingBuffer<float> mixBuffer; // stereo
 	bool muted;
+
+	// Telemetry, see getBufferStats(). Each counter is only written by
+	// one thread: the audio thread or the emulation thread.
+	std::atomic<uint64_t> underruns;
+	std::atomic<uint64_t> underrunSamples;
+	std::atomic<unsigned> minLatency;
+	std::atomic<uint64_t> droppedSamples;
+	std::atomic<uint64_t> waits;
+	bool primed; // audio thread only, received samples since reInit()
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
 
@@ -12,6 +12,7 @@
 #include "likely.hh"
 #include "ranges.hh"
 #include "one_of.hh"
+#include "unreachable.hh"
 #include "vla.hh"
 #include "xrange.hh"
 #include <cassert>
@@ -21,8 +22,9 @@ using std::string;
 
 namespace openmsx {
 
-static MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
+// One per thread, see SoundDevice::enableParallelGeneration().
+static thread_local MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
+static thread_local unsigned mixBufferSize = 0;
 
 static void allocateMixBuffer(unsigned size)
 {
@@ -190,12 +192,21 @@ void SoundDevice::muteChannel(unsigned channel, bool muted)
 	channelMuted[channel] = muted;
 }
 
+void SoundDevice::skipChannels(unsigned /*num*/)
+{
+	UNREACHABLE; // only called for devices that override allChannelsIdle()
+}
+
 bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 {
 #ifdef __SSE2__
 	assert((uintptr_t(dataOut) & 15) == 0); // must be 16-byte aligned
 #endif
 	if (samples == 0) return true;
+	if (canSkipChannels()) {
+		skipChannels(samples);
+		return false;
+	}
 	unsigned outputStereo = isStereo() ? 2 : 1;
 
 	static_assert(sizeof(float) == sizeof(uint32_t));
@@ -144,6 +144,18 @@ public: // Will be called by Mixer:
 	[[nodiscard]] virtual bool updateBuffer(unsigned length, float* buffer,
 	                                        EmuTime::param time) = 0;
 
+	/** Can updateBuffer() be called on a worker thread, in parallel with
+	  * the other sound devices? See enableParallelGeneration().
+	  */
+	[[nodiscard]] bool canGenerateInParallel() const { return parallelGeneration; }
+
+	/** Does updateBuffer() currently only produce silence, without having
+	  * to generate (or resample) any samples? Then it's e.g. not worth to
+	  * generate this device on a worker thread. The default implementation
+	  * returns false.
+	  */
+	[[nodiscard]] virtual bool isIdle() const { return false; }
+
 protected:
 	/** Adds a number of samples that all have the same value.
 	  * Can be used to synthesize segments of a square wave.
@@ -170,6 +182,28 @@ protected:
 	  */
 	virtual void generateChannels(float** buffers, unsigned num) = 0;
 
+	/** Are all channels of this device silent, and do they stay silent
+	  * until the next register write? Devices that can cheaply detect
+	  * this (e.g. all channels keyed-off with a finished release) should
+	  * override this method together with skipChannels(). The default
+	  * implementation returns false.
+	  */
+	[[nodiscard]] virtual bool allChannelsIdle() const { return false; }
+
+	/** Advance the state of this device by 'num' samples, exactly like
+	  * generateChannels() would, but without producing output. Only called
+	  * while allChannelsIdle() returns true, so this should take O(1)
+	  * time.
+	  */
+	virtual void skipChannels(unsigned num);
+
+	/** Can mixChannels() skip generating the samples? IOW are all channels
+	  * idle (see allChannelsIdle()) and none is being recorded.
+	  */
+	[[nodiscard]] bool canSkipChannels() const {
+		return (numRecordChannels == 0) && allChannelsIdle();
+	}
+
 	/** Calls generateChannels() and combines the output to a single
 	  * channel.
 	  * @param dataOut Output buffer, must be big enough to hold
@@ -177,6 +211,9 @@ protected:
 	  * @param samples The number of samples
 	  * @result true iff at least one channel was unmuted
 	  *
+	  * When all channels are idle (see canSkipChannels()) this only calls
+	  * skipChannels() and returns false.
+	  *
 	  * Note: To enable various optimizations (like SSE), this method can
 	  * fill the output buffer with up to 3 extra samples. Those extra
 	  * samples should be ignored, though the caller must make sure the
@@ -184,6 +221,13 @@ protected:
 	  */
 	[[nodiscard]] bool mixChannels(float* dataOut, unsigned samples);
 
+	/** Allow the Mixer to generate the samples of this device on a worker
+	  * thread. Only enable this for devices that, while generating, only
+	  * access state they own themselves (so e.g. not the Tcl interpreter,
+	  * settings or other emulated devices).
+	  */
+	void enableParallelGeneration() { parallelGeneration = true; }
+
 	/** See MSXMixer::getHostSampleClock(). */
 	[[nodiscard]] const DynamicClock& getHostSampleClock() const;
 	[[nodiscard]] double getEffectiveSpeed() const;
@@ -204,6 +248,7 @@ private:
 	int channelBalance[MAX_CHANNELS];
 	bool channelMuted[MAX_CHANNELS];
 	bool balanceCenter;
+	bool parallelGeneration = false;
 };
 
 } // namespace openmsx
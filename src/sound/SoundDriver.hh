@@ -1,6 +1,8 @@
 #ifndef SOUNDDRIVER_HH
 #define SOUNDDRIVER_HH
 
+#include <cstdint>
+
 namespace openmsx {
 
 class SoundDriver
@@ -28,6 +30,22 @@ public:
 
 	virtual void uploadBuffer(float* buffer, unsigned len) = 0;
 
+	/** Fill level and underrun statistics of the output buffer, see
+	  * 'openmsx_info sound_buffer'. Counted since the last unmute. All
+	  * sizes are in (stereo) samples.
+	  */
+	struct BufferStats {
+		unsigned latency = 0;        // currently buffered
+		unsigned minLatency = 0;     // lowest fill level seen by the audio thread
+		unsigned targetLatency = 0;  // the emulation doesn't run ahead further
+		unsigned bufferSize = 0;
+		uint64_t underruns = 0;      // audio callbacks that ran out of samples
+		uint64_t underrunSamples = 0;
+		uint64_t droppedSamples = 0; // buffer full while not throttled
+		uint64_t waits = 0;          // buffer full, emulation waited for the audio thread
+	};
+	[[nodiscard]] virtual BufferStats getBufferStats() const { return {}; }
+
 protected:
 	SoundDriver() = default;
 };
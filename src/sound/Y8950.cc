@@ -777,7 +777,7 @@ void Y8950::setEnabled(bool enabled_, EmuTime::param time)
 	enabled = enabled_;
 }
 
-bool Y8950::checkMuteHelper()
+bool Y8950::checkMuteHelper() const
 {
 	if (!enabled) {
 		return true;
@@ -800,6 +800,17 @@ bool Y8950::checkMuteHelper()
 	return adpcm.isMuted();
 }
 
+bool Y8950::allChannelsIdle() const
+{
+	return checkMuteHelper();
+}
+
+void Y8950::skipChannels(unsigned /*num*/)
+{
+	// Same as the muted case in generateChannels(): the internal state is
+	// not updated.
+}
+
 void Y8950::generateChannels(float** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -76,6 +76,8 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool allChannelsIdle() const override;
+	void skipChannels(unsigned num) override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
@@ -90,11 +92,12 @@ private:
 	inline void setRythmMode(int data);
 	void update_key_status();
 
-	[[nodiscard]] bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	void changeStatusMask(byte newMask);
 
 	void callback(byte flag) override;
+	[[nodiscard]] std::string_view getTimerOwnerName() const override { return getName(); }
 
 public:
 	// Dynamic range of envelope
@@ -15,6 +15,7 @@
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
 #include "serialize.hh"
+#include "strCat.hh"
 #include <algorithm>
 
 namespace openmsx {
@@ -45,9 +46,10 @@ constexpr int STEP_MASK = (1 << STEP_BITS) -1;
 
 
 Y8950Adpcm::Y8950Adpcm(Y8950& y8950_, const DeviceConfig& config,
-                       const std::string& name, unsigned sampleRam)
+                       const std::string& name_, unsigned sampleRam)
 	: Schedulable(config.getScheduler())
 	, y8950(y8950_)
+	, name(name_)
 	, ram(config, name + " RAM", "Y8950 sample RAM", sampleRam)
 	, clock(config.getMotherBoard().getCurrentTime())
 	, volume(0)
@@ -138,6 +140,11 @@ void Y8950Adpcm::schedule()
 	}
 }
 
+std::string Y8950Adpcm::getProfileName() const
+{
+	return strCat(Schedulable::getProfileName(), ' ', name);
+}
+
 void Y8950Adpcm::executeUntil(EmuTime::param time)
 {
 	assert(isPlaying());
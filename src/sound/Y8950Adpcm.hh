@@ -6,6 +6,7 @@
 #include "Clock.hh"
 #include "serialize_meta.hh"
 #include "openmsx.hh"
+#include <string>
 
 namespace openmsx {
 
@@ -46,6 +47,7 @@ private:
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
+	[[nodiscard]] std::string getProfileName() const override;
 
 	void schedule();
 	void restart(PlayData& pd);
@@ -61,6 +63,7 @@ private:
 
 private:
 	Y8950& y8950;
+	const std::string name;
 	TrackedRam ram;
 
 	// copy/pasted from Y8950.hh
@@ -912,7 +912,7 @@ YM2151::~YM2151()
 	unregisterSound();
 }
 
-bool YM2151::checkMuteHelper()
+bool YM2151::checkMuteHelper() const
 {
 	return ranges::all_of(oper, [](auto& op) { return op.state == EG_OFF; });
 }
@@ -1500,6 +1500,17 @@ void YM2151::advance()
 	}
 }
 
+bool YM2151::allChannelsIdle() const
+{
+	return checkMuteHelper();
+}
+
+void YM2151::skipChannels(unsigned /*num*/)
+{
+	// Same as the muted case in generateChannels(): the internal state is
+	// not updated.
+}
+
 void YM2151::generateChannels(float** bufs, unsigned num)
 {
 	if (checkMuteHelper()) {
@@ -119,8 +119,11 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool allChannelsIdle() const override;
+	void skipChannels(unsigned num) override;
 
 	void callback(byte flag) override;
+	[[nodiscard]] std::string_view getTimerOwnerName() const override { return getName(); }
 	void setStatus(byte flags);
 	void resetStatus(byte flags);
 
@@ -140,7 +143,7 @@ private:
 	void advanceEG();
 	void advance();
 
-	[[nodiscard]] bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	IRQHelper irq;
 
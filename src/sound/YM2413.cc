@@ -21,9 +21,10 @@ YM2413::Debuggable::Debuggable(
 {
 }
 
-byte YM2413::Debuggable::read(unsigned address)
+byte YM2413::Debuggable::read(unsigned address, EmuTime::param time)
 {
 	auto& ym2413 = OUTER(YM2413, debuggable);
+	ym2413.flushDeferredWrites(time);
 	return ym2413.core->peekReg(address);
 }
 
@@ -68,6 +69,7 @@ YM2413::YM2413(const std::string& name_, const DeviceConfig& config)
 	, core(createCore(config))
 	, debuggable(config.getMotherBoard(), getName())
 {
+	enableParallelGeneration();
 	registerSound(config);
 }
 
@@ -84,14 +86,18 @@ void YM2413::reset(EmuTime::param time)
 
 void YM2413::writePort(bool port, byte value, EmuTime::param time)
 {
-	updateStream(time);
+	// FM music writes very often, don't generate all sound devices up to
+	// 'time' for each write.
+	deferWrite(port, value, time);
+}
 
-	auto [integral, fractional] = getEmuClock().getTicksTillAsIntFloat(time);
-	auto offset = unsigned(18 * fractional);
-	assert(integral == 0);
+void YM2413::applyDeferredWrite(unsigned port, uint8_t value,
+                                EmuTime::param /*time*/, float fraction)
+{
+	auto offset = unsigned(18 * fraction);
 	assert(offset < 18);
 
-	core->writePort(port, value, offset);
+	core->writePort(port != 0, value, offset);
 }
 
 void YM2413::pokeReg(byte reg, byte value, EmuTime::param time)
@@ -112,9 +118,12 @@ float YM2413::getAmplificationFactorImpl() const
 
 
 template<typename Archive>
-void YM2413::serialize(Archive& ar, unsigned /*version*/)
+void YM2413::serialize(Archive& ar, unsigned version)
 {
 	ar.serializePolymorphic("ym2413", *core);
+	if (ar.versionAtLeast(version, 2)) {
+		serializeDeferredWrites(ar);
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(YM2413);
 
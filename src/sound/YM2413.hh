@@ -5,6 +5,7 @@
 #include "SimpleDebuggable.hh"
 #include "EmuTime.hh"
 #include "openmsx.hh"
+#include "serialize_meta.hh"
 #include <memory>
 #include <string>
 
@@ -30,16 +31,22 @@ private:
 	void generateChannels(float** bufs, unsigned num) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
+	// ResampledSoundDevice
+	void applyDeferredWrite(unsigned port, uint8_t value,
+	                        EmuTime::param time, float fraction) override;
+
 private:
 	const std::unique_ptr<YM2413Core> core;
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
-		[[nodiscard]] byte read(unsigned address) override;
+		[[nodiscard]] byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
 	} debuggable;
 };
 
+SERIALIZE_CLASS_VERSION(YM2413, 2);
+
 } // namespace openmsx
 
 #endif
@@ -38,6 +38,9 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 namespace YM2413NukeYKT {
@@ -76,6 +79,68 @@ constexpr auto expTab = [] {
 	return result;
 }();
 
+// 'expTab[level & 0xff] >> (level >> 8)' for all possible levels.
+constexpr auto expShiftTab = [] {
+	std::array<uint16_t, 4096> result = {};
+	for (int i = 0; i < 4096; ++i) {
+		result[i] = expTab[i & 0xff] >> (i >> 8);
+	}
+	return result;
+}();
+
+// Output of a single operator (before the '>> 3' in the channel output).
+// Written without branches: the sign of the output is unpredictable.
+[[nodiscard]] static ALWAYS_INLINE int16_t operatorOutput(
+	uint16_t phase, uint8_t eg_out, bool eg_silent, bool dcm)
+{
+	int32_t neg = -int32_t((phase >> 9) & 1); // 0 or -1
+	uint8_t quarter = phase ^ -int32_t((phase >> 8) & 1);
+	auto logsin = logsinTab[quarter];
+	auto op_level = std::min(4095, logsin + (eg_out << 4));
+	int32_t op_exp = expShiftTab[op_level];
+	int32_t result = (op_exp ^ neg) | (neg & -int32_t(dcm)); // dcm: ~0
+	return result & (int32_t(eg_silent) - 1);
+}
+
+// Output of the operators of all 9 channels.
+static ALWAYS_INLINE void operatorOutputs(
+	const uint16_t* phase, const uint8_t* eg_out, const bool* eg_silent,
+	const bool* dcm, int16_t* out)
+{
+	unsigned ch = 0;
+#ifdef __SSE2__
+	// Same calculation as above for the first 8 channels, except for the
+	// table lookups (SSE2 has no gather instruction).
+	// (element-wise loads: a vector load directly after the scalar stores
+	// in step() is slow, the store-to-load forwarding fails)
+	auto load8 = [](const auto* p) {
+		return _mm_setr_epi16(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+	};
+	alignas(16) uint16_t tmp[8];
+	auto* tmp128 = reinterpret_cast<__m128i*>(tmp);
+
+	__m128i ph = load8(phase);
+	__m128i half = _mm_srai_epi16(_mm_slli_epi16(ph, 7), 15); // bit 8
+	__m128i neg  = _mm_srai_epi16(_mm_slli_epi16(ph, 6), 15); // bit 9
+	_mm_store_si128(tmp128, _mm_and_si128(_mm_xor_si128(ph, half), _mm_set1_epi16(0xff)));
+	for (auto& t : tmp) t = logsinTab[t];
+
+	__m128i op_level = _mm_add_epi16(_mm_load_si128(tmp128), _mm_slli_epi16(load8(eg_out), 4));
+	_mm_store_si128(tmp128, _mm_min_epi16(op_level, _mm_set1_epi16(4095)));
+	for (auto& t : tmp) t = expShiftTab[t];
+
+	__m128i dcm_mask    = _mm_sub_epi16(_mm_setzero_si128(), load8(dcm));
+	__m128i silent_mask = _mm_sub_epi16(_mm_setzero_si128(), load8(eg_silent));
+	__m128i result = _mm_or_si128(_mm_xor_si128(_mm_load_si128(tmp128), neg),
+	                              _mm_and_si128(neg, dcm_mask));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_andnot_si128(silent_mask, result));
+	ch = 8;
+#endif
+	for (/**/; ch < 9; ++ch) {
+		out[ch] = operatorOutput(phase[ch], eg_out[ch], eg_silent[ch], dcm[ch]);
+	}
+}
+
 constexpr YM2413::Patch YM2413::m_patches[15] = {
 	{0x1e, 2, 7, {0, 0}, {1, 1}, {1, 1}, {1, 0}, {0x1, 0x1}, {0, 0}, {0xd, 0x7}, {0x0, 0x8}, {0x0, 0x1}, {0x0, 0x7}},
 	{0x1a, 1, 5, {0, 0}, {0, 1}, {0, 0}, {1, 0}, {0x3, 0x1}, {0, 0}, {0xd, 0xf}, {0x8, 0x7}, {0x2, 0x1}, {0x3, 0x3}},
@@ -107,6 +172,11 @@ static constexpr uint8_t CH_OFFSET[18] = {
 	1, 2, 0, 1, 2, 3, 4, 5, 3, 4, 5, 6, 7, 8, 6, 7, 8, 0
 };
 
+// The index in op_fb1[] and op_fb2[] for the modulator of each channel.
+static constexpr uint8_t FB_INDEX[9] = {
+	2, 3, 4, 8, 0, 1, 5, 6, 7
+};
+
 static constexpr int8_t VIB_TAB[8] = {0, 1, 2, 1, 0, -1, -2, -1};
 
 // Define the tables
@@ -473,22 +543,33 @@ template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void YM2413::doRhythm()
 	}
 }
 
-template<uint32_t CYCLES> ALWAYS_INLINE uint32_t YM2413::getPhaseMod(uint8_t fb_t)
+template<uint32_t CYCLES> ALWAYS_INLINE uint32_t YM2413::getPhaseMod(Locals& l, uint8_t fb_t) const
 {
-	bool ismod2 = ((rhythm & 0x20) && (CYCLES == one_of(12u, 13u)))
-	            ? false
-	            : (((CYCLES + 4) / 3) & 1);
-	bool ismod3 = ((rhythm & 0x20) && (CYCLES == one_of(15u, 16u)))
-	            ? false
-	            : (((CYCLES + 1) / 3) & 1);
-
-	if (ismod3) return op_mod << 1;
-	if (ismod2) {
-		constexpr uint32_t cycles9 = (CYCLES + 3) % 9;
-		uint32_t op_fbsum = (op_fb1[cycles9] + op_fb2[cycles9]) & 0x7fffffff;
-		return op_fbsum >> fb_t;
+	constexpr bool carrier = ((CYCLES + 1) / 3) & 1;
+	if constexpr (carrier) {
+		bool ismod3 = !((rhythm & 0x20) && (CYCLES == one_of(15u, 16u)));
+		// This is the modulator output of the same sample, it's only
+		// added in doOperators().
+		auto& mask = (CYCLES == 16) ? l.next_car_mod_mask
+		                            : l.car_mod_mask[CH_OFFSET[CYCLES]];
+		mask = ismod3 ? 0xffff : 0; // 'op_mod << 1'
+		return 0;
+	} else {
+		bool ismod2 = ((rhythm & 0x20) && (CYCLES == one_of(12u, 13u)))
+		            ? false
+		            : (((CYCLES + 4) / 3) & 1);
+		if constexpr (CYCLES == 17) {
+			// Feedback of the modulator output of the same sample.
+			l.next_fb_t = ismod2 ? fb_t : 31;
+			return 0;
+		}
+		if (ismod2) {
+			constexpr uint32_t cycles9 = (CYCLES + 3) % 9;
+			uint32_t op_fbsum = (op_fb1[cycles9] + op_fb2[cycles9]) & 0x7fffffff;
+			return op_fbsum >> fb_t;
+		}
+		return 0;
 	}
-	return 0;
 }
 
 template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::doRegWrite()
@@ -621,40 +702,73 @@ void YM2413::doModeWrite(uint8_t address, uint8_t value)
 	}
 }
 
-template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::doOperator(float* out[9 + 5], bool eg_silent)
+template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::prepareOperator(Locals& l, bool eg_silent) const
 {
+	// The operator output in this step is for the slot of 2 steps earlier.
+	constexpr uint32_t slot = (CYCLES + 16) % 18;
+	constexpr bool carrier = ((slot + 1) / 3) & 1;
+	constexpr uint32_t ch = CH_OFFSET[slot];
 	bool ismod1 = ((rhythm & 0x20) && (CYCLES == one_of(14u, 15u)))
 	            ? false
-	            : (((CYCLES + 2) / 3) & 1);
-	constexpr bool is_next_mod3 = ((CYCLES + 2) / 3) & 1; // approximate: will 'ismod3' possibly be true next step
-
-	auto output = [&]() -> int32_t {
-		if (eg_silent) return 0;
-		auto prev2_phase = op_phase[(CYCLES - 2) & 1];
-		uint8_t quarter = (prev2_phase & 0x100) ? ~prev2_phase : prev2_phase;
-		auto logsin = logsinTab[quarter];
-		auto op_level = std::min(4095, logsin + (eg_out[(CYCLES - 2) & 1] << 4));
-		uint32_t op_exp_m = expTab[op_level & 0xff];
-		auto  op_exp_s = op_level >> 8;
-		if (prev2_phase & 0x200) {
-			return unlikely(c_dcm[(CYCLES + 16) % 3] & (ismod1 ? 1 : 2))
-			       ? ~0
-			       : ~(op_exp_m >> op_exp_s);
-		} else {
-			return op_exp_m >> op_exp_s;
-		}
-	}();
+	            : !carrier;
+
+	auto& ops = carrier ? l.car : l.mod;
+	ops.eg_silent[ch] = eg_silent;
+	l.eg_active |= !eg_silent;
+	ops.dcm[ch] = c_dcm[(CYCLES + 16) % 3] & (ismod1 ? 1 : 2);
+	if constexpr (CYCLES == 0 || CYCLES >= 14) {
+		l.rm_out[CYCLES] = rhythm & 0x20;
+	}
+}
 
-	if (ismod1) {
-		constexpr uint32_t cycles9 = (CYCLES + 1) % 9;
-		op_fb2[cycles9] = op_fb1[cycles9];
-		op_fb1[cycles9] = output;
+template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::storeOperatorInput(
+	Locals& l, uint32_t phase, uint8_t eg)
+{
+	if constexpr (CYCLES >= 16) {
+		// Calculated in the first steps of the next sample. The input
+		// for the current sample was already copied, see step18().
+		op_phase[CYCLES & 1] = phase;
+		eg_out[CYCLES & 1] = eg;
+	} else {
+		constexpr bool carrier = ((CYCLES + 1) / 3) & 1;
+		constexpr uint32_t ch = CH_OFFSET[CYCLES];
+		auto& ops = carrier ? l.car : l.mod;
+		ops.phase[ch] = phase;
+		ops.eg_out[ch] = eg;
 	}
-	channelOutput<CYCLES>(out, output >> 3);
+}
 
-	if (is_next_mod3) {
-		op_mod = output & 0x1ff;
+ALWAYS_INLINE void YM2413::doOperators(Locals& l)
+{
+	int16_t mod_out[9] = {};
+	int16_t car_out[9] = {};
+	if (l.eg_active) {
+		// First all modulators (they only depend on their own output
+		// of the previous samples), next all carriers.
+		operatorOutputs(l.mod.phase, l.mod.eg_out, l.mod.eg_silent, l.mod.dcm, mod_out);
+		uint16_t car_phase[9];
+		for (auto ch : xrange(9)) {
+			uint16_t op_mod2 = (mod_out[ch] & 0x1ff) << 1;
+			car_phase[ch] = l.car.phase[ch] + (op_mod2 & l.car_mod_mask[ch]);
+		}
+		operatorOutputs(car_phase, l.car.eg_out, l.car.eg_silent, l.car.dcm, car_out);
 	}
+	for (auto ch : xrange(9)) {
+		// no feedback for the HH and TOM rhythm instruments
+		if ((ch < 7) || !l.rm_out[ch + 7]) {
+			auto fb = FB_INDEX[ch];
+			op_fb2[fb] = op_fb1[fb];
+			op_fb1[fb] = mod_out[ch];
+		}
+	}
+
+	// Complete the phase for the last 2 slots, now the modulation is known.
+	op_mod = mod_out[8] & 0x1ff;
+	op_phase[0] += (op_mod << 1) & l.next_car_mod_mask;
+	uint32_t op_fbsum = (op_fb1[2] + op_fb2[2]) & 0x7fffffff;
+	op_phase[1] += op_fbsum >> l.next_fb_t;
+
+	channelOutput(l.out, mod_out, car_out, l.rm_out);
 }
 
 template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE uint32_t YM2413::getPhase(uint8_t& rm_hh_bits)
@@ -738,31 +852,30 @@ template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void YM2413::incrementPh
 	pg_phase[CYCLES] = pg_phase_next + phase_incr;
 }
 
-template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::channelOutput(float* out[9 + 5], int32_t ch_out)
-{
-	switch (CYCLES) {
-		case  4: *out[ 0]++ += ch_out; break;
-		case  5: *out[ 1]++ += ch_out; break;
-		case  6: *out[ 2]++ += ch_out; break;
-		case 10: *out[ 3]++ += ch_out; break;
-		case 11: *out[ 4]++ += ch_out; break;
-		case 12: *out[ 5]++ += ch_out; break;
-		case 14: *out[ 9]++ += (rhythm & 0x20) ? 2 * ch_out : 0; break;
-		case 15: *out[10]++ += delay10;
-		         delay10     = (rhythm & 0x20) ? 2 * ch_out : 0; break;
-		case 16: *out[ 6]++ += delay6;
-			 *out[11]++ += delay11;
-		         delay6      = (rhythm & 0x20) ? 0 : ch_out;
-			 delay11     = (rhythm & 0x20) ? 2 * ch_out : 0; break;
-		case 17: *out[ 7]++ += delay7;
-			 *out[12]++ += delay12;
-		         delay7      = (rhythm & 0x20) ? 0 : ch_out;
-			 delay12     = (rhythm & 0x20) ? 2 * ch_out : 0; break;
-		case  0: *out[ 8]++ += (rhythm & 0x20) ? 0 : ch_out;
-			 *out[13]++ += (rhythm & 0x20) ? 2 * ch_out : 0; break;
-		default:
-			break; // suppress warning
-	}
+ALWAYS_INLINE void YM2413::channelOutput(
+	float* out[9 + 5], const int16_t* mod_out, const int16_t* car_out, const bool* rm_out)
+{
+	// The comments indicate the step in which the original code produces
+	// this output. The last three channels are delayed till the next sample.
+	/* 4*/ *out[ 0]++ += car_out[0] >> 3;
+	/* 5*/ *out[ 1]++ += car_out[1] >> 3;
+	/* 6*/ *out[ 2]++ += car_out[2] >> 3;
+	/*10*/ *out[ 3]++ += car_out[3] >> 3;
+	/*11*/ *out[ 4]++ += car_out[4] >> 3;
+	/*12*/ *out[ 5]++ += car_out[5] >> 3;
+	/*14*/ *out[ 9]++ += rm_out[14] ? 2 * (mod_out[7] >> 3) : 0;
+	/*15*/ *out[10]++ += delay10;
+	       delay10     = rm_out[15] ? 2 * (mod_out[8] >> 3) : 0;
+	/*16*/ *out[ 6]++ += delay6;
+	       *out[11]++ += delay11;
+	       delay6      = rm_out[16] ? 0 : (car_out[6] >> 3);
+	       delay11     = rm_out[16] ? 2 * (car_out[6] >> 3) : 0;
+	/*17*/ *out[ 7]++ += delay7;
+	       *out[12]++ += delay12;
+	       delay7      = rm_out[17] ? 0 : (car_out[7] >> 3);
+	       delay12     = rm_out[17] ? 2 * (car_out[7] >> 3) : 0;
+	/* 0*/ *out[ 8]++ += rm_out[0] ? 0 : (car_out[8] >> 3);
+	       *out[13]++ += rm_out[0] ? 2 * (car_out[8] >> 3) : 0;
 }
 
 template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE uint8_t YM2413::envelopeOutput(uint32_t ksltl, int8_t am_t) const
@@ -792,7 +905,7 @@ ALWAYS_INLINE void YM2413::step(Locals& l)
 
 	doLFO<CYCLES, TEST_MODE>(l.lfo_am_car);
 	doRhythm<CYCLES, TEST_MODE>();
-	uint32_t phaseMod = getPhaseMod<CYCLES>(patch1.fb_t);
+	uint32_t phaseMod = getPhaseMod<CYCLES>(l, patch1.fb_t);
 
 	constexpr uint32_t mcsel = ((CYCLES + 1) / 3) & 1;
 	eg_sl[CYCLES & 1] = patch1.sl[mcsel];
@@ -804,13 +917,13 @@ ALWAYS_INLINE void YM2413::step(Locals& l)
 	doRegWrite<CYCLES>();
 	doIO<CYCLES>();
 
-	doOperator<CYCLES>(l.out, eg_silent);
+	prepareOperator<CYCLES>(l, eg_silent);
 
 	uint32_t pg_out = getPhase<CYCLES, TEST_MODE>(l.rm_hh_bits);
-	op_phase[CYCLES & 1] = phaseMod + pg_out;
 	incrementPhase<CYCLES, TEST_MODE>(phase_incr, key_on_event);
 
-	eg_out[CYCLES & 1] = envelopeOutput<CYCLES, TEST_MODE>(ksltl, patch2_am_t);
+	storeOperatorInput<CYCLES>(l, phaseMod + pg_out,
+		envelopeOutput<CYCLES, TEST_MODE>(ksltl, patch2_am_t));
 }
 
 void YM2413::generateChannels(float* out_[9 + 5], uint32_t n)
@@ -834,6 +947,16 @@ NEVER_INLINE void YM2413::step18(float* out[9 + 5])
 	l.out = out;
 	l.use_rm_patches = false; // avoid warning
 	l.lfo_am_car = false; // between cycle 17 and 0 'lfo_am_car' is always =0
+	l.eg_active = false;
+
+	// The operators for the last two slots of the previous sample (carrier
+	// of channel 8, modulator of channel 0) are calculated in this sample.
+	// Their phase already includes the modulation.
+	l.car.phase[8] = op_phase[0];
+	l.car.eg_out[8] = eg_out[0];
+	l.car_mod_mask[8] = 0;
+	l.mod.phase[0] = op_phase[1];
+	l.mod.eg_out[0] = eg_out[1];
 
 	step< 0, TEST_MODE>(l);
 	step< 1, TEST_MODE>(l);
@@ -854,6 +977,8 @@ NEVER_INLINE void YM2413::step18(float* out[9 + 5])
 	step<16, TEST_MODE>(l);
 	step<17, TEST_MODE>(l);
 
+	doOperators(l);
+
 	allowed_offset = std::max<int>(0, allowed_offset - 18); // see writePort()
 }
 
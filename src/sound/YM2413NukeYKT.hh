@@ -46,6 +46,12 @@
 *        fallback code).
 *      * Move sub-operations in the pipeline (e.g. to eliminate temporary state)
 *        when this doesn't have an observable effect.
+*      * Split the 18 steps in two passes: the first pass runs the envelope
+*        generator, phase generator, LFO and register writes and records the
+*        inputs for the operators. The second pass then calculates the
+*        operator outputs of all 9 modulators and next of all 9 carriers (in
+*        structure-of-arrays form). This works because nothing in the first
+*        pass depends on the operator output.
 *      * Lots of small tweak.
 *      * ...
 *
@@ -142,12 +148,28 @@ private:
 		uint8_t_2 sl  = {0, 0};
 		uint8_t_2 rr4 = {0, 0}; // multiplied by 4
 	};
+	// Input for the operator calculation of one sample, indexed by channel.
+	struct Operators {
+		uint16_t phase[9]; // including modulation, except for the carriers
+		uint8_t eg_out[9];
+		bool eg_silent[9];
+		bool dcm[9]; // output ~0 for the negative half (instead of ~x)
+	};
 	struct Locals {
 		float** out;
 		uint8_t rm_hh_bits;
 		bool use_rm_patches;
 		bool lfo_am_car;
 		bool eg_timer_carry;
+
+		Operators mod;
+		Operators car;
+		uint16_t car_mod_mask[9]; // modulate carrier? 0 or 0xffff
+		bool rm_out[18]; // rhythm mode (only for steps 0 and 14..17)
+		bool eg_active; // any operator not silent?
+		// for the last 2 slots, see step18()
+		uint16_t next_car_mod_mask;
+		uint8_t next_fb_t;
 	};
 	struct Write {
 		uint8_t port;
@@ -162,13 +184,13 @@ private:
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void step(Locals& l);
 
 	template<uint32_t CYCLES>                 ALWAYS_INLINE uint32_t phaseCalcIncrement(const Patch& patch1) const;
-	template<uint32_t CYCLES>                 ALWAYS_INLINE void channelOutput(float* out[9 + 5], int32_t ch_out);
 	template<uint32_t CYCLES>                 ALWAYS_INLINE const Patch& preparePatch1(bool use_rm_patches) const;
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE uint32_t getPhase(uint8_t& rm_hh_bits);
 	template<uint32_t CYCLES>                 ALWAYS_INLINE bool keyOnEvent() const;
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void incrementPhase(uint32_t phase_incr, bool prev_rhythm);
-	template<uint32_t CYCLES>                 ALWAYS_INLINE uint32_t getPhaseMod(uint8_t fb_t);
-	template<uint32_t CYCLES>                 ALWAYS_INLINE void doOperator(float* out[9 + 5], bool eg_silent);
+	template<uint32_t CYCLES>                 ALWAYS_INLINE uint32_t getPhaseMod(Locals& l, uint8_t fb_t) const;
+	template<uint32_t CYCLES>                 ALWAYS_INLINE void prepareOperator(Locals& l, bool eg_silent) const;
+	template<uint32_t CYCLES>                 ALWAYS_INLINE void storeOperatorInput(Locals& l, uint32_t phase, uint8_t eg);
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE uint8_t envelopeOutput(uint32_t ksltl, int8_t am_t) const;
 	template<uint32_t CYCLES>                 ALWAYS_INLINE uint32_t envelopeKSLTL(const Patch& patch1, bool use_rm_patches) const;
 	template<uint32_t CYCLES>                 ALWAYS_INLINE void envelopeTimer1();
@@ -180,6 +202,9 @@ private:
 	template<uint32_t CYCLES>                 ALWAYS_INLINE void doRegWrite();
 	template<uint32_t CYCLES>                 ALWAYS_INLINE void doIO();
 
+	ALWAYS_INLINE void doOperators(Locals& l);
+	ALWAYS_INLINE void channelOutput(float* out[9 + 5], const int16_t* mod_out, const int16_t* car_out, const bool* rm_out);
+
 	NEVER_INLINE void doRegWrite(uint32_t channel);
 	             void doRegWrite(uint8_t block, uint8_t channel, uint8_t data);
 	NEVER_INLINE void doIO(uint32_t cycles_plus_1, Write& write);
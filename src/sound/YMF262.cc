@@ -481,12 +481,6 @@ static constexpr SinTab getSinTab()
 constexpr SinTab sin = getSinTab();
 
 
-// TODO clean this up
-static int phase_modulation;  // phase modulation input (SLOT 2)
-static int phase_modulation2; // phase modulation input (SLOT 3
-                              // in 4 operator channels)
-
-
 YMF262::Slot::Slot()
 	: Cnt(0), Incr(0)
 {
@@ -675,7 +669,7 @@ inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 
 // calculate output of a standard 2 operator channel
 // (or 1st part of a 4-op channel)
-void YMF262::Channel::chan_calc(unsigned lfo_am)
+void YMF262::Channel::chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! something is wrong with this, it caused bug
 	// !!    [2823673] moonsound 4 operator FM fail
@@ -714,7 +708,7 @@ void YMF262::Channel::chan_calc(unsigned lfo_am)
 }
 
 // calculate output of a 2nd part of 4-op channel
-void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
+void YMF262::Channel::chan_calc_ext(unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! see remark in chan_cal(), something is wrong with this
 	// !! optimization disabled for now
@@ -1058,8 +1052,25 @@ void YMF262::writeReg(unsigned r, byte v, EmuTime::param time)
 }
 void YMF262::writeReg512(unsigned r, byte v, EmuTime::param time)
 {
-	updateStream(time); // TODO optimize only for regs that directly influence sound
+	if (r & 0xE0) {
+		// 20-FF, 120-1FF: these only influence the generated sound
+		reg[r] = v; // already visible for readReg()
+		deferWrite(r, v, time);
+	} else {
+		// control registers: timers, IRQ, OPL3 mode, ...
+		updateStream(time);
+		writeRegDirect(r, v, time);
+	}
+}
+
+void YMF262::applyDeferredWrite(unsigned r, uint8_t v, EmuTime::param time,
+                                float /*fraction*/)
+{
+	// Keep the value from writeReg512(), there may be more (later) writes
+	// to this register queued.
+	byte current = reg[r];
 	writeRegDirect(r, v, time);
+	reg[r] = current;
 }
 void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
 {
@@ -1409,6 +1420,8 @@ void YMF262::writeRegDirect(unsigned r, byte v, EmuTime::param time)
 
 void YMF262::reset(EmuTime::param time)
 {
+	flushDeferredWrites(time);
+
 	eg_cnt = 0;
 
 	noise_rng = 1; // noise shift register
@@ -1469,6 +1482,8 @@ YMF262::YMF262(const std::string& name_,
 	OPL3_mode = false;
 	status = status2 = statusMask = 0;
 
+	phase_modulation = phase_modulation2 = 0;
+
 	// avoid (harmless) UMR in serialize()
 	memset(chanout, 0, sizeof(chanout));
 	memset(reg, 0, sizeof(reg));
@@ -1481,6 +1496,7 @@ YMF262::YMF262(const std::string& name_,
 		for (const auto& e : sin.tab) std::cout << e << '\n';
 	}
 
+	enableParallelGeneration();
 	registerSound(config);
 	reset(config.getMotherBoard().getCurrentTime()); // must come after registerSound() because of call to setSoftwareVolume() via setMixLevel()
 }
@@ -1503,7 +1519,7 @@ byte YMF262::peekStatus() const
 	return status | status2;
 }
 
-bool YMF262::checkMuteHelper()
+bool YMF262::checkMuteHelper() const
 {
 	// TODO this doesn't always mute when possible
 	for (auto& ch : channel) {
@@ -1540,6 +1556,17 @@ float YMF262::getAmplificationFactorImpl() const
 	return 1.0f / 4096.0f;
 }
 
+bool YMF262::allChannelsIdle() const
+{
+	return checkMuteHelper();
+}
+
+void YMF262::skipChannels(unsigned /*num*/)
+{
+	// Same as the muted case in generateChannels(): the internal state is
+	// not updated.
+}
+
 void YMF262::generateChannels(float** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -1574,31 +1601,31 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 				auto& ch0 = channel[k + i + 0];
 				auto& ch3 = channel[k + i + 3];
 				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
+				ch0.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				if (ch0.extended) {
 					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
+					ch3.chan_calc_ext(lfo_am, phase_modulation, phase_modulation2);
 				} else {
 					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+					ch3.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				}
 			}
 		}
 
 		// channels 6,7,8 rhythm or 2op mode
 		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
+			channel[6].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[7].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[8].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 		} else {
 			// Rhythm part
 			chan_calc_rhythm(lfo_am);
 		}
 
 		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		channel[15].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[16].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[17].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 
 		for (auto i : xrange(18)) {
 			bufs[i][2 * j + 0] += int(chanout[i] & pan[4 * i + 0]);
@@ -1678,6 +1705,7 @@ void YMF262::Channel::serialize(Archive& a, unsigned /*version*/)
 
 // version 1: initial version
 // version 2: added alreadySignaledNEW2
+// version 3: added deferredWrites
 template<typename Archive>
 void YMF262::serialize(Archive& a, unsigned version)
 {
@@ -1706,6 +1734,9 @@ void YMF262::serialize(Archive& a, unsigned version)
 		alreadySignaledNEW2 = true; // we can't know the actual value,
 									// but 'true' is the safest value
 	}
+	if (a.versionAtLeast(version, 3)) {
+		serializeDeferredWrites(a);
+	}
 
 	// TODO restore more state by rewriting register values
 	//   this handles pan
@@ -1730,6 +1761,7 @@ YMF262::Debuggable::Debuggable(MSXMotherBoard& motherBoard_,
 
 byte YMF262::Debuggable::read(unsigned address)
 {
+	// no need to flush deferred writes, reg[] is already up-to-date
 	auto& ymf262 = OUTER(YMF262, debuggable);
 	return ymf262.peekReg(address);
 }
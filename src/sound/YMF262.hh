@@ -115,8 +115,8 @@ private:
 	class Channel {
 	public:
 		Channel();
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am, int& phase_modulation, int& phase_modulation2);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -144,8 +144,15 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool allChannelsIdle() const override;
+	void skipChannels(unsigned num) override;
+
+	// ResampledSoundDevice
+	void applyDeferredWrite(unsigned r, uint8_t v, EmuTime::param time,
+	                        float fraction) override;
 
 	void callback(byte flag) override;
+	[[nodiscard]] std::string_view getTimerOwnerName() const override { return getName(); }
 
 	void writeRegDirect(unsigned r, byte v, EmuTime::param time);
 	void init_tables();
@@ -163,7 +170,7 @@ private:
 	void set_ksl_tl(unsigned sl, byte v);
 	void set_ar_dr(unsigned sl, byte v);
 	void set_sl_rr(unsigned sl, byte v);
-	bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	[[nodiscard]] inline bool isExtended(unsigned ch) const;
 	[[nodiscard]] inline Channel& getFirstOfPair(unsigned ch);
@@ -192,6 +199,10 @@ private:
 	IRQHelper irq;
 
 	int chanout[18]; // 18 channels
+	// Per chip (not global) because chips can be generated in parallel.
+	int phase_modulation;  // phase modulation input (SLOT 2)
+	int phase_modulation2; // phase modulation input (SLOT 3
+	                       // in 4 operator channels)
 
 	byte reg[512];
 	Channel channel[18];	// OPL3 chips have 18 channels
@@ -221,7 +232,7 @@ private:
 	const bool isYMF278;		// true iff this is actually a YMF278
 					// ATM only used for NEW2 bit
 };
-SERIALIZE_CLASS_VERSION(YMF262, 2);
+SERIALIZE_CLASS_VERSION(YMF262, 3);
 
 } // namespace openmsx
 
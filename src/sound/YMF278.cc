@@ -807,6 +807,7 @@ YMF278::YMF278(const std::string& name_, int ramSize_,
 	memAdr = 0; // avoid UMR
 	ranges::fill(regs, 0);
 
+	enableParallelGeneration();
 	registerSound(config);
 	reset(motherBoard.getCurrentTime()); // must come after registerSound() because of call to setSoftwareVolume() via setMixLevel()
 }
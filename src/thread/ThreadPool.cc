@@ -0,0 +1,149 @@
+#include "ThreadPool.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+// Identifies the worker (if any) that is running on the current thread.
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned numThreads)
+	: nextWorker(0)
+	, stopping(false)
+{
+	if (numThreads == 0) {
+		unsigned hw = std::thread::hardware_concurrency();
+		numThreads = (hw > 1) ? hw - 1 : 1;
+	}
+	workers.reserve(numThreads);
+	repeat(numThreads, [&] { workers.push_back(std::make_unique<Worker>()); });
+	threads.reserve(numThreads);
+	for (auto i : xrange(numThreads)) {
+		threads.emplace_back([this, i]() { run(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCond.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool oneInstance;
+	return oneInstance;
+}
+
+void ThreadPool::enqueue(Job job, Priority prio)
+{
+	unsigned idx = (currentPool == this)
+	             ? currentWorker
+	             : (nextWorker++ % unsigned(workers.size()));
+	{
+		// Increment under the lock, this avoids lost wakeups. And
+		// before the job is visible to the workers, so that 'pending'
+		// can't drop below zero.
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		++pending;
+	}
+	{
+		auto& worker = *workers[idx];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.queues[int(prio)].push_back(std::move(job));
+	}
+	sleepCond.notify_one();
+}
+
+bool ThreadPool::tryRunJob(unsigned self)
+{
+	auto num = unsigned(workers.size());
+	for (auto prio : xrange(NUM_PRIORITIES)) {
+		for (auto i : xrange(num)) {
+			unsigned victim = (self + i) % num;
+			auto& worker = *workers[victim];
+			Job job;
+			{
+				std::lock_guard<std::mutex> lock(worker.mutex);
+				auto& queue = worker.queues[prio];
+				if (queue.empty()) continue;
+				if (victim == self) {
+					// own queue: oldest job first
+					job = std::move(queue.front());
+					queue.pop_front();
+				} else {
+					// steal from the other end
+					job = std::move(queue.back());
+					queue.pop_back();
+				}
+			}
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				assert(pending != 0);
+				--pending;
+			}
+			job();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::run(unsigned self)
+{
+	currentPool = this;
+	currentWorker = self;
+	while (true) {
+		if (tryRunJob(self)) continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCond.wait(lock, [&] { return (pending != 0) || stopping; });
+		if (stopping && (pending == 0)) return;
+	}
+}
+
+void ThreadPool::parallelForImpl(
+	unsigned n, std::function<void(unsigned)> f, Priority prio)
+{
+	struct State {
+		State(unsigned n_, std::function<void(unsigned)> f_)
+			: f(std::move(f_)), n(n_), next(0), done(0) {}
+
+		void work() {
+			while (true) {
+				unsigned i = next++;
+				if (i >= n) return;
+				f(i);
+				if (++done == n) {
+					std::lock_guard<std::mutex> lock(mutex);
+					cond.notify_all();
+				}
+			}
+		}
+
+		std::function<void(unsigned)> f;
+		const unsigned n;
+		std::atomic<unsigned> next;
+		std::atomic<unsigned> done;
+		std::mutex mutex;
+		std::condition_variable cond;
+	};
+	auto state = std::make_shared<State>(n, std::move(f));
+
+	// Helpers that only start after all items are claimed return
+	// immediately, they don't touch 'f' anymore.
+	unsigned numHelpers = std::min(n - 1, getNumThreads());
+	repeat(numHelpers, [&] { enqueue([state] { state->work(); }, prio); });
+	state->work();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cond.wait(lock, [&] { return state->done == n; });
+}
+
+} // namespace openmsx
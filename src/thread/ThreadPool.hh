@@ -0,0 +1,109 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace openmsx {
+
+/** A pool of worker threads to offload CPU intensive work from the
+  * emulation thread (e.g. compression, image encoding).
+  *
+  * Each worker has its own job queue. Jobs submitted from within a worker go
+  * to that worker's queue, jobs submitted from other threads are distributed
+  * round-robin over the workers. A worker first takes jobs from its own
+  * queue, when that's empty it tries to steal work from the other workers.
+  * Jobs with a higher priority are always preferred over jobs with a lower
+  * priority (also when stealing).
+  *
+  * Jobs should only operate on data they own (or that is guaranteed to stay
+  * alive and unmodified until the job has finished). In particular they must
+  * not access emulation state, the Tcl interpreter or SDL.
+  */
+class ThreadPool
+{
+public:
+	enum class Priority { HIGH, NORMAL, LOW };
+
+	/** Create a pool with the given number of worker threads. The default
+	  * (zero) means one less than the number of hardware threads (the
+	  * emulation thread keeps one), but at least one worker.
+	  */
+	explicit ThreadPool(unsigned numThreads = 0);
+
+	/** Executes all still pending jobs and then stops the workers. */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** The pool that is shared by all openMSX subsystems. */
+	[[nodiscard]] static ThreadPool& instance();
+
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size()); }
+
+	/** Schedule 'f' for execution on one of the workers. The result (or
+	  * the exception thrown by 'f') can be retrieved via the returned
+	  * future.
+	  */
+	template<typename F>
+	[[nodiscard]] auto submit(F&& f, Priority prio = Priority::NORMAL)
+	{
+		using R = std::invoke_result_t<std::decay_t<F>>;
+		// std::function requires a copyable functor, packaged_task is
+		// move-only, hence the shared_ptr.
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		auto result = task->get_future();
+		enqueue([task] { (*task)(); }, prio);
+		return result;
+	}
+
+	/** Calls 'f(i)' for all 'i' in the range [0, n) and returns when all
+	  * calls have finished. The calling thread participates in the work,
+	  * so this can also be used from within a job without risking a
+	  * deadlock. 'f' must not throw.
+	  */
+	template<typename F>
+	void parallelFor(unsigned n, F&& f, Priority prio = Priority::HIGH)
+	{
+		if (n == 0) return;
+		if (n == 1) { f(0); return; }
+		parallelForImpl(n, std::function<void(unsigned)>(std::forward<F>(f)), prio);
+	}
+
+private:
+	using Job = std::function<void()>;
+	static constexpr int NUM_PRIORITIES = 3;
+
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Job> queues[NUM_PRIORITIES];
+	};
+
+	void enqueue(Job job, Priority prio);
+	[[nodiscard]] bool tryRunJob(unsigned self);
+	void run(unsigned self);
+	void parallelForImpl(unsigned n, std::function<void(unsigned)> f, Priority prio);
+
+private:
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCond;
+	unsigned pending = 0; // queued but not yet started jobs, protected by sleepMutex
+	std::atomic<unsigned> nextWorker;
+	bool stopping; // protected by sleepMutex
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,213 @@
+#include "catch.hpp"
+#include "BinaryReplay.hh"
+#include "DeltaBlock.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> makeData(size_t size, uint8_t seed)
+{
+	std::vector<uint8_t> result(size);
+	for (auto i : xrange(size)) result[i] = uint8_t(seed + (i / 7));
+	return result;
+}
+
+static std::vector<uint8_t> getData(const DeltaBlock& block)
+{
+	std::vector<uint8_t> result(block.getSize());
+	block.apply(result.data(), result.size());
+	return result;
+}
+
+TEST_CASE("BinaryReplay")
+{
+	std::string filename;
+	{
+		auto fp = FileOperations::openUniqueFile(FileOperations::getTempDir(), filename);
+		REQUIRE(fp);
+	}
+
+	auto state0 = makeData(100, 1);
+	auto state1 = makeData(0, 2);
+	auto blob0 = makeData(5000, 3);
+	auto blob1 = makeData(70000, 4);
+	auto events = makeData(300, 5);
+	auto time0 = EmuTime::zero() + EmuDuration(1.0);
+	auto time1 = EmuTime::zero() + EmuDuration(61.5);
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks0 = {
+		std::make_shared<DeltaBlockCopy>(blob0.data(), blob0.size()),
+		std::make_shared<DeltaBlockCopy>(blob1.data(), blob1.size()),
+	};
+	std::vector<std::shared_ptr<DeltaBlock>> blocks1; // none
+	{
+		BinaryReplayWriter writer(filename);
+		writer.addSnapshot(time0, 0, state0, blocks0);
+		writer.addSnapshot(time1, 17, state1, blocks1);
+		writer.addEventLog(events, {});
+		writer.close();
+	}
+	CHECK(BinaryReplayReader::isBinaryReplay(filename));
+
+	SECTION("round trip") {
+		BinaryReplayReader reader(filename);
+		auto snapshots = reader.getSnapshots();
+		REQUIRE(snapshots.size() == 2);
+		CHECK(snapshots[0].time == time0);
+		CHECK(snapshots[0].eventCount == 0);
+		CHECK(snapshots[1].time == time1);
+		CHECK(snapshots[1].eventCount == 17);
+
+		MemBuffer<uint8_t> data;
+		size_t size;
+		std::vector<std::shared_ptr<DeltaBlock>> blocks;
+		reader.load(snapshots[0], data, size, blocks);
+		REQUIRE(size == state0.size());
+		CHECK(memcmp(data.data(), state0.data(), size) == 0);
+		REQUIRE(blocks.size() == 2);
+		CHECK(getData(*blocks[0]) == blob0);
+		CHECK(getData(*blocks[1]) == blob1);
+
+		reader.load(snapshots[1], data, size, blocks);
+		CHECK(size == 0);
+		CHECK(blocks.empty());
+
+		reader.load(reader.getEventLog(), data, size, blocks);
+		REQUIRE(size == events.size());
+		CHECK(memcmp(data.data(), events.data(), size) == 0);
+	}
+	SECTION("blocks are stored as a diff") {
+		// Same as for the in-memory snapshots: a block is a diff
+		// against the same block of the previously loaded snapshot.
+		auto blob2 = blob1;
+		blob2[1234] ^= 0xff;
+		std::vector<std::shared_ptr<DeltaBlock>> blocks2 = {
+			std::make_shared<DeltaBlockCopy>(blob2.data(), blob2.size()),
+		};
+		std::vector<std::shared_ptr<DeltaBlock>> blocks3 = {
+			std::make_shared<DeltaBlockCopy>(blob1.data(), blob1.size()),
+		};
+		// Unrelated block, with the same size and index as in the
+		// snapshots.
+		auto blob4 = makeData(blob1.size(), 100);
+		std::vector<std::shared_ptr<DeltaBlock>> blocks4 = {
+			std::make_shared<DeltaBlockCopy>(blob4.data(), blob4.size()),
+		};
+		{
+			BinaryReplayWriter writer(filename);
+			writer.addSnapshot(time0, 0, state0, blocks3);
+			writer.addSnapshot(time1, 0, state0, blocks2);
+			writer.addEventLog(events, blocks4);
+			writer.close();
+		}
+		auto reader = std::make_unique<BinaryReplayReader>(filename);
+		auto snapshots = reader->getSnapshots();
+		REQUIRE(snapshots.size() == 2);
+		MemBuffer<uint8_t> data;
+		size_t size;
+		std::vector<std::shared_ptr<DeltaBlock>> first, second, eventBlocks;
+		reader->load(snapshots[0], data, size, first);
+		reader->load(reader->getEventLog(), data, size, eventBlocks);
+		reader->load(snapshots[1], data, size, second);
+		REQUIRE(first.size() == 1);
+		REQUIRE(second.size() == 1);
+		REQUIRE(eventBlocks.size() == 1);
+		CHECK(dynamic_cast<DeltaBlockCopy*>(first[0].get()));
+		// the event log doesn't take part in the diffs
+		CHECK(dynamic_cast<DeltaBlockCopy*>(eventBlocks[0].get()));
+		auto* diff = dynamic_cast<DeltaBlockDiff*>(second[0].get());
+		REQUIRE(diff);
+		CHECK(&diff->getReference() == first[0].get());
+		CHECK(getData(*first[0]) == blob1);
+		CHECK(getData(*second[0]) == blob2);
+		CHECK(getData(*eventBlocks[0]) == blob4);
+		CHECK(second[0]->getMemorySize() < 1000);
+
+		// The event log blocks and, once the reader is gone, the
+		// reference block get compressed (in the background).
+		CHECK(first[0]->getMemorySize() == blob1.size());
+		reader.reset();
+		auto compressed = [&] {
+			return (first[0]->getMemorySize() < blob1.size()) &&
+			       (eventBlocks[0]->getMemorySize() < blob4.size());
+		};
+		for (int i = 0; (i < 1000) && !compressed(); ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		CHECK(compressed());
+		CHECK(getData(*first[0]) == blob1);
+		CHECK(getData(*second[0]) == blob2);
+		CHECK(getData(*eventBlocks[0]) == blob4);
+	}
+	SECTION("overwrite the file that is being read") {
+		// A loaded replay only reads its snapshots on first use. Saving
+		// it back to the same file, and only then going back in time,
+		// must still find the original content.
+		BinaryReplayReader reader(filename);
+		{
+			BinaryReplayWriter writer(filename);
+			writer.addSnapshot(time1, 3, state1, blocks1);
+			writer.addEventLog(events, {});
+			writer.close();
+		}
+		MemBuffer<uint8_t> data;
+		size_t size;
+		std::vector<std::shared_ptr<DeltaBlock>> blocks;
+		reader.load(reader.getSnapshots()[0], data, size, blocks);
+		REQUIRE(size == state0.size());
+		CHECK(memcmp(data.data(), state0.data(), size) == 0);
+		REQUIRE(blocks.size() == 2);
+		CHECK(getData(*blocks[1]) == blob1);
+
+		BinaryReplayReader reader2(filename);
+		REQUIRE(reader2.getSnapshots().size() == 1);
+		CHECK(reader2.getSnapshots()[0].eventCount == 3);
+	}
+	SECTION("an unfinished save keeps the old file") {
+		{
+			BinaryReplayWriter writer(filename);
+			writer.addSnapshot(time1, 3, state1, blocks1);
+			// not closed, e.g. because of an exception
+		}
+		CHECK(!FileOperations::exists(filename + ".tmp"));
+		BinaryReplayReader reader(filename);
+		CHECK(reader.getSnapshots().size() == 2);
+	}
+	SECTION("corruption is detected") {
+		{
+			File file(filename, "rb+");
+			auto size = file.getSize();
+			file.seek(size / 2);
+			uint8_t b;
+			file.read(&b, 1);
+			b ^= 0x40;
+			file.seek(size / 2);
+			file.write(&b, 1);
+		}
+		BinaryReplayReader reader(filename);
+		auto snapshots = reader.getSnapshots();
+		REQUIRE(snapshots.size() == 2);
+		MemBuffer<uint8_t> data;
+		size_t size;
+		std::vector<std::shared_ptr<DeltaBlock>> blocks;
+		CHECK_THROWS_AS(reader.load(snapshots[0], data, size, blocks), MSXException);
+	}
+	SECTION("incomplete file") {
+		{
+			File file(filename, "rb+");
+			file.truncate(file.getSize() - 1);
+		}
+		CHECK(BinaryReplayReader::isBinaryReplay(filename));
+		CHECK_THROWS_AS(BinaryReplayReader(filename), MSXException);
+	}
+
+	FileOperations::unlink(filename);
+}
@@ -0,0 +1,155 @@
+#include "catch.hpp"
+#include "BitmapConverter.hh"
+#include "build-info.hh"
+#include "components.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Straightforward (slow) versions of all conversions, to compare the
+// (possibly SIMD optimized) BitmapConverter against.
+
+template<typename Pixel>
+static void refGraphic4(Pixel* out, const byte* vram, const Pixel* pal16)
+{
+	for (auto i : xrange(128)) {
+		out[2 * i + 0] = pal16[vram[i] >> 4];
+		out[2 * i + 1] = pal16[vram[i] & 15];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic5(Pixel* out, const byte* vram, const Pixel* pal16)
+{
+	for (auto i : xrange(128)) {
+		out[4 * i + 0] = pal16[ 0 + ((vram[i] >> 6) & 3)];
+		out[4 * i + 1] = pal16[16 + ((vram[i] >> 4) & 3)];
+		out[4 * i + 2] = pal16[ 0 + ((vram[i] >> 2) & 3)];
+		out[4 * i + 3] = pal16[16 + ((vram[i] >> 0) & 3)];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic6(Pixel* out, const byte* vram0, const byte* vram1,
+                        const Pixel* pal16)
+{
+	for (auto i : xrange(128)) {
+		out[4 * i + 0] = pal16[vram0[i] >> 4];
+		out[4 * i + 1] = pal16[vram0[i] & 15];
+		out[4 * i + 2] = pal16[vram1[i] >> 4];
+		out[4 * i + 3] = pal16[vram1[i] & 15];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic7(Pixel* out, const byte* vram0, const byte* vram1,
+                        const Pixel* pal256)
+{
+	for (auto i : xrange(128)) {
+		out[2 * i + 0] = pal256[vram0[i]];
+		out[2 * i + 1] = pal256[vram1[i]];
+	}
+}
+
+template<typename Pixel>
+static void refYJK(Pixel* out, const byte* vram0, const byte* vram1,
+                   const Pixel* pal16, const Pixel* pal32768, bool yae)
+{
+	for (auto i : xrange(64)) {
+		int p[4] = { vram0[2 * i + 0], vram1[2 * i + 0],
+		             vram0[2 * i + 1], vram1[2 * i + 1] };
+		int j = (p[2] & 7) + ((p[3] & 3) << 3) - ((p[3] & 4) << 3);
+		int k = (p[0] & 7) + ((p[1] & 3) << 3) - ((p[1] & 4) << 3);
+		for (auto n : xrange(4)) {
+			if (yae && (p[n] & 8)) {
+				out[4 * i + n] = pal16[p[n] >> 4];
+			} else {
+				int y = p[n] >> 3;
+				int r = std::clamp(y + j, 0, 31);
+				int g = std::clamp(y + k, 0, 31);
+				int b = std::clamp((5 * y - 2 * j - k) / 4, 0, 31);
+				out[4 * i + n] = pal32768[(r << 10) + (g << 5) + b];
+			}
+		}
+	}
+}
+
+template<typename Pixel>
+static void test()
+{
+	std::minstd_rand rnd(1234);
+	auto fill = [&](auto& v) {
+		for (auto& e : v) e = rnd();
+	};
+	std::vector<Pixel> pal16(2 * 16), pal256(256), pal32768(32768);
+	fill(pal16); fill(pal256); fill(pal32768);
+	BitmapConverter<Pixel> converter(pal16.data(), pal256.data(), pal32768.data());
+
+	// plane 0 at the start, plane 1 at the end: VRAM layout doesn't matter
+	// for the converter, but unaligned pointers do
+	std::vector<byte> vram(128 + 1 + 128);
+	const byte* vram0 = vram.data() + 1;
+	const byte* vram1 = vram.data() + 1 + 128;
+	std::vector<Pixel> expected(512), actual(512 + 1);
+	// also test an unaligned output buffer
+	for (Pixel* out : {actual.data(), actual.data() + 1}) {
+		for (auto iter : xrange(20)) {
+			fill(vram);
+			if (iter == 10) {
+				// palette change must be picked up
+				fill(pal16);
+				converter.palette16Changed();
+			}
+			if (iter & 1) {
+				// only extreme values, to test the clamping in YJK
+				for (auto& v : vram) v |= 0xF8;
+			}
+
+			// DisplayMode(reg0, reg1, reg25)
+			// Graphic4
+			refGraphic4(expected.data(), vram0, pal16.data());
+			converter.setDisplayMode(DisplayMode(0x06, 0, 0));
+			converter.convertLine(out, vram0);
+			CHECK(std::equal(out, out + 256, expected.data()));
+			// Graphic5
+			refGraphic5(expected.data(), vram0, pal16.data());
+			converter.setDisplayMode(DisplayMode(0x08, 0, 0));
+			converter.convertLine(out, vram0);
+			CHECK(std::equal(out, out + 512, expected.data()));
+			// Graphic6
+			refGraphic6(expected.data(), vram0, vram1, pal16.data());
+			converter.setDisplayMode(DisplayMode(0x0A, 0, 0));
+			converter.convertLinePlanar(out, vram0, vram1);
+			CHECK(std::equal(out, out + 512, expected.data()));
+			// Graphic7
+			refGraphic7(expected.data(), vram0, vram1, pal256.data());
+			converter.setDisplayMode(DisplayMode(0x0E, 0, 0));
+			converter.convertLinePlanar(out, vram0, vram1);
+			CHECK(std::equal(out, out + 256, expected.data()));
+			// Graphic7 + YJK
+			refYJK(expected.data(), vram0, vram1, pal16.data(), pal32768.data(), false);
+			converter.setDisplayMode(DisplayMode(0x0E, 0, 0x08));
+			converter.convertLinePlanar(out, vram0, vram1);
+			CHECK(std::equal(out, out + 256, expected.data()));
+			// Graphic7 + YJK + YAE
+			refYJK(expected.data(), vram0, vram1, pal16.data(), pal32768.data(), true);
+			converter.setDisplayMode(DisplayMode(0x0E, 0, 0x18));
+			converter.convertLinePlanar(out, vram0, vram1);
+			CHECK(std::equal(out, out + 256, expected.data()));
+		}
+	}
+}
+
+TEST_CASE("BitmapConverter")
+{
+#if HAVE_16BPP
+	SECTION("16bpp") { test<uint16_t>(); }
+#endif
+#if HAVE_32BPP || COMPONENT_GL
+	SECTION("32bpp") { test<uint32_t>(); }
+#endif
+}
@@ -0,0 +1,45 @@
+#include "catch.hpp"
+#include "CPUProfiler.hh"
+#include <sstream>
+
+using namespace openmsx;
+
+TEST_CASE("CPUProfiler")
+{
+	CPUProfiler profiler;
+	profiler.updateVisiblePage(1, 4 * 1 + 2);
+	profiler.updateVisiblePage(2, 3);
+	profiler.updateVisiblePage(3, 3);
+	CHECK(!profiler.isEnabled());
+	CHECK(profiler.getResults().empty());
+
+	CHECK(profiler.getSlot(0x0000) == 0);
+	CHECK(profiler.getSlot(0x4010) == 6);
+	CHECK(profiler.getSlot(0xFFFF) == 3);
+
+	profiler.record(profiler.getSlot(0x4010), 0x4010, 5);
+	profiler.record(profiler.getSlot(0x4010), 0x4010, 5);
+	profiler.record(profiler.getSlot(0x0038), 0x0038, 12);
+	profiler.record(profiler.getSlot(0xC000), 0xC000, 8);
+	profiler.record(0, 0x4010, 1); // same address, other slot
+
+	auto results = profiler.getResults();
+	REQUIRE(results.size() == 4);
+	CHECK(results[0].slot == 0); CHECK(results[0].address == 0x0038);
+	CHECK(results[0].entry.count == 1); CHECK(results[0].entry.cycles == 12);
+	CHECK(results[1].slot == 6); CHECK(results[1].address == 0x4010);
+	CHECK(results[1].entry.count == 2); CHECK(results[1].entry.cycles == 10);
+	CHECK(results[2].slot == 3); CHECK(results[2].address == 0xC000);
+	CHECK(results[3].slot == 0); CHECK(results[3].address == 0x4010);
+
+	std::ostringstream os;
+	profiler.writeFolded(os);
+	CHECK(os.str() ==
+		"slot 0-0;0x0038 12\n"
+		"slot 1-2;0x4010 10\n"
+		"slot 0-3;0xc000 8\n"
+		"slot 0-0;0x4010 1\n");
+
+	profiler.reset();
+	CHECK(profiler.getResults().empty());
+}
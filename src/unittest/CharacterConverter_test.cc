@@ -0,0 +1,66 @@
+#include "catch.hpp"
+#include "CharacterConverter.hh"
+#include "build-info.hh"
+#include "components.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Straightforward (slow) version, to compare the (possibly SIMD optimized)
+// CharacterConverter::draw6() and draw8() against.
+template<typename Pixel>
+static void refDraw(Pixel* out, unsigned num, Pixel fg, Pixel bg, byte pattern)
+{
+	for (auto i : xrange(num)) {
+		out[i] = (pattern & (0x80 >> i)) ? fg : bg;
+	}
+}
+
+template<typename Pixel>
+static void test()
+{
+	using Converter = CharacterConverter<Pixel>;
+	std::minstd_rand rnd(1234);
+	const Pixel guard = Pixel(0x12345678);
+	std::vector<Pixel> expected(8);
+	std::vector<Pixel> buf(1 + 8 + 1);
+	for (auto pattern : xrange(256)) {
+		Pixel fg = Pixel(rnd());
+		Pixel bg = Pixel(rnd());
+		// also test an unaligned output buffer
+		for (auto offset : {0, 1}) {
+			for (unsigned num : {6, 8}) {
+				INFO("pattern " << pattern << ", offset " << offset << ", " << num << " pixels");
+				std::fill(begin(buf), end(buf), guard);
+				Pixel* start = buf.data() + offset;
+				Pixel* __restrict pixelPtr = start;
+				if (num == 6) {
+					Converter::draw6(pixelPtr, fg, bg, byte(pattern));
+				} else {
+					Converter::draw8(pixelPtr, fg, bg, byte(pattern));
+				}
+				CHECK(pixelPtr == (start + num));
+				refDraw(expected.data(), num, fg, bg, byte(pattern));
+				CHECK(std::equal(start, start + num, expected.data()));
+				// nothing is written outside the pixels
+				CHECK(std::all_of(buf.data(), start, [&](Pixel p) { return p == guard; }));
+				CHECK(std::all_of(start + num, buf.data() + buf.size(),
+				                  [&](Pixel p) { return p == guard; }));
+			}
+		}
+	}
+}
+
+TEST_CASE("CharacterConverter")
+{
+#if HAVE_16BPP
+	SECTION("16bpp") { test<uint16_t>(); }
+#endif
+#if HAVE_32BPP || COMPONENT_GL
+	SECTION("32bpp") { test<uint32_t>(); }
+#endif
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include "CommandException.hh"
+#include "xrange.hh"
+#include <array>
+
+using namespace openmsx;
+
+struct TestContext final : CompiledCondition::Context
+{
+	TestContext()
+	{
+		for (auto i : xrange(memory.size())) memory[i] = uint8_t(i ^ (i >> 8));
+		regs[0] = 0x2F;                        // A
+		regs[6] = 0x12; regs[7] = 0x34;        // HL
+		regs[20] = 0x41; regs[21] = 0x00;      // PC, page 1
+		ioports[0xA8] = 0b11'11'10'00;         // page 1 in slot 2
+		slotted[0x40000 * 2 + 0xFFFF] = uint8_t(~0b00'00'01'00); // page 1 in ss 1
+	}
+
+	uint8_t read(std::string_view name, int64_t address) override
+	{
+		auto get = [&](auto& array) {
+			if ((address < 0) || (address >= int64_t(array.size()))) {
+				throw CommandException("Invalid address");
+			}
+			return array[address];
+		};
+		if (name == "memory")         return get(memory);
+		if (name == "CPU regs")       return get(regs);
+		if (name == "ioports")        return get(ioports);
+		if (name == "slotted memory") return get(slotted);
+		throw CommandException("No such debuggable: ", name);
+	}
+	bool isExpanded(int ps) override { return ps == 2; }
+
+	std::array<uint8_t, 0x10000> memory;
+	std::array<uint8_t, 28> regs = {};
+	std::array<uint8_t, 0x100> ioports = {};
+	std::array<uint8_t, 0x100000> slotted = {};
+};
+
+static int64_t eval(std::string_view expr)
+{
+	static TestContext context;
+	auto compiled = CompiledCondition::compile(expr);
+	INFO(expr);
+	REQUIRE(compiled);
+	return compiled->eval(context);
+}
+
+TEST_CASE("CompiledCondition: operators")
+{
+	CHECK(eval("42") == 42);
+	CHECK(eval(" 0x2a ") == 42);
+	CHECK(eval("0b101 + 0o7") == 12);
+	CHECK(eval("1 + 2 * 3") == 7);
+	CHECK(eval("(1 + 2) * 3") == 9);
+	CHECK(eval("10 - 2 - 3") == 5);
+	CHECK(eval("-7 / 2") == -4); // rounds towards -infinity, like Tcl
+	CHECK(eval("7 / -2") == -4);
+	CHECK(eval("-7 % 2") == 1);  // sign of the divisor, like Tcl
+	CHECK(eval("7 % -2") == -1);
+	CHECK(eval("1 << 4 | 1") == 17);
+	CHECK(eval("0xF0 >> 4 & 3") == 3);
+	CHECK(eval("-16 >> 2") == -4);
+	CHECK(eval("6 ^ 3") == 5);
+	CHECK(eval("!0 + ~0") == 0);
+	CHECK(eval("-(-3)") == 3);
+	CHECK(eval("(1 < 2) + (2 <= 2) + (3 > 4) + (4 >= 5) + (1 == 1) + (1 != 1)") == 3);
+	CHECK(eval("5 && 7") == 1);
+	CHECK(eval("0 || 7") == 1);
+	CHECK(eval("0 && 7 || 0") == 0);
+	CHECK(eval("1 ? 2 : 3") == 2);
+	CHECK(eval("0 ? 2 : 0 ? 3 : 4") == 4);
+	CHECK(eval("1 + (0 ? 2 : 3) * 2") == 7);
+}
+
+TEST_CASE("CompiledCondition: commands")
+{
+	CHECK(eval("[reg A] == 0x2F") == 1);
+	CHECK(eval("[reg a]") == 0x2F);
+	CHECK(eval("[reg HL]") == 0x1234);
+	CHECK(eval("[reg H] * 256 + [reg L]") == 0x1234);
+	CHECK(eval("[peek 0x1234]") == (0x34 ^ 0x12));
+	CHECK(eval("[peek [reg HL]]") == (0x34 ^ 0x12));
+	CHECK(eval("[peek 0x1234 memory]") == (0x34 ^ 0x12));
+	CHECK(eval("[peek16 0x1234]") == (0x34 ^ 0x12) + 256 * (0x35 ^ 0x12));
+	CHECK(eval("[peek16_BE 0x1234]") == 256 * (0x34 ^ 0x12) + (0x35 ^ 0x12));
+	CHECK(eval("[peek_s8 0x80]") == -128);
+	CHECK(eval("[peek_s16 0x80]") == int16_t(0x8180));
+	CHECK(eval("[debug read memory 0x1234]") == (0x34 ^ 0x12));
+	CHECK(eval("[debug read {CPU regs} 0]") == 0x2F);
+	CHECK(eval("[debug read \"CPU regs\" 0]") == 0x2F);
+	CHECK(eval("[expr {[reg A] + 1}]") == 0x30);
+	CHECK(eval("[pc_in_slot 2]") == 1);
+	CHECK(eval("[pc_in_slot 2 1]") == 1);
+	CHECK(eval("[pc_in_slot 2 X]") == 1);
+	CHECK(eval("[pc_in_slot 2 0]") == 0);
+	CHECK(eval("[pc_in_slot 1]") == 0);
+	CHECK(eval("[pc_in_slot X 1]") == 1);
+}
+
+TEST_CASE("CompiledCondition: errors")
+{
+	CHECK_THROWS_AS(eval("1 / 0"), CommandException);
+	CHECK_THROWS_AS(eval("1 % 0"), CommandException);
+	CHECK_THROWS_AS(eval("1 << -1"), CommandException);
+	CHECK_THROWS_AS(eval("[peek 0x10000]"), CommandException);
+	CHECK_THROWS_AS(eval("[peek16 0xFFFF]"), CommandException);
+	CHECK_THROWS_AS(eval("[peek 0 foo]"), CommandException);
+	CHECK(eval("0 && [peek 0x10000]") == 0); // not evaluated
+	CHECK(eval("1 || (1 / 0)") == 1);
+}
+
+TEST_CASE("CompiledCondition: not supported")
+{
+	for (auto expr : {
+		"", "$a == 1", "[reg A 5]", "[reg Q]", "1.5 > 1", "1e3", "010",
+		"2 ** 3", "abs(-1)", "\"a\" eq \"a\"", "1 eq 1", "[foo]",
+		"[peek $a]", "[peek 0 memory extra]", "[pc_in_slot 1 0 2]",
+		"[pc_in_slot 4]", "[debug write memory 0 0]", "(1 + 2",
+		"1 +", "[reg A]]", "true", "[peek16 [reg HL]",
+		"1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+1))))))))))))))))",
+	}) {
+		INFO(expr);
+		CHECK(!CompiledCondition::compile(expr));
+	}
+}
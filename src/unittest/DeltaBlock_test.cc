@@ -0,0 +1,193 @@
+#include "catch.hpp"
+#include "DeltaBlock.hh"
+#include "MemBuffer.hh"
+#include "random.hh"
+#include "xrange.hh"
+#include <cstring>
+#include <vector>
+
+using namespace openmsx;
+
+static void check(const DeltaBlock& block, const std::vector<uint8_t>& expected)
+{
+	MemBuffer<uint8_t> buf(expected.size());
+	block.apply(buf.data(), expected.size());
+	CHECK(memcmp(buf.data(), expected.data(), expected.size()) == 0);
+}
+
+TEST_CASE("DeltaBlock: async diffs")
+{
+	// Diffs are calculated in the background. Modifying the source data
+	// right after creating a block must not influence the result.
+	const size_t size = 10000;
+	std::vector<uint8_t> data(size);
+	for (auto i : xrange(size)) data[i] = uint8_t(i * 7);
+
+	LastDeltaBlocks lastBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	for (auto n : xrange(20)) {
+		blocks.push_back(lastBlocks.createNew(data.data(), data.data(), size));
+		expected.push_back(data);
+		// small changes (diff) and occasionally large ones (new copy)
+		data[(n * 97) % size] ^= 0xff;
+		data[(n * 331 + 5) % size] += 3;
+		if ((n % 7) == 6) {
+			for (auto& d : data) d = uint8_t(d + n);
+		}
+	}
+	lastBlocks.clear();
+
+	for (auto i : xrange(blocks.size())) {
+		check(*blocks[i], expected[i]);
+		CHECK(blocks[i]->isReady());
+	}
+}
+
+TEST_CASE("DeltaBlock: diff round trip")
+{
+	// Exercise the (SIMD) scan routines with runs of all lengths and at all
+	// offsets, including the borders of the buffer.
+	for (int size : {1, 2, 15, 16, 17, 31, 32, 33, 127, 128, 129, 1000, 4099}) {
+		std::vector<uint8_t> oldData(size);
+		for (auto& d : oldData) d = uint8_t(random_32bit());
+		auto ref = std::make_shared<DeltaBlockCopy>(oldData.data(), size);
+
+		for (auto changes : {0, 1, 3, 20, 200}) {
+			auto newData = oldData;
+			repeat(changes, [&] {
+				auto pos = random_int(0, size - 1);
+				auto len = random_int(1, 40);
+				for (auto i : xrange(pos, std::min(pos + len, size))) {
+					newData[i] = uint8_t(newData[i] + 1);
+				}
+			});
+			DeltaBlockDiff diff(ref, newData.data(), size);
+			check(diff, newData);
+			check(*ref, oldData);
+		}
+	}
+}
+
+TEST_CASE("DeltaBlock: dirty pages")
+{
+	const size_t size = 64 * 1024 + 100; // last page is partial
+	std::vector<uint8_t> data(size);
+	for (auto i : xrange(size)) data[i] = uint8_t(i * 13);
+	DirtyPages dirty(size);
+	auto write = [&](size_t addr, uint8_t value) {
+		dirty.mark(addr);
+		data[addr] = value;
+	};
+
+	LastDeltaBlocks lastBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	auto snapshot = [&] {
+		blocks.push_back(lastBlocks.createNew(data.data(), data.data(), size, &dirty));
+		expected.push_back(data);
+		dirty.clear();
+	};
+
+	snapshot(); // initially all dirty
+	snapshot(); // nothing written
+	CHECK(blocks[1] == blocks[0]);
+
+	write(0, 1);
+	write(DirtyPages::PAGE_SIZE - 1, 2); // same page
+	write(3 * DirtyPages::PAGE_SIZE, 3);
+	write(4 * DirtyPages::PAGE_SIZE, 4); // adjacent page
+	write(size - 1, 5);
+	snapshot();
+	write(10 * DirtyPages::PAGE_SIZE + 7, 6);
+	snapshot();
+	dirty.mark(20 * DirtyPages::PAGE_SIZE, 3 * DirtyPages::PAGE_SIZE); // no actual change
+	snapshot();
+	snapshot();
+	CHECK(blocks[5] == blocks[4]);
+	lastBlocks.clear();
+
+	for (auto i : xrange(blocks.size())) {
+		check(*blocks[i], expected[i]);
+	}
+}
+
+TEST_CASE("DeltaBlock: memory size")
+{
+	const size_t size = 10000;
+	std::vector<uint8_t> data(size);
+	for (auto i : xrange(size)) data[i] = uint8_t(i);
+
+	auto ref = std::make_shared<DeltaBlockCopy>(data.data(), size);
+	CHECK(ref->getMemorySize() == size);
+
+	data[1234] ^= 0xff;
+	DeltaBlockDiff diff(ref, data.data(), size);
+	CHECK(diff.getMemorySize() == diff.getDeltaSize());
+	CHECK(diff.getMemorySize() < size);
+}
+
+TEST_CASE("DeltaBlock: spill")
+{
+	const size_t size = 10000;
+	std::vector<uint8_t> data(size);
+	for (auto i : xrange(size)) data[i] = uint8_t(i * 3);
+
+	LastDeltaBlocks lastBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	for (auto n : xrange(20)) {
+		blocks.push_back(lastBlocks.createNew(data.data(), data.data(), size));
+		expected.push_back(data);
+		data[(n * 97) % size] ^= 0xff;
+		if ((n % 7) == 6) {
+			for (auto& d : data) d = uint8_t(d + n);
+		}
+	}
+
+	for (auto i : xrange(blocks.size())) {
+		check(*blocks[i], expected[i]); // also waits till diffs are ready
+	}
+
+	// Blocks that are still in use as reference are not moved to the
+	// file, but all blocks remain usable.
+	auto file = std::make_shared<SpillFile>();
+	for (auto& b : blocks) b->spill(file);
+	for (auto& b : blocks) b->spill(file); // a 2nd time does nothing
+	CHECK(file->getSize() > 0);
+	for (auto i : xrange(blocks.size())) {
+		check(*blocks[i], expected[i]);
+	}
+	CHECK(blocks[1]->getMemorySize() == 0); // a diff
+	lastBlocks.clear();
+}
+
+// Realistic RAM images: mostly unchanged, with a few modified regions. Run
+// with:  unittest "[benchmark]"
+TEST_CASE("DeltaBlock: benchmark", "[.][benchmark]")
+{
+	for (int size : {64 * 1024, 512 * 1024, 4096 * 1024}) {
+		std::vector<uint8_t> oldData(size);
+		for (auto& d : oldData) d = uint8_t(random_32bit());
+		auto newData = oldData;
+		repeat(size / 4096, [&] {
+			auto pos = random_int(0, size - 64);
+			for (auto i : xrange(pos, pos + random_int(1, 64))) {
+				newData[i] ^= 0x55;
+			}
+		});
+		auto ref = std::make_shared<DeltaBlockCopy>(oldData.data(), size);
+
+		BENCHMARK("calcDelta " + std::to_string(size / 1024) + "kB") {
+			DeltaBlockDiff diff(ref, newData.data(), size);
+			return diff.getDeltaSize();
+		};
+
+		DeltaBlockDiff diff(ref, newData.data(), size);
+		MemBuffer<uint8_t> buf(size);
+		BENCHMARK("applyDelta " + std::to_string(size / 1024) + "kB") {
+			diff.apply(buf.data(), size);
+			return buf[0];
+		};
+	}
+}
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "InstructionTrace.hh"
+#include "Dasm.hh"
+#include "FileOperations.hh"
+#include "xrange.hh"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace openmsx;
+
+static void add(InstructionTrace& trace, unsigned pc)
+{
+	auto& r = trace.next();
+	r.time = 1000 * pc;
+	r.pc = pc;
+	r.af = r.bc = r.de = r.hl = r.ix = r.iy = r.sp = pc + 1;
+	r.opcode[0] = 0x00; // nop
+	trace.commit();
+}
+
+TEST_CASE("InstructionTrace: ring buffer")
+{
+	InstructionTrace trace;
+	CHECK(!trace.isEnabled());
+	trace.start(4);
+	CHECK(trace.isEnabled());
+	CHECK(trace.capacity() == 4);
+	CHECK(trace.size() == 0);
+
+	add(trace, 10);
+	add(trace, 11);
+	auto records = trace.getRecords();
+	REQUIRE(records.size() == 2);
+	CHECK(records[0].pc == 10);
+	CHECK(records[1].pc == 11);
+
+	for (auto pc : xrange(12u, 17u)) add(trace, pc);
+	CHECK(trace.size() == 4);
+	CHECK(trace.totalRecorded() == 7);
+	records = trace.getRecords();
+	REQUIRE(records.size() == 4);
+	for (auto i : xrange(4)) {
+		CHECK(records[i].pc == 13 + i);
+		CHECK(records[i].time == 1000 * (13 + i));
+		CHECK(records[i].hl == 14 + i);
+	}
+
+	trace.stop();
+	CHECK(!trace.isEnabled());
+	CHECK(trace.size() == 4); // data remains
+
+	trace.start(4); // same size, keeps data
+	CHECK(trace.size() == 4);
+	trace.start(8); // new size, starts empty
+	CHECK(trace.size() == 0);
+	add(trace, 20);
+	trace.clear();
+	CHECK(trace.size() == 0);
+	CHECK(trace.totalRecorded() == 0);
+}
+
+TEST_CASE("InstructionTrace: save")
+{
+	InstructionTrace trace;
+	trace.start(2);
+	for (auto pc : xrange(3u)) add(trace, pc);
+
+	auto filename = FileOperations::getTempDir() + "/openmsx-instruction-trace-test";
+	trace.save(filename);
+	std::ifstream file(filename, std::ios::binary);
+	std::vector<char> data{std::istreambuf_iterator<char>(file),
+	                       std::istreambuf_iterator<char>()};
+	file.close();
+	remove(filename.c_str());
+
+	REQUIRE(data.size() == sizeof(InstructionTrace::Header) + 2 * sizeof(InstructionTrace::Record));
+	InstructionTrace::Header header;
+	memcpy(&header, data.data(), sizeof(header));
+	CHECK(memcmp(header.magic, "oMSXtrc", 8) == 0);
+	CHECK(header.version == InstructionTrace::VERSION);
+	CHECK(header.recordSize == 32);
+	CHECK(header.numRecords == 2);
+	CHECK(header.totalRecords == 3);
+	InstructionTrace::Record r;
+	memcpy(&r, data.data() + sizeof(header), sizeof(r));
+	CHECK(r.pc == 1);
+	CHECK(r.sp == 2);
+	// little endian on disk
+	CHECK(uint8_t(data[sizeof(header) + 8]) == 1);
+	CHECK(uint8_t(data[sizeof(header) + 9]) == 0);
+}
+
+TEST_CASE("Dasm")
+{
+	auto check = [](std::initializer_list<byte> bytes, word pc,
+	                unsigned expectedLen, std::string_view expected) {
+		byte opcode[4] = {0, 0, 0, 0};
+		std::copy(bytes.begin(), bytes.end(), opcode);
+		std::string dest;
+		CHECK(dasm(opcode, pc, dest) == expectedLen);
+		CHECK(dest.substr(0, expected.size()) == expected);
+	};
+	check({0x00}, 0, 1, "nop");
+	check({0x3E, 0x12}, 0, 2, "ld     a,#12");
+	check({0xC3, 0x34, 0x12}, 0, 3, "jp     #1234");
+	check({0x18, 0xFE}, 0x4000, 2, "jr     #4000");
+	check({0xDD, 0x36, 0x05, 0x42}, 0, 4, "ld     (ix+#05),#42");
+	check({0xFD, 0x21, 0x34, 0x12}, 0, 4, "ld     iy,#1234");
+	check({0xED, 0xB0}, 0, 2, "ldir");
+}
@@ -0,0 +1,131 @@
+#include "catch.hpp"
+#include "ResampleHQ.hh"
+#include "Math.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+// Sample rates of some typical sound chips.
+struct Chip {
+	const char* name;
+	double rate;
+	unsigned channels;
+};
+static constexpr Chip chips[] = {
+	{"AY8910",    3579545.0 / 16,        1},
+	{"SCC",       3579545.0 / 32,        1},
+	{"YM2413",    3579545.0 / 72,        1},
+	{"OPL4 FM",   33868800.0 / (19 * 36), 2},
+	{"OPL4 wave", 44100.0,               2},
+};
+static constexpr double outputRates[] = {44100.0, 48000.0};
+
+// Resample a sine wave (same on all channels), return the outputs.
+template<unsigned CHANNELS>
+static std::vector<float> resampleSine(
+	const ResampleHQFilter& filter, double inFreq, double sineFreq, unsigned num)
+{
+	unsigned inNum = unsigned(num * filter.getRatio()) + filter.getFilterLen() + 4;
+	std::vector<float> in(inNum * CHANNELS);
+	for (auto i : xrange(inNum)) {
+		float s = float(sin(2 * M_PI * sineFreq * i / inFreq));
+		for (auto ch : xrange(CHANNELS)) in[CHANNELS * i + ch] = s;
+	}
+	std::vector<float> out(num * CHANNELS);
+	filter.calcOutputs<CHANNELS>(in.data(), 0.5f, out.data(), num);
+	return out;
+}
+
+template<unsigned CHANNELS>
+static void test(double inRate, double outRate)
+{
+	ResampleHQFilter filter(float(inRate / outRate));
+	CHECK((filter.getFilterLen() % 4) == 0);
+
+	auto peak = [](const std::vector<float>& v) {
+		return std::abs(*std::max_element(begin(v), end(v),
+			[](float a, float b) { return std::abs(a) < std::abs(b); }));
+	};
+
+	// A 1kHz tone passes unchanged ...
+	auto pass = resampleSine<CHANNELS>(filter, inRate, 1000.0, 1000);
+	CHECK(std::abs(peak(pass) - 1.0f) < 0.01f);
+	// ... and the channels are processed identically.
+	for (auto i : xrange(1000)) {
+		CHECK(pass[CHANNELS * i] == pass[CHANNELS * i + CHANNELS - 1]);
+	}
+
+	// Frequencies above the output Nyquist frequency are filtered out.
+	if (inRate > (1.5 * outRate)) {
+		auto stop = resampleSine<CHANNELS>(filter, inRate, 0.6 * outRate, 1000);
+		CHECK(peak(stop) < 0.01f);
+	}
+
+	// The (SIMD) calculation matches a plain dot product of the filter
+	// coefficients with the input samples. The positions cover both halves
+	// of the coefficient table (read forwards or backwards).
+	std::vector<float> in(20000 * CHANNELS);
+	for (auto i : xrange(in.size())) in[i] = float((i * 7919) % 1000) / 500.0f - 1.0f;
+	unsigned len = filter.getFilterLen();
+	std::vector<float> coeffs(len);
+	float pos = 0.25f;
+	for (auto n : xrange(1000)) {
+		float out[CHANNELS];
+		filter.calcOutputs<CHANNELS>(in.data(), pos, out, 1);
+		filter.getCoeffs(pos, coeffs.data());
+		const float* buf = &in[int(pos) * CHANNELS];
+		for (auto ch : xrange(CHANNELS)) {
+			double ref = 0.0;
+			double mag = 0.0;
+			for (auto i : xrange(len)) {
+				ref += double(coeffs[i]) * buf[CHANNELS * i + ch];
+				mag += std::abs(double(coeffs[i]) * buf[CHANNELS * i + ch]);
+			}
+			INFO("sample " << n << " channel " << ch);
+			CHECK(std::abs(out[ch] - ref) <= (1e-5 * mag));
+		}
+		pos += filter.getRatio();
+	}
+}
+
+TEST_CASE("ResampleHQ")
+{
+	for (const auto& chip : chips) {
+		for (auto outRate : outputRates) {
+			INFO(chip.name << " -> " << outRate);
+			if (chip.channels == 1) {
+				test<1>(chip.rate, outRate);
+			} else {
+				test<2>(chip.rate, outRate);
+			}
+		}
+	}
+}
+
+// Run with:  unittest "[benchmark]"
+TEST_CASE("ResampleHQ: benchmark", "[.][benchmark]")
+{
+	constexpr unsigned NUM = 1024; // output samples per block
+	for (const auto& chip : chips) {
+		for (auto outRate : outputRates) {
+			ResampleHQFilter filter(float(chip.rate / outRate));
+			unsigned inNum = unsigned(NUM * filter.getRatio()) + filter.getFilterLen() + 4;
+			std::vector<float> in(inNum * chip.channels);
+			for (auto i : xrange(in.size())) in[i] = float(i % 100) / 100.0f;
+			std::vector<float> out(NUM * chip.channels);
+			BENCHMARK(std::string(chip.name) + " -> " +
+			          std::to_string(int(outRate)) + "Hz") {
+				if (chip.channels == 1) {
+					filter.calcOutputs<1>(in.data(), 0.5f, out.data(), NUM);
+				} else {
+					filter.calcOutputs<2>(in.data(), 0.5f, out.data(), NUM);
+				}
+				return out[0];
+			};
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "SPSCRingBuffer.hh"
+#include "xrange.hh"
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("SPSCRingBuffer")
+{
+	SPSCRingBuffer<int> buf(5);
+	CHECK(buf.capacity() == 8); // rounded up to a power of two
+	CHECK(buf.size() == 0);
+	CHECK(buf.free() == 8);
+
+	int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	int out[10] = {};
+
+	// the buffer can be completely filled
+	CHECK(buf.push(in, 10) == 8);
+	CHECK(buf.size() == 8);
+	CHECK(buf.free() == 0);
+	CHECK(buf.push(in, 1) == 0);
+
+	CHECK(buf.pop(out, 3) == 3);
+	CHECK(out[0] == 0); CHECK(out[1] == 1); CHECK(out[2] == 2);
+	CHECK(buf.size() == 5);
+
+	// wraps around the end of the storage
+	CHECK(buf.push(&in[8], 2) == 2);
+	CHECK(buf.pop(out, 10) == 7);
+	int expected[7] = {3, 4, 5, 6, 7, 8, 9};
+	for (auto i : xrange(7)) CHECK(out[i] == expected[i]);
+	CHECK(buf.size() == 0);
+	CHECK(buf.pop(out, 1) == 0);
+
+	buf.push(in, 4);
+	buf.clear();
+	CHECK(buf.size() == 0);
+	CHECK(buf.free() == 8);
+
+	buf.resize(100);
+	CHECK(buf.capacity() == 128);
+	CHECK(buf.size() == 0);
+}
+
+TEST_CASE("SPSCRingBuffer: two threads")
+{
+	// Push and pop in chunks of different sizes, the consumer must see all
+	// values in order.
+	constexpr unsigned NUM = 1000000;
+	SPSCRingBuffer<unsigned> buf(1000);
+
+	std::thread producer([&] {
+		unsigned next = 0;
+		unsigned chunk[37];
+		while (next < NUM) {
+			unsigned n = std::min(1 + next % 37, NUM - next);
+			for (auto i : xrange(n)) chunk[i] = next + i;
+			unsigned pushed = unsigned(buf.push(chunk, n));
+			next += pushed;
+			if (pushed == 0) std::this_thread::yield();
+		}
+	});
+
+	unsigned next = 0;
+	unsigned errors = 0;
+	std::vector<unsigned> chunk(53);
+	while (next < NUM) {
+		unsigned n = unsigned(buf.pop(chunk.data(), 1 + next % 53));
+		for (auto i : xrange(n)) {
+			if (chunk[i] != next + i) ++errors;
+		}
+		next += n;
+		if (n == 0) std::this_thread::yield();
+	}
+	producer.join();
+
+	CHECK(errors == 0);
+	CHECK(buf.size() == 0);
+}
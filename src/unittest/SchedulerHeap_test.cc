@@ -0,0 +1,225 @@
+#include "catch.hpp"
+#include "SchedulerHeap.hh"
+#include "SchedulerQueue.hh"
+#include "random.hh"
+#include "xrange.hh"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace openmsx;
+
+struct SyncPoint {
+	uint64_t time;
+	int device;
+};
+struct LessSyncPoint {
+	bool operator()(const SyncPoint& x, const SyncPoint& y) const {
+		return x.time < y.time;
+	}
+};
+
+// Same interface for both queue types, with at most one pending syncpoint
+// per device.
+struct OldQueue {
+	void insert(const SyncPoint& sp) {
+		queue.insert(sp,
+		             [](SyncPoint& s) { s.time = std::numeric_limits<uint64_t>::max(); },
+		             LessSyncPoint());
+	}
+	bool remove(int device) {
+		return queue.remove([&](const SyncPoint& sp) { return sp.device == device; });
+	}
+	SyncPoint pop() {
+		auto result = queue.front();
+		queue.remove_front();
+		return result;
+	}
+	[[nodiscard]] bool empty() const { return queue.empty(); }
+
+	SchedulerQueue<SyncPoint> queue;
+};
+struct NewQueue {
+	explicit NewQueue(int numDevices) : handles(numDevices, NONE) {}
+	void insert(const SyncPoint& sp) {
+		assert(handles[sp.device] == NONE);
+		handles[sp.device] = queue.insert(sp);
+	}
+	bool remove(int device) {
+		auto h = handles[device];
+		if (h == NONE) return false;
+		handles[device] = NONE;
+		queue.remove(h);
+		return true;
+	}
+	SyncPoint pop() {
+		auto result = queue.front();
+		handles[result.device] = NONE;
+		queue.remove_front();
+		return result;
+	}
+	[[nodiscard]] bool empty() const { return queue.empty(); }
+
+	using Heap = SchedulerHeap<SyncPoint, LessSyncPoint>;
+	static constexpr Heap::Handle NONE = Heap::Handle(-1);
+	Heap queue;
+	std::vector<Heap::Handle> handles;
+};
+
+// A trace of scheduler operations. Each device is rescheduled when its
+// syncpoint is reached, some devices also frequently move their (pending)
+// syncpoint, like e.g. the VDP and the sound devices do.
+// This is a synthetic (random) trace, not one recorded from a running
+// machine: a recorded trace would depend on the machine configuration and
+// the software that runs, and it would have to be stored in the source tree.
+// Instead the number of devices is varied, a typical MSX machine has a few
+// dozen Schedulables.
+struct Op {
+	enum Type { POP, INSERT, REMOVE } type;
+	int device;
+	uint64_t time;
+};
+
+static std::vector<Op> createTrace(int numDevices, int numOps)
+{
+	std::vector<Op> trace;
+	std::vector<uint64_t> period(numDevices);
+	std::vector<bool> pending(numDevices, false);
+	for (auto& p : period) p = random_int(10, 10000);
+
+	OldQueue queue;
+	auto insert = [&](int device, uint64_t time) {
+		queue.insert({time, device});
+		pending[device] = true;
+		trace.push_back({Op::INSERT, device, time});
+	};
+	for (auto d : xrange(numDevices)) insert(d, period[d]);
+
+	uint64_t now = 0;
+	while (int(trace.size()) < numOps) {
+		if (random_int(0, 3) == 0) {
+			// reschedule a random device
+			int d = random_int(0, numDevices - 1);
+			if (pending[d]) {
+				queue.remove(d);
+				trace.push_back({Op::REMOVE, d, 0});
+			}
+			insert(d, now + random_int(1, int(period[d])));
+		} else {
+			auto sp = queue.pop();
+			now = sp.time;
+			pending[sp.device] = false;
+			trace.push_back({Op::POP, sp.device, 0});
+			insert(sp.device, now + period[sp.device]);
+		}
+	}
+	return trace;
+}
+
+template<typename Queue>
+static uint64_t replay(Queue& queue, const std::vector<Op>& trace)
+{
+	uint64_t result = 0;
+	for (const auto& op : trace) {
+		switch (op.type) {
+		case Op::POP: {
+			auto sp = queue.pop();
+			result = result * 31 + sp.time + sp.device;
+			break;
+		}
+		case Op::INSERT:
+			queue.insert({op.time, op.device});
+			break;
+		case Op::REMOVE:
+			queue.remove(op.device);
+			break;
+		}
+	}
+	while (!queue.empty()) {
+		auto sp = queue.pop();
+		result = result * 31 + sp.time + sp.device;
+	}
+	return result;
+}
+
+TEST_CASE("SchedulerHeap: same order as SchedulerQueue")
+{
+	// few distinct times, so there are many equivalent elements
+	const int numDevices = 50;
+	OldQueue oldQueue;
+	NewQueue newQueue(numDevices);
+	std::vector<bool> pending(numDevices, false);
+	repeat(20000, [&] {
+		int d = random_int(0, numDevices - 1);
+		switch (random_int(0, 2)) {
+		case 0:
+			if (!pending[d]) {
+				SyncPoint sp = {uint64_t(random_int(0, 20)), d};
+				oldQueue.insert(sp);
+				newQueue.insert(sp);
+				pending[d] = true;
+			}
+			break;
+		case 1:
+			CHECK(oldQueue.remove(d) == pending[d]);
+			CHECK(newQueue.remove(d) == pending[d]);
+			pending[d] = false;
+			break;
+		case 2:
+			REQUIRE(oldQueue.empty() == newQueue.empty());
+			if (!oldQueue.empty()) {
+				auto o = oldQueue.pop();
+				auto n = newQueue.pop();
+				CHECK(o.time == n.time);
+				CHECK(o.device == n.device);
+				pending[o.device] = false;
+			}
+			break;
+		}
+	});
+}
+
+TEST_CASE("SchedulerHeap: handles")
+{
+	SchedulerHeap<SyncPoint, LessSyncPoint> heap;
+	auto h1 = heap.insert({30, 1});
+	auto h2 = heap.insert({10, 2});
+	auto h3 = heap.insert({20, 3});
+	CHECK(heap.size() == 3);
+	CHECK(heap[h1].device == 1);
+	CHECK(heap[h2].device == 2);
+	CHECK(heap[h3].device == 3);
+	CHECK(heap.front().device == 2);
+	CHECK(heap.front_handle() == h2);
+
+	heap.remove(h3);
+	CHECK(heap.size() == 2);
+	CHECK(heap[h1].device == 1);
+	auto h4 = heap.insert({5, 4}); // reuses handle of the removed element
+	CHECK(h4 == h3);
+	CHECK(heap.front().device == 4);
+
+	heap.remove_front();
+	heap.remove_front();
+	CHECK(heap.front().device == 1);
+	heap.remove(h1);
+	CHECK(heap.empty());
+}
+
+// Run with:  unittest "[benchmark]"
+TEST_CASE("SchedulerHeap: benchmark", "[.][benchmark]")
+{
+	for (int numDevices : {8, 32, 128}) {
+		auto trace = createTrace(numDevices, 100000);
+		auto name = std::to_string(numDevices) + " devices";
+
+		BENCHMARK("SchedulerQueue " + name) {
+			OldQueue queue;
+			return replay(queue, trace);
+		};
+		BENCHMARK("SchedulerHeap " + name) {
+			NewQueue queue(numDevices);
+			return replay(queue, trace);
+		};
+	}
+}
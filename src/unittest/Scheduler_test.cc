@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "Scheduler.hh"
+#include "Schedulable.hh"
+#include "Thread.hh"
+
+using namespace openmsx;
+
+struct TestDevice final : Schedulable {
+	explicit TestDevice(Scheduler& s) : Schedulable(s) {}
+	void executeUntil(EmuTime::param /*time*/) override {}
+
+	using Schedulable::setSyncPoint;
+	using Schedulable::removeSyncPoint;
+
+	[[nodiscard]] uint64_t next() const {
+		EmuTime result = EmuTime::zero();
+		REQUIRE(pendingSyncPoint(result));
+		return (result - EmuTime::zero()).length();
+	}
+};
+
+// The Scheduler may only be used from the main thread.
+static void initMainThread()
+{
+	static bool done = false;
+	if (!done) {
+		Thread::setMainThread();
+		done = true;
+	}
+}
+
+static EmuTime at(uint64_t t) { return EmuTime::zero() + EmuDuration(t); }
+
+TEST_CASE("Scheduler: removeSyncPoint")
+{
+	initMainThread();
+	Scheduler scheduler;
+	TestDevice dev1(scheduler);
+	TestDevice dev2(scheduler);
+
+	// removeSyncPoint() removes the syncpoint that would be executed
+	// first, not the one that was inserted last. Devices like
+	// Keyboard::MsxKeyEventQueue rely on this.
+	dev1.setSyncPoint(at(20));
+	dev2.setSyncPoint(at(15));
+	dev1.setSyncPoint(at(10));
+	dev1.setSyncPoint(at(30));
+	dev2.setSyncPoint(at(5));
+	CHECK(dev1.next() == 10);
+	CHECK(dev2.next() == 5);
+
+	CHECK(dev1.removeSyncPoint());
+	CHECK(dev1.next() == 20);
+	CHECK(dev1.removeSyncPoint());
+	CHECK(dev1.next() == 30);
+	CHECK(dev1.removeSyncPoint());
+	CHECK(!dev1.removeSyncPoint());
+
+	// the other device is not affected
+	CHECK(dev2.removeSyncPoint());
+	CHECK(dev2.next() == 15);
+	CHECK(dev2.removeSyncPoint());
+	CHECK(!dev2.removeSyncPoint());
+}
+
+TEST_CASE("Scheduler: profile")
+{
+	initMainThread();
+	Scheduler scheduler;
+	TestDevice dev(scheduler);
+	CHECK(dev.getProfileName() == "TestDevice");
+
+	SchedulerProfile profile;
+	profile.add("A", 10);
+	profile.add("B", 30);
+	profile.add("A", 15);
+	auto sorted = profile.getSorted();
+	REQUIRE(sorted.size() == 2);
+	CHECK(sorted[0].first == "B");
+	CHECK(sorted[0].second.count == 1);
+	CHECK(sorted[1].first == "A");
+	CHECK(sorted[1].second.count == 2);
+	CHECK(sorted[1].second.hostTime == 25);
+	profile.reset();
+	CHECK(profile.getSorted().empty());
+}
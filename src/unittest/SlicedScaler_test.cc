@@ -0,0 +1,197 @@
+#include "catch.hpp"
+#include "SlicedScaler.hh"
+#include "HQ2xScaler.hh"
+#include "HQ2xLiteScaler.hh"
+#include "HQ3xScaler.hh"
+#include "HQ3xLiteScaler.hh"
+#include "MLAAScaler.hh"
+#include "SaI2xScaler.hh"
+#include "SaI3xScaler.hh"
+#include "Scale2xScaler.hh"
+#include "Scale3xScaler.hh"
+#include "PixelFormat.hh"
+#include "PixelOperations.hh"
+#include "RawFrame.hh"
+#include "ScalerOutput.hh"
+#include "build-info.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+// The simple and RGB-triplet scalers are not tested here: they read their
+// parameters from RenderSettings.
+
+template<typename Pixel>
+class MemoryScalerOutput final : public ScalerOutput<Pixel>
+{
+public:
+	MemoryScalerOutput(unsigned width_, unsigned height_)
+		: width(width_), height(height_), pixels(width * height) {}
+
+	[[nodiscard]] unsigned getWidth()  const override { return width; }
+	[[nodiscard]] unsigned getHeight() const override { return height; }
+	[[nodiscard]] Pixel* acquireLine(unsigned y) override { return &pixels[y * width]; }
+	void releaseLine(unsigned /*y*/, Pixel* /*buf*/) override {}
+	void fillLine(unsigned y, Pixel color) override {
+		std::fill_n(&pixels[y * width], width, color);
+	}
+
+	const unsigned width;
+	const unsigned height;
+	std::vector<Pixel> pixels;
+};
+
+template<typename Pixel>
+static PixelFormat getPixelFormat()
+{
+	if constexpr (sizeof(Pixel) == 2) {
+		return {16, 0xF800, 11, 3, 0x07E0, 5, 2, 0x001F, 0, 3, 0x0000, 0, 8};
+	} else {
+		return {32, 0x00FF0000, 16, 0, 0x0000FF00, 8, 0, 0x000000FF, 0, 0,
+		        0xFF000000, 24, 0};
+	}
+}
+
+// Blocks of a few colors (so that the edge detection of the scalers has
+// something to do) with some single pixel noise.
+template<typename Pixel>
+static std::unique_ptr<RawFrame> createFrame(const PixelFormat& format, unsigned height)
+{
+	auto frame = std::make_unique<RawFrame>(format, 320, height);
+	std::minstd_rand rnd(height);
+	Pixel colors[4] = { Pixel(rnd()), Pixel(rnd()), Pixel(rnd()), Pixel(rnd()) };
+	std::vector<Pixel> blocks(80 * (height / 4));
+	for (auto& b : blocks) b = colors[rnd() & 3];
+	for (auto y : xrange(height)) {
+		auto* line = frame->getLinePtrDirect<Pixel>(y);
+		for (auto x : xrange(320)) {
+			line[x] = ((rnd() & 31) == 0) ? Pixel(rnd())
+			                              : blocks[(y / 4) * 80 + x / 4];
+		}
+		frame->setLineWidth(y, 320);
+	}
+	return frame;
+}
+
+template<typename Pixel>
+struct ScalerInfo
+{
+	const char* name;
+	unsigned factor;
+	std::function<std::unique_ptr<Scaler<Pixel>>(const PixelOperations<Pixel>&)> create;
+};
+
+template<typename Pixel>
+static std::vector<ScalerInfo<Pixel>> getScalers(bool withMLAA)
+{
+	using Ops = PixelOperations<Pixel>;
+	std::vector<ScalerInfo<Pixel>> result = {
+		{"SaI",    2, [](const Ops& o) { return std::make_unique<SaI2xScaler   <Pixel>>(o); }},
+		{"ScaleNx",2, [](const Ops& o) { return std::make_unique<Scale2xScaler <Pixel>>(o); }},
+		{"hq",     2, [](const Ops& o) { return std::make_unique<HQ2xScaler    <Pixel>>(o); }},
+		{"hqlite", 2, [](const Ops& o) { return std::make_unique<HQ2xLiteScaler<Pixel>>(o); }},
+		{"SaI",    3, [](const Ops& o) { return std::make_unique<SaI3xScaler   <Pixel>>(o); }},
+		{"ScaleNx",3, [](const Ops& o) { return std::make_unique<Scale3xScaler <Pixel>>(o); }},
+		{"hq",     3, [](const Ops& o) { return std::make_unique<HQ3xScaler    <Pixel>>(o); }},
+		{"hqlite", 3, [](const Ops& o) { return std::make_unique<HQ3xLiteScaler<Pixel>>(o); }},
+	};
+	if (withMLAA) {
+		result.push_back({"MLAA", 2, [](const Ops& o) { return std::make_unique<MLAAScaler<Pixel>>(640, o); }});
+		result.push_back({"MLAA", 3, [](const Ops& o) { return std::make_unique<MLAAScaler<Pixel>>(960, o); }});
+	}
+	return result;
+}
+
+template<typename Pixel>
+static std::unique_ptr<Scaler<Pixel>> createSliced(
+	const ScalerInfo<Pixel>& info, const PixelOperations<Pixel>& ops, unsigned numBands)
+{
+	std::vector<std::unique_ptr<Scaler<Pixel>>> scalers;
+	while (scalers.size() < numBands) scalers.push_back(info.create(ops));
+	return std::make_unique<SlicedScaler<Pixel>>(std::move(scalers));
+}
+
+template<typename Pixel>
+static void test()
+{
+	auto format = getPixelFormat<Pixel>();
+	PixelOperations<Pixel> ops(format);
+	for (unsigned srcHeight : {240u, 480u}) {
+		auto frame = createFrame<Pixel>(format, srcHeight);
+		for (const auto& info : getScalers<Pixel>(false)) {
+			INFO(info.name << ' ' << info.factor << "x, " << srcHeight << " lines");
+			unsigned dstHeight = 240 * info.factor;
+			unsigned g = std::gcd(srcHeight, dstHeight);
+			unsigned srcStep = srcHeight / g;
+			unsigned dstStep = dstHeight / g;
+			auto single = info.create(ops);
+			auto sliced = createSliced(info, ops, 5);
+			// the whole frame and a part of it
+			for (auto [srcStartY, srcEndY] : {std::pair{0u, srcHeight},
+			                                  std::pair{24u, srcHeight - 38u}}) {
+				unsigned dstStartY = srcStartY / srcStep * dstStep;
+				unsigned dstEndY   = srcEndY   / srcStep * dstStep;
+				MemoryScalerOutput<Pixel> expected(320 * info.factor, dstHeight);
+				MemoryScalerOutput<Pixel> actual  (320 * info.factor, dstHeight);
+				single->scaleImage(*frame, nullptr, srcStartY, srcEndY, 320,
+				                   expected, dstStartY, dstEndY);
+				sliced->scaleImage(*frame, nullptr, srcStartY, srcEndY, 320,
+				                   actual, dstStartY, dstEndY);
+				CHECK(expected.pixels == actual.pixels);
+			}
+		}
+	}
+}
+
+TEST_CASE("SlicedScaler")
+{
+#if HAVE_16BPP
+	SECTION("16bpp") { test<uint16_t>(); }
+#endif
+#if HAVE_32BPP
+	SECTION("32bpp") { test<uint32_t>(); }
+#endif
+}
+
+// Run with:  unittest "[benchmark]"
+// Scales one (non-interlaced, 320 pixels wide) frame with each scaler, on one
+// thread and split in bands on all threads.
+#if HAVE_32BPP
+TEST_CASE("SlicedScaler: benchmark", "[.][benchmark]")
+{
+	using Pixel = uint32_t;
+	auto format = getPixelFormat<Pixel>();
+	PixelOperations<Pixel> ops(format);
+	auto frame = createFrame<Pixel>(format, 240);
+	unsigned numBands = std::thread::hardware_concurrency();
+
+	for (const auto& info : getScalers<Pixel>(true)) {
+		auto name = std::string(info.name) + ' ' + std::to_string(info.factor) + 'x';
+		MemoryScalerOutput<Pixel> output(320 * info.factor, 240 * info.factor);
+		auto single = info.create(ops);
+		BENCHMARK(name + ", 1 thread") {
+			single->scaleImage(*frame, nullptr, 0, 240, 320,
+			                   output, 0, 240 * info.factor);
+			return output.pixels[0];
+		};
+		// MLAA needs the whole frame, it is never sliced
+		if ((single->getVerticalRadius() != unsigned(-1)) && (numBands > 1)) {
+			auto sliced = createSliced(info, ops, numBands);
+			BENCHMARK(name + ", " + std::to_string(numBands) + " bands") {
+				sliced->scaleImage(*frame, nullptr, 0, 240, 320,
+				                   output, 0, 240 * info.factor);
+				return output.pixels[0];
+			};
+		}
+	}
+}
+#endif
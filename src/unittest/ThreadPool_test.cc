@@ -0,0 +1,69 @@
+#include "catch.hpp"
+#include "ThreadPool.hh"
+#include "MSXException.hh"
+#include "xrange.hh"
+#include <atomic>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("ThreadPool: submit")
+{
+	ThreadPool pool(3);
+	CHECK(pool.getNumThreads() == 3);
+
+	std::vector<std::future<int>> results;
+	for (auto i : xrange(100)) {
+		results.push_back(pool.submit([i] { return i * i; }));
+	}
+	for (auto i : xrange(100)) {
+		CHECK(results[i].get() == i * i);
+	}
+
+	// exceptions are transported via the future
+	auto f = pool.submit([] { throw MSXException("oops"); });
+	CHECK_THROWS_AS(f.get(), MSXException);
+}
+
+TEST_CASE("ThreadPool: priorities")
+{
+	// With a single worker that is kept busy, queued jobs must start in
+	// priority order.
+	ThreadPool pool(1);
+	std::promise<void> gate;
+	auto blocker = pool.submit([g = gate.get_future().share()] { g.wait(); });
+
+	std::vector<int> order;
+	auto low  = pool.submit([&] { order.push_back(2); }, ThreadPool::Priority::LOW);
+	auto norm = pool.submit([&] { order.push_back(1); }, ThreadPool::Priority::NORMAL);
+	auto high = pool.submit([&] { order.push_back(0); }, ThreadPool::Priority::HIGH);
+	gate.set_value();
+	blocker.get(); low.get(); norm.get(); high.get();
+	CHECK(order == std::vector<int>{0, 1, 2});
+}
+
+TEST_CASE("ThreadPool: nested submit")
+{
+	// jobs can submit (and wait for) other jobs via parallelFor
+	ThreadPool pool(2);
+	std::atomic<int> sum = 0;
+	auto f = pool.submit([&] {
+		pool.parallelFor(10, [&](unsigned i) {
+			pool.parallelFor(10, [&](unsigned j) { sum += i * 10 + j; });
+		});
+	});
+	f.get();
+	CHECK(sum == 99 * 100 / 2);
+}
+
+TEST_CASE("ThreadPool: parallelFor")
+{
+	ThreadPool pool(4);
+	for (unsigned n : {0u, 1u, 2u, 7u, 1000u}) {
+		std::vector<int> v(n, 0);
+		pool.parallelFor(n, [&](unsigned i) { v[i] += int(i) + 1; });
+		for (auto i : xrange(n)) {
+			CHECK(v[i] == int(i) + 1);
+		}
+	}
+}
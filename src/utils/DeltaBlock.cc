@@ -1,6 +1,9 @@
 #include "DeltaBlock.hh"
+#include "ThreadPool.hh"
+#include "Math.hh"
 #include "likely.hh"
 #include "ranges.hh"
+#include "span.hh"
 #include "lz4.hh"
 #include <cassert>
 #include <cstring>
@@ -9,7 +12,9 @@
 #if STATISTICS
 #include <iostream>
 #endif
-#ifdef __SSE2__
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #endif
 
@@ -44,7 +49,116 @@ static void storeUleb(vector<uint8_t>& result, size_t value)
 }
 
 
-// --- Helper functions to compare {4,8,16} bytes at aligned memory locations ---
+#if defined(__AVX2__) || defined(__SSE2__)
+
+// --- SIMD helper to compare {16,32} bytes at (unaligned) memory locations ---
+
+// Returns a mask with a 1-bit for each pair of corresponding bytes that are
+// equal (bit 0 for the byte at 'p[0]'). When all bytes are equal the result
+// is 'ALL_EQUAL'.
+//
+// Selection between AVX2 and SSE2 happens at compile time (like everywhere
+// else in openMSX). All x86_64 CPUs have SSE2, AVX2 is used when the compiler
+// is allowed to use it (e.g. the 'super-opt' flavour with -march=native).
+#ifdef __AVX2__
+static constexpr ptrdiff_t SIMD_SIZE = sizeof(__m256i);
+static constexpr unsigned ALL_EQUAL = 0xffffffff;
+[[nodiscard]] static inline unsigned equalMask(const uint8_t* p, const uint8_t* q)
+{
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+	return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+}
+// Are the 4 * SIMD_SIZE bytes at 'p' and 'q' all equal?
+[[nodiscard]] static inline bool allEqual4(const uint8_t* p, const uint8_t* q)
+{
+	auto x = [&](int i) {
+		return _mm256_xor_si256(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p) + i),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(q) + i));
+	};
+	__m256i d = _mm256_or_si256(_mm256_or_si256(x(0), x(1)),
+	                            _mm256_or_si256(x(2), x(3)));
+	return _mm256_testz_si256(d, d);
+}
+#else
+static constexpr ptrdiff_t SIMD_SIZE = sizeof(__m128i);
+static constexpr unsigned ALL_EQUAL = 0xffff;
+[[nodiscard]] static inline unsigned equalMask(const uint8_t* p, const uint8_t* q)
+{
+	__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+	return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+}
+[[nodiscard]] static inline bool allEqual4(const uint8_t* p, const uint8_t* q)
+{
+	auto x = [&](int i) {
+		return _mm_xor_si128(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(q) + i));
+	};
+	__m128i d = _mm_or_si128(_mm_or_si128(x(0), x(1)),
+	                         _mm_or_si128(x(2), x(3)));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(d, _mm_setzero_si128())) == 0xffff;
+}
+#endif
+
+
+// --- Optimized mismatch function ---
+
+// This is much like the function std::mismatch(). You pass in two buffers,
+// the corresponding elements of both buffers are compared and the first
+// position where the elements no longer match is returned.
+//
+// Compared to std::mismatch() this implementation is faster because we compare
+// {16,32} bytes at-a-time, and in the (very common) case of long equal runs
+// even 4 such blocks per iteration. The exact position of the mismatch within
+// a block is found directly from the comparison mask.
+static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+	assert((p_end - p) == (q_end - q)); (void)q_end;
+
+	while ((p_end - p) >= (4 * SIMD_SIZE)) {
+		if (!allEqual4(p, q)) break; // locate the mismatch below
+		p += 4 * SIMD_SIZE; q += 4 * SIMD_SIZE;
+	}
+	while ((p_end - p) >= SIMD_SIZE) {
+		if (auto m = equalMask(p, q); m != ALL_EQUAL) {
+			auto i = Math::findFirstSet(~m) - 1;
+			return {p + i, q + i};
+		}
+		p += SIMD_SIZE; q += SIMD_SIZE;
+	}
+	return std::mismatch(p, p_end, q);
+}
+
+
+// --- Optimized scan_match function ---
+
+// Like scan_mismatch() above, but searches two buffers for the first
+// corresponding equal (instead of not-equal) bytes.
+//
+// Differing runs are typically short, so no unrolling here.
+static std::pair<const uint8_t*, const uint8_t*> scan_match(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+	assert((p_end - p) == (q_end - q)); (void)q_end;
+
+	while ((p_end - p) >= SIMD_SIZE) {
+		if (auto m = equalMask(p, q); m != 0) {
+			auto i = Math::findFirstSet(m) - 1;
+			return {p + i, q + i};
+		}
+		p += SIMD_SIZE; q += SIMD_SIZE;
+	}
+	while ((p != p_end) && (*p != *q)) { ++p; ++q; }
+	return {p, q};
+}
+
+#else // no SIMD
+
+// --- Helper functions to compare {4,8} bytes at aligned memory locations ---
 
 template<int N> bool comp(const uint8_t* p, const uint8_t* q);
 
@@ -60,19 +174,6 @@ template<> bool comp<8>(const uint8_t* p, const uint8_t* q)
 	       *reinterpret_cast<const uint64_t*>(q);
 }
 
-#ifdef __SSE2__
-template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
-{
-	// Tests show that (on my machine) using 1 128-bit load is faster than
-	// 2 64-bit loads. Even though the actual comparison is slightly more
-	// complicated with SSE instructions.
-	__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
-	__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(q));
-	__m128i d = _mm_cmpeq_epi8(a, b);
-	return _mm_movemask_epi8(d) == 0xffff;
-}
-#endif
-
 
 // --- Optimized mismatch function ---
 
@@ -89,16 +190,7 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 {
 	assert((p_end - p) == (q_end - q));
 
-	// When SSE is available, work with 16-byte words, otherwise 4 or 8
-	// bytes. This routine also benefits from AVX2 instructions. Though not
-	// all x86_64 CPUs have AVX2 (all have SSE2), so using them requires
-	// extra run-time checks and that's not worth it at this point.
-	constexpr int WORD_SIZE =
-#ifdef __SSE2__
-		sizeof(__m128i);
-#else
-		sizeof(void*);
-#endif
+	constexpr int WORD_SIZE = sizeof(void*);
 
 	// Region too small or
 	// both buffers are differently aligned.
@@ -173,6 +265,8 @@ end:	return std::mismatch(p, p_end, q);
 	return {p, q};
 }
 
+#endif // SIMD
+
 
 // --- delta (de)compression routines ---
 
@@ -182,40 +276,56 @@ end:	return std::mismatch(p, p_end, q);
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
+// Only the bytes within the given (sorted, non-overlapping, non-adjacent)
+// ranges are compared. The bytes outside these ranges are known to be equal
+// (see DirtyPages), those bytes of 'newBuf' are not even accessed.
+// The (non-SIMD) scan routines temporarily place sentinels in the 'newBuf'
+// buffer. So 'newBuf' must be writable and private to the caller, while
+// 'oldBuf' is only read (it may concurrently be read by other threads).
 [[nodiscard]] static vector<uint8_t> calcDelta(
-	const uint8_t* oldBuf, const uint8_t* newBuf, size_t size)
+	const uint8_t* oldBuf, uint8_t* newBuf, size_t size,
+	span<const std::pair<size_t, size_t>> ranges)
 {
 	vector<uint8_t> result;
+	size_t equal = 0; // length of the current run of equal bytes
+	size_t pos = 0;
 
-	const auto* p = oldBuf;
-	const auto* q = newBuf;
-	const auto* p_end = p + size;
-	const auto* q_end = q + size;
+	for (auto [begin, end] : ranges) {
+		assert(pos <= begin); assert(begin < end); assert(end <= size);
+		equal += begin - pos;
 
-	// scan equal bytes (possibly zero)
-	const auto* q1 = q;
-	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-	auto n1 = q - q1;
-	storeUleb(result, n1);
+		const auto* p = static_cast<const uint8_t*>(newBuf) + begin;
+		const auto* q = oldBuf + begin;
+		const auto* p_end = static_cast<const uint8_t*>(newBuf) + end;
+		const auto* q_end = oldBuf + end;
 
-	while (q != q_end) {
-		assert(*p != *q);
+		// scan equal bytes (possibly zero)
+		const auto* p1 = p;
+		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+		equal += p - p1;
 
-		const auto* q2 = q;
-	different:
-		std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
-		auto n2 = q - q2;
+		while (p != p_end) {
+			assert(*p != *q);
 
-		const auto* q3 = q;
-		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-		auto n3 = q - q3;
-		if ((q != q_end) && (n3 <= 2)) goto different;
+			const auto* p2 = p;
+		different:
+			std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
+			auto n2 = p - p2;
 
-		storeUleb(result, n2);
-		result.insert(result.end(), q2, q3);
+			const auto* p3 = p;
+			std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+			auto n3 = p - p3;
+			if ((p != p_end) && (n3 <= 2)) goto different;
 
-		if (n3 != 0) storeUleb(result, n3);
+			storeUleb(result, equal);
+			storeUleb(result, n2);
+			result.insert(result.end(), p2, p3);
+			equal = n3;
+		}
+		pos = end;
 	}
+	equal += size - pos;
+	if (result.empty() || (equal != 0)) storeUleb(result, equal);
 
 	result.shrink_to_fit();
 	return result;
@@ -255,6 +365,7 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 	: block(size)
+	, uncompressedSize(size)
 	, compressedSize(0)
 {
 #ifdef DEBUG
@@ -270,22 +381,68 @@ DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 #endif
 }
 
+DeltaBlockCopy::~DeltaBlockCopy()
+{
+	// the background job still references this object
+	if (compressJob.valid()) compressJob.wait();
+}
+
 void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 {
-	if (compressed()) {
-		LZ4::decompress(block.data(), dst, int(compressedSize), int(size));
-	} else {
-		memcpy(dst, block.data(), size);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const uint8_t* src = spillFile ? spillFile->read(spillLoc).data()
+		                               : block.data();
+		if (compressed()) {
+			LZ4::decompress(src, dst, int(compressedSize), int(size));
+		} else {
+			memcpy(dst, src, size);
+		}
 	}
 #ifdef DEBUG
 	assert(SHA1::calc({dst, size}) == sha1);
 #endif
 }
 
+size_t DeltaBlockCopy::getMemorySize() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (spillFile) return 0;
+	return compressed() ? compressedSize : uncompressedSize;
+}
+
+void DeltaBlockCopy::spill(const std::shared_ptr<SpillFile>& file)
+{
+	if (spillFile) return; // already done
+	// Only blocks for which compression was requested are no longer used
+	// as reference for new diffs (see LastDeltaBlocks::createNew()). Wait
+	// till the compression has finished (or was found not beneficial).
+	if (!compressJob.valid() ||
+	    (compressJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+		return;
+	}
+	size_t size = compressed() ? compressedSize : uncompressedSize;
+	auto loc = file->append({block.data(), size});
+
+	std::lock_guard<std::mutex> lock(mutex);
+	spillFile = file;
+	spillLoc = loc;
+	MemBuffer<uint8_t>().swap(block);
+}
+
 void DeltaBlockCopy::compress(size_t size)
 {
-	if (compressed()) return;
+	if (compressJob.valid()) return; // already (being) compressed
+
+	compressJob = ThreadPool::instance().submit(
+		[this, size] { doCompress(size); }, ThreadPool::Priority::LOW);
+}
 
+void DeltaBlockCopy::doCompress(size_t size)
+{
+	// Runs on a worker thread. Nobody modifies 'block' until the swap
+	// below, so it's safe to read it without holding the lock.
+	assert(!compressed());
 	size_t dstLen = LZ4::compressBound(int(size));
 	MemBuffer<uint8_t> buf2(dstLen);
 	dstLen = LZ4::compress(block.data(), buf2.data(), int(size));
@@ -294,9 +451,12 @@ void DeltaBlockCopy::compress(size_t size)
 		// compression isn't beneficial
 		return;
 	}
-	compressedSize = dstLen;
-	block.swap(buf2);
-	block.resize(compressedSize); // shrink to fit
+	buf2.resize(dstLen); // shrink to fit
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		block.swap(buf2);
+		compressedSize = dstLen;
+	}
 	assert(compressed());
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
@@ -315,6 +475,7 @@ void DeltaBlockCopy::compress(size_t size)
 const uint8_t* DeltaBlockCopy::getData()
 {
 	assert(!compressed());
+	assert(!spillFile);
 	return block.data();
 }
 
@@ -323,44 +484,114 @@ const uint8_t* DeltaBlockCopy::getData()
 
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
-		const uint8_t* data, size_t size)
+		const uint8_t* data, size_t size, const DirtyPages* changed)
 	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data, size))
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc({data, size});
+#endif
+	vector<std::pair<size_t, size_t>> ranges;
+	if (changed) {
+		changed->forEachRange(size, [&](size_t begin, size_t end) {
+			ranges.emplace_back(begin, end);
+		});
+	} else {
+		ranges.emplace_back(0, size);
+	}
 
-	MemBuffer<uint8_t> buf(size);
-	apply(buf.data(), size);
-	assert(memcmp(buf.data(), data, size) == 0);
+	// Copying is the only thing that must happen synchronously: 'data'
+	// is the live (emulated) memory, it changes as soon as we return.
+	// Bytes outside 'ranges' are left uninitialized (and are not used).
+	MemBuffer<uint8_t> copy(size);
+	size_t copied = 0;
+	for (auto [begin, end] : ranges) {
+		memcpy(&copy[begin], &data[begin], end - begin);
+		copied += end - begin;
+	}
+	memorySize = copied;
+	deltaJob = ThreadPool::instance().submit(
+		[this, copy = std::move(copy), ranges = std::move(ranges), size]() mutable {
+			// 'prev' is not modified (e.g. compressed) while we're
+			// running, see LastDeltaBlocks::Info::finishPendingDiff().
+			delta = calcDelta(prev->getData(), copy.data(), size, ranges);
+			memorySize = delta.size();
+#ifdef DEBUG
+			MemBuffer<uint8_t> buf(size);
+			prev->apply(buf.data(), size);
+			applyDeltaInPlace(buf.data(), size, delta.data());
+			for (auto [begin, end] : ranges) {
+				assert(memcmp(&buf[begin], &copy[begin], end - begin) == 0);
+			}
 #endif
 #if STATISTICS
-	allocSize = delta.size();
-	globalAllocSize += allocSize;
-	std::cout << "stat: DeltaBlockDiff " << globalAllocSize
-	          << " (+" << allocSize << ")\n";
+			allocSize = delta.size();
+			globalAllocSize += allocSize;
+			std::cout << "stat: DeltaBlockDiff " << globalAllocSize
+			          << " (+" << allocSize << ")\n";
 #endif
+		});
+}
+
+DeltaBlockDiff::~DeltaBlockDiff()
+{
+	// the background job still references this object
+	deltaJob.wait();
 }
 
 void DeltaBlockDiff::apply(uint8_t* dst, size_t size) const
 {
+	deltaJob.wait();
 	prev->apply(dst, size);
-	applyDeltaInPlace(dst, size, delta.data());
+	applyDeltaInPlace(dst, size, spillFile ? spillFile->read(spillLoc).data()
+	                                       : delta.data());
 #ifdef DEBUG
 	assert(SHA1::calc({dst, size}) == sha1);
 #endif
 }
 
+size_t DeltaBlockDiff::getMemorySize() const
+{
+	return memorySize;
+}
+
+void DeltaBlockDiff::spill(const std::shared_ptr<SpillFile>& file)
+{
+	if (!spillFile && isReady()) {
+		auto loc = file->append(delta);
+		spillFile = file;
+		spillLoc = loc;
+		vector<uint8_t>().swap(delta);
+		memorySize = 0;
+	}
+	// The chunk that contained the reference block may already be gone.
+	prev->spill(file);
+}
+
+bool DeltaBlockDiff::isReady() const
+{
+	return deltaJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
-	return delta.size();
+	deltaJob.wait();
+	return spillFile ? spillLoc.size : delta.size();
 }
 
 
 // class LastDeltaBlocks
 
+void LastDeltaBlocks::Info::finishPendingDiff()
+{
+	if (auto diff = pendingDiff.lock()) {
+		accSize += diff->getDeltaSize();
+	}
+	pendingDiff.reset();
+}
+
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
-		const void* id, const uint8_t* data, size_t size)
+		const void* id, const uint8_t* data, size_t size,
+		const DirtyPages* dirty)
 {
 	auto it = ranges::lower_bound(infos, std::tuple(id, size), {},
 		[](const Info& info) { return std::tuple(info.id, info.size); });
@@ -371,6 +602,20 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 	assert(it->id   == id);
 	assert(it->size == size);
 
+	// Normally the previous diff finished long ago (it was started one
+	// snapshot period earlier).
+	it->finishPendingDiff();
+
+	if (dirty && !dirty->any()) {
+		// Nothing was written since the previous snapshot.
+		if (auto last = it->last.lock()) {
+#ifdef DEBUG
+			assert(SHA1::calc({data, size}) == last->sha1);
+#endif
+			return last;
+		}
+	}
+
 	auto ref = it->ref.lock();
 	if (it->accSize >= size || !ref) {
 		if (ref) {
@@ -384,13 +629,22 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->changed = dirty ? *dirty : DirtyPages();
+		it->changed.clear();
 		return b;
 	} else {
 		// Create diff based on earlier reference block.
 		// Reference remains unchanged.
-		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size);
+		const DirtyPages* changed = nullptr;
+		if (dirty && it->changed.isTracking()) {
+			it->changed.merge(*dirty);
+			changed = &it->changed;
+		} else {
+			it->changed = DirtyPages(); // unknown from now on
+		}
+		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size, changed);
 		it->last = b;
-		it->accSize += b->getDeltaSize();
+		it->pendingDiff = b; // size is added to 'accSize' later
 		return b;
 	}
 }
@@ -411,6 +665,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->changed = DirtyPages();
 		return b;
 	} else {
 #ifdef DEBUG
@@ -422,7 +677,8 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 
 void LastDeltaBlocks::clear()
 {
-	for (const Info& info : infos) {
+	for (Info& info : infos) {
+		info.finishPendingDiff();
 		if (auto ref = info.ref.lock()) {
 			ref->compress(info.size);
 		}
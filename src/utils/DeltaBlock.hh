@@ -3,9 +3,14 @@
 
 #define STATISTICS 0
 
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
+#include "SpillFile.hh"
+#include <atomic>
 #include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -23,6 +28,25 @@ public:
 #endif
 	virtual void apply(uint8_t* dst, size_t size) const = 0;
 
+	/** The size of the (uncompressed) data in this block. */
+	[[nodiscard]] virtual size_t getSize() const = 0;
+
+	/** Has the (background) work to create this block finished? A block
+	  * that is not yet ready can be used, but apply() may then block. */
+	[[nodiscard]] virtual bool isReady() const { return true; }
+
+	/** (Approximate) number of bytes of memory used by this block. For a
+	  * block that is not yet ready this is an estimate. */
+	[[nodiscard]] virtual size_t getMemorySize() const = 0;
+
+	/** Move the data of this block to the given file, so that it no
+	  * longer occupies RAM (see SpillFile). This only happens for blocks
+	  * that are no longer needed to create new blocks, for other blocks
+	  * (and for blocks that were already moved) this does nothing.
+	  * @throws FileException
+	  */
+	virtual void spill(const std::shared_ptr<SpillFile>& file) = 0;
+
 protected:
 	DeltaBlock() = default;
 
@@ -43,37 +67,77 @@ class DeltaBlockCopy final : public DeltaBlock
 {
 public:
 	DeltaBlockCopy(const uint8_t* data, size_t size);
+	~DeltaBlockCopy() override;
 	void apply(uint8_t* dst, size_t size) const override;
+	[[nodiscard]] size_t getSize() const override { return uncompressedSize; }
+	[[nodiscard]] size_t getMemorySize() const override;
+	void spill(const std::shared_ptr<SpillFile>& file) override;
+
+	/** (Try to) compress this block. The actual compression runs
+	  * asynchronously on the ThreadPool, until it's finished this block
+	  * remains usable in uncompressed form. */
 	void compress(size_t size);
 	[[nodiscard]] const uint8_t* getData();
 
 private:
+	void doCompress(size_t size);
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
 	MemBuffer<uint8_t> block;
+	const size_t uncompressedSize;
 	size_t compressedSize;
+
+	// Protects 'block' and 'compressedSize' against the concurrent swap
+	// at the end of the (background) compression.
+	mutable std::mutex mutex;
+	std::future<void> compressJob;
+
+	// When set, 'block' is empty and the data is stored in this file.
+	std::shared_ptr<SpillFile> spillFile;
+	SpillFile::Location spillLoc;
 };
 
 
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
+	/** Only the given data is copied, calculating the actual delta
+	  * happens asynchronously on the ThreadPool. When 'changed' is given,
+	  * only the dirty pages are copied and compared, all other pages must
+	  * be equal to the content of 'prev_'. */
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
-	               const uint8_t* data, size_t size);
+	               const uint8_t* data, size_t size,
+	               const DirtyPages* changed = nullptr);
+	~DeltaBlockDiff() override;
 	void apply(uint8_t* dst, size_t size) const override;
+	[[nodiscard]] size_t getSize() const override { return prev->getSize(); }
+	[[nodiscard]] bool isReady() const override;
+	[[nodiscard]] size_t getMemorySize() const override;
+	void spill(const std::shared_ptr<SpillFile>& file) override;
 	[[nodiscard]] size_t getDeltaSize() const;
+	[[nodiscard]] const DeltaBlockCopy& getReference() const { return *prev; }
 
 private:
 	const std::shared_ptr<DeltaBlockCopy> prev;
-	const std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	                            // only valid once 'deltaJob' has finished
+	std::atomic<size_t> memorySize; // copied data, later the delta
+	std::future<void> deltaJob;
+
+	// When set, 'delta' is empty and is stored in this file instead.
+	std::shared_ptr<SpillFile> spillFile;
+	SpillFile::Location spillLoc;
 };
 
 
 class LastDeltaBlocks
 {
 public:
+	/** Optionally 'dirty' indicates which pages were written since the
+	  * previous (reverse) snapshot, see DirtyPages. */
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
-		const void* id, const uint8_t* data, size_t size);
+		const void* id, const uint8_t* data, size_t size,
+		const DirtyPages* dirty = nullptr);
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNullDiff(
 		const void* id, const uint8_t* data, size_t size);
 	void clear();
@@ -83,10 +147,17 @@ private:
 		Info(const void* id_, size_t size_)
 			: id(id_), size(size_), accSize(0) {}
 
+		// Wait for the last created diff block and add its size to
+		// 'accSize'. After this no background job uses 'ref' anymore.
+		void finishPendingDiff();
+
 		const void* id;
 		size_t size;
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
+		std::weak_ptr<DeltaBlockDiff> pendingDiff;
+		DirtyPages changed; // pages changed since 'ref' was created,
+		                    // not tracking means unknown
 		size_t accSize;
 	};
 
@@ -0,0 +1,88 @@
+#ifndef DIRTYPAGES_HH
+#define DIRTYPAGES_HH
+
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of which pages of a block of memory were written to.
+  *
+  * This is used to speed up reverse snapshots: pages that weren't written
+  * since the previous snapshot don't need to be compared against the
+  * reference copy (see DeltaBlock.hh). The page size matches the size of a
+  * CPU cache line, so that handing out a write cache line can be tracked by
+  * marking a single page.
+  *
+  * A default constructed object does not track anything, then all pages
+  * must be considered dirty.
+  */
+class DirtyPages
+{
+public:
+	static constexpr unsigned PAGE_BITS = 8;
+	static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+	DirtyPages() = default;
+
+	/** Track a block of the given size. Initially all pages are dirty. */
+	explicit DirtyPages(size_t size)
+		: pages((size + PAGE_SIZE - 1) >> PAGE_BITS, true) {}
+
+	[[nodiscard]] bool isTracking() const { return !pages.empty(); }
+
+	void mark(size_t addr) {
+		if (isTracking()) pages[addr >> PAGE_BITS] = true;
+	}
+	void mark(size_t addr, size_t num) {
+		if (!isTracking() || (num == 0)) return;
+		for (auto p : xrange(addr >> PAGE_BITS, ((addr + num - 1) >> PAGE_BITS) + 1)) {
+			pages[p] = true;
+		}
+	}
+	void markAll() {
+		pages.assign(pages.size(), true);
+	}
+	void clear() {
+		pages.assign(pages.size(), false);
+	}
+
+	/** Is there at least one dirty page? */
+	[[nodiscard]] bool any() const {
+		return std::find(pages.begin(), pages.end(), true) != pages.end();
+	}
+
+	/** Also mark all pages that are dirty in 'other'. */
+	void merge(const DirtyPages& other) {
+		assert(pages.size() == other.pages.size());
+		for (auto i : xrange(pages.size())) {
+			if (other.pages[i]) pages[i] = true;
+		}
+	}
+
+	/** Calls 'f(begin, end)' for each (maximal) range of consecutive dirty
+	  * pages, clipped to the first 'size' bytes. Must be tracking.
+	  */
+	template<typename F>
+	void forEachRange(size_t size, F f) const {
+		assert(isTracking());
+		auto num = std::min(pages.size(), (size + PAGE_SIZE - 1) >> PAGE_BITS);
+		size_t p = 0;
+		while (p < num) {
+			if (!pages[p]) { ++p; continue; }
+			auto first = p;
+			do { ++p; } while ((p < num) && pages[p]);
+			f(first << PAGE_BITS, std::min(p << PAGE_BITS, size));
+		}
+	}
+
+private:
+	std::vector<bool> pages;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef SPSCRINGBUFFER_HH
+#define SPSCRINGBUFFER_HH
+
+#include "MemBuffer.hh"
+#include "Math.hh"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace openmsx {
+
+/** A lock-free ring buffer for one producer thread and one consumer thread.
+  *
+  * The producer only calls push() and free(), the consumer only calls pop()
+  * and size(). Both threads run without ever blocking each other: each side
+  * only writes its own index, and publishes it (with release semantics)
+  * after it has copied the elements. size() and free() can also be called
+  * from other threads, then the result is only a (consistent) snapshot.
+  *
+  * The capacity is rounded up to a power of two. The indices are free-running
+  * counters, so (unlike CircularBuffer) the buffer can be completely filled.
+  *
+  * clear() and resize() may only be called while neither the producer nor
+  * the consumer is active (e.g. while the audio device is paused).
+  */
+template<typename T>
+class SPSCRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+	SPSCRingBuffer() = default;
+	explicit SPSCRingBuffer(size_t capacity) { resize(capacity); }
+
+	/** Change the capacity, this also empties the buffer. Same
+	  * restrictions as for clear().
+	  */
+	void resize(size_t capacity) {
+		cap = Math::ceil2(capacity);
+		buffer.resize(cap);
+		clear();
+	}
+
+	[[nodiscard]] size_t capacity() const { return cap; }
+
+	/** Number of elements that can be popped. */
+	[[nodiscard]] size_t size() const {
+		auto r = readIdx .load(std::memory_order_acquire);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		return w - r;
+	}
+
+	/** Number of elements that can be pushed. */
+	[[nodiscard]] size_t free() const {
+		return capacity() - size();
+	}
+
+	/** Append (at most) 'num' elements, returns the number of elements
+	  * that were actually appended. Only call from the producer thread.
+	  */
+	size_t push(const T* data, size_t num) {
+		auto w = writeIdx.load(std::memory_order_relaxed);
+		auto r = readIdx .load(std::memory_order_acquire);
+		num = std::min(num, cap - (w - r));
+		size_t pos = w & (cap - 1);
+		size_t len1 = std::min(num, cap - pos);
+		std::copy_n(data, len1, buffer.data() + pos);
+		std::copy_n(data + len1, num - len1, buffer.data());
+		writeIdx.store(w + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Remove (at most) 'num' elements from the front, returns the number
+	  * of elements that were actually removed. Only call from the consumer
+	  * thread.
+	  */
+	size_t pop(T* data, size_t num) {
+		auto r = readIdx .load(std::memory_order_relaxed);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		num = std::min(num, w - r);
+		size_t pos = r & (cap - 1);
+		size_t len1 = std::min(num, cap - pos);
+		std::copy_n(buffer.data() + pos, len1, data);
+		std::copy_n(buffer.data(), num - len1, data + len1);
+		readIdx.store(r + num, std::memory_order_release);
+		return num;
+	}
+
+	void clear() {
+		readIdx .store(0, std::memory_order_relaxed);
+		writeIdx.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	size_t cap = 0;
+	MemBuffer<T> buffer;
+	// On separate cache lines, to avoid false sharing between the threads.
+	alignas(64) std::atomic<size_t> readIdx = 0;
+	alignas(64) std::atomic<size_t> writeIdx = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -3,6 +3,7 @@
 #include "AviWriter.hh"
 #include "FileOperations.hh"
 #include "MSXException.hh"
+#include "ThreadPool.hh"
 #include "build-info.hh"
 #include "Version.hh"
 #include "cstdiop.hh" // for snprintf
@@ -38,6 +39,12 @@ AviWriter::AviWriter(const Filename& filename, unsigned width_,
 
 AviWriter::~AviWriter()
 {
+	try {
+		finishPendingFrame();
+	} catch (MSXException&) {
+		// can't throw from destructor
+	}
+
 	if (written == 0) {
 		// no data written yet (a recording less than one video frame)
 		std::string filename = file.getURL();
@@ -266,24 +273,48 @@ void AviWriter::addAviChunk(const char* tag, size_t size_, const void* data, uns
 	index[idxSize + 3] = size;
 }
 
+void AviWriter::finishPendingFrame()
+{
+	if (pendingFrame.valid()) {
+		pendingFrame.get(); // rethrows errors from writeFrame()
+	}
+}
+
 void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
+{
+	// Wait for the previous frame, the codec (and the file) can only
+	// handle one frame at a time. Normally that frame is finished long
+	// before the next one arrives.
+	finishPendingFrame();
+
+	// Only copying the frame must happen on this thread, the FrameSource
+	// is reused after this call returns.
+	codec.grabFrame(frame);
+	pendingFrame = ThreadPool::instance().submit(
+		[this, audio = std::vector<int16_t>(sampleData, sampleData + samples)] {
+			writeFrame(audio);
+		});
+}
+
+void AviWriter::writeFrame(const std::vector<int16_t>& samples)
 {
 	bool keyFrame = (frames++ % 300 == 0);
-	auto buffer = codec.compressFrame(keyFrame, frame);
+	auto buffer = codec.compressFrame(keyFrame);
 	addAviChunk("00dc", buffer.size(), buffer.data(), keyFrame ? 0x10 : 0x0);
 
-	if (samples) {
-		assert((samples % channels) == 0);
+	if (!samples.empty()) {
+		assert((samples.size() % channels) == 0);
 		assert(audiorate != 0);
+		auto num = unsigned(samples.size());
 		if constexpr (OPENMSX_BIGENDIAN) {
 			// See comment in WavWriter::write()
-			//VLA(Endian::L16, buf, samples); // doesn't work in clang
-			std::vector<Endian::L16> buf(sampleData, sampleData + samples);
-			addAviChunk("01wb", samples * sizeof(int16_t), buf.data(), 0);
+			//VLA(Endian::L16, buf, num); // doesn't work in clang
+			std::vector<Endian::L16> buf(begin(samples), end(samples));
+			addAviChunk("01wb", num * sizeof(int16_t), buf.data(), 0);
 		} else {
-			addAviChunk("01wb", samples * sizeof(int16_t), sampleData, 0);
+			addAviChunk("01wb", num * sizeof(int16_t), samples.data(), 0);
 		}
-		audiowritten += samples;
+		audiowritten += num;
 	}
 }
 
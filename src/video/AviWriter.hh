@@ -7,6 +7,7 @@
 #include "File.hh"
 #include "endian.hh"
 #include <cstdint>
+#include <future>
 #include <vector>
 
 namespace openmsx {
@@ -24,9 +25,15 @@ public:
 	void setFps(float fps_) { fps = fps_; }
 
 private:
+	void writeFrame(const std::vector<int16_t>& samples);
+	void finishPendingFrame();
 	void addAviChunk(const char* tag, size_t size, const void* data, unsigned flags);
 
 private:
+	// Encoding and writing of a frame happens on the ThreadPool. There's
+	// at most one frame in flight.
+	std::future<void> pendingFrame;
+
 	File file;
 	ZMBVEncoder codec;
 	std::vector<Endian::L32> index;
@@ -8,6 +8,13 @@
 #include <cstdint>
 #include <tuple>
 
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h> // SSSE3
+#endif
+
 namespace openmsx {
 
 template<typename Pixel>
@@ -36,8 +43,65 @@ void BitmapConverter<Pixel>::calcDPalette()
 			dPalette[16 * i + j] = dp;
 		}
 	}
+#ifdef __SSSE3__
+	for (auto b : xrange(sizeof(Pixel))) {
+		for (auto i : xrange(16)) {
+			planes16[b][i] = byte(palette16[i] >> (8 * b));
+			planesG5[b][i] = (i < 8)
+				? byte(palette16[(i & 3) + 16 * (i >> 2)] >> (8 * b))
+				: 0;
+		}
+	}
+#endif
+}
+
+#ifdef __SSSE3__
+// Looks up 16 palette indices (in the range [0..15]) in the given palette
+// planes, and stores the resulting 16 pixels.
+template<typename Pixel>
+static inline void lookup16(
+	Pixel* __restrict out, __m128i idx, const byte (*planes)[16])
+{
+	auto* o = reinterpret_cast<__m128i*>(out);
+	auto plane = [&](int n) {
+		return _mm_shuffle_epi8(
+			_mm_load_si128(reinterpret_cast<const __m128i*>(planes[n])),
+			idx);
+	};
+	if constexpr (sizeof(Pixel) == 4) {
+		__m128i b0 = plane(0);
+		__m128i b1 = plane(1);
+		__m128i b2 = plane(2);
+		__m128i b3 = plane(3);
+		__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+		__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+		__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+		__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi01, hi23));
+		_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi01, hi23));
+	} else {
+		__m128i b0 = plane(0);
+		__m128i b1 = plane(1);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi8(b0, b1));
+	}
 }
 
+// Converts 16 bytes with 2 pixels per byte (high nibble first) to 32 pixels.
+template<typename Pixel>
+static inline void lookupNibbles(
+	Pixel* __restrict out, __m128i data, const byte (*planes)[16])
+{
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(data, 4), mask);
+	__m128i lo = _mm_and_si128(data, mask);
+	lookup16(out +  0, _mm_unpacklo_epi8(hi, lo), planes);
+	lookup16(out + 16, _mm_unpackhi_epi8(hi, lo), planes);
+}
+#endif
+
 template<typename Pixel>
 void BitmapConverter<Pixel>::convertLine(
 	Pixel* linePtr, const byte* vramPtr)
@@ -127,6 +191,15 @@ void BitmapConverter<Pixel>::renderGraphic4(
 		calcDPalette();
 	}
 
+#ifdef __SSSE3__
+	for (auto i : xrange(128 / 16)) {
+		__m128i data = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		lookupNibbles(pixelPtr + 32 * i, data, planes16);
+	}
+	return;
+#endif
+
 	if ((sizeof(Pixel) == 2) && ((uintptr_t(pixelPtr) & 1) == 1)) {
 		// Its 16 bit destination but currently not aligned on a word boundary
 		// First write one pixel to get aligned
@@ -207,6 +280,33 @@ void BitmapConverter<Pixel>::renderGraphic5(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0)
 {
+#ifdef __SSSE3__
+	if (unlikely(!dPaletteValid)) {
+		calcDPalette();
+	}
+	const __m128i mask3 = _mm_set1_epi8(0x03);
+	const __m128i odd   = _mm_set1_epi8(0x04);
+	for (auto i : xrange(128 / 16)) {
+		__m128i data = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		// index of the 4 pixels in each byte, odd pixels use entries 4-7
+		__m128i f0 =               _mm_and_si128(_mm_srli_epi16(data, 6), mask3);
+		__m128i f1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(data, 4), mask3), odd);
+		__m128i f2 =               _mm_and_si128(_mm_srli_epi16(data, 2), mask3);
+		__m128i f3 = _mm_or_si128(_mm_and_si128(data, mask3), odd);
+		__m128i lo01 = _mm_unpacklo_epi8(f0, f1);
+		__m128i hi01 = _mm_unpackhi_epi8(f0, f1);
+		__m128i lo23 = _mm_unpacklo_epi8(f2, f3);
+		__m128i hi23 = _mm_unpackhi_epi8(f2, f3);
+		Pixel* out = pixelPtr + 64 * i;
+		lookup16(out +  0, _mm_unpacklo_epi16(lo01, lo23), planesG5);
+		lookup16(out + 16, _mm_unpackhi_epi16(lo01, lo23), planesG5);
+		lookup16(out + 32, _mm_unpacklo_epi16(hi01, hi23), planesG5);
+		lookup16(out + 48, _mm_unpackhi_epi16(hi01, hi23), planesG5);
+	}
+	return;
+#endif
+
 	for (auto i : xrange(128)) {
 		unsigned data = vramPtr0[i];
 		pixelPtr[4 * i + 0] = palette16[ 0 +  (data >> 6)     ];
@@ -233,6 +333,20 @@ void BitmapConverter<Pixel>::renderGraphic6(
 	if (unlikely(!dPaletteValid)) {
 		calcDPalette();
 	}
+
+#ifdef __SSSE3__
+	for (auto i : xrange(128 / 16)) {
+		__m128i data0 = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		__m128i data1 = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(vramPtr1) + i);
+		// pixel order: data0[0], data1[0], data0[1], data1[1], ...
+		lookupNibbles(pixelPtr + 64 * i +  0, _mm_unpacklo_epi8(data0, data1), planes16);
+		lookupNibbles(pixelPtr + 64 * i + 32, _mm_unpackhi_epi8(data0, data1), planes16);
+	}
+	return;
+#endif
+
 	      auto* out = reinterpret_cast<DPixel*>(pixelPtr);
 	const auto* in0 = reinterpret_cast<const unsigned*>(vramPtr0);
 	const auto* in1 = reinterpret_cast<const unsigned*>(vramPtr1);
@@ -282,12 +396,68 @@ static constexpr std::tuple<int, int, int> yjk2rgb(int y, int j, int k)
 	return {r, g, b};
 }
 
+#ifdef __SSE2__
+// Calculates the palette32768 index (see yjk2rgb()) of 16 YJK pixels (the 4
+// groups starting at vramPtr0[8 * i] and vramPtr1[8 * i]). Optionally also
+// returns the raw VRAM bytes, in pixel order.
+static inline void yjkIndices16(
+	const byte* __restrict vramPtr0, const byte* __restrict vramPtr1,
+	unsigned i, uint16_t* __restrict indices, uint16_t* __restrict raw = nullptr)
+{
+	__m128i v0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vramPtr0 + 8 * i));
+	__m128i v1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vramPtr1 + 8 * i));
+	// pixel order within a group: v0[0], v1[0], v0[1], v1[1]
+	__m128i p8 = _mm_unpacklo_epi8(v0, v1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(31);
+	for (auto h : xrange(2)) {
+		__m128i p = h ? _mm_unpackhi_epi8(p8, zero) : _mm_unpacklo_epi8(p8, zero);
+		// per group: k = a(p0) + b(p1), j = a(p2) + b(p3)
+		__m128i a = _mm_and_si128(p, _mm_set1_epi16(7));
+		__m128i b = _mm_sub_epi16(
+			_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(3)), 3),
+			_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(4)), 3));
+		__m128i kj = _mm_add_epi16(a, _mm_srli_epi32(b, 16));
+		__m128i k = _mm_shufflehi_epi16(_mm_shufflelo_epi16(kj, 0x00), 0x00);
+		__m128i j = _mm_shufflehi_epi16(_mm_shufflelo_epi16(kj, 0xAA), 0xAA);
+		__m128i y = _mm_srli_epi16(p, 3);
+
+		auto clamp = [&](__m128i x) {
+			return _mm_min_epi16(_mm_max_epi16(x, zero), max);
+		};
+		__m128i r = clamp(_mm_add_epi16(y, j));
+		__m128i g = clamp(_mm_add_epi16(y, k));
+		// (5 * y - 2 * j - k) / 4, rounding differs from the scalar
+		// version only for negative values, those are clamped anyway
+		__m128i y5 = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+		__m128i b2 = _mm_sub_epi16(_mm_sub_epi16(y5, _mm_add_epi16(j, j)), k);
+		__m128i bl = clamp(_mm_srai_epi16(b2, 2));
+
+		__m128i col = _mm_or_si128(
+			_mm_or_si128(_mm_slli_epi16(r, 10), _mm_slli_epi16(g, 5)), bl);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(indices + 8 * h), col);
+		if (raw) _mm_storeu_si128(reinterpret_cast<__m128i*>(raw + 8 * h), p);
+	}
+}
+#endif
+
 template<typename Pixel>
 void BitmapConverter<Pixel>::renderYJK(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	for (auto i : xrange(16)) {
+		uint16_t indices[16];
+		yjkIndices16(vramPtr0, vramPtr1, i, indices);
+		for (auto n : xrange(16)) {
+			pixelPtr[16 * i + n] = palette32768[indices[n]];
+		}
+	}
+	return;
+#endif
+
 	for (auto i : xrange(64)) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -313,6 +483,20 @@ void BitmapConverter<Pixel>::renderYAE(
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	for (auto i : xrange(16)) {
+		uint16_t indices[16];
+		uint16_t p[16];
+		yjkIndices16(vramPtr0, vramPtr1, i, indices, p);
+		for (auto n : xrange(16)) {
+			pixelPtr[16 * i + n] = (p[n] & 0x08)
+				? palette16[p[n] >> 4]       // YAE
+				: palette32768[indices[n]]; // YJK
+		}
+	}
+	return;
+#endif
+
 	for (auto i : xrange(64)) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -73,6 +73,15 @@ public:
 		dPaletteValid = false;
 	}
 
+	/** Update the lazily calculated internal tables. After this call (and
+	  * until the palette changes) convertLine() and convertLinePlanar()
+	  * don't modify this object, so they can be called concurrently.
+	  */
+	inline void prepareConcurrentConvert()
+	{
+		if (!dPaletteValid) calcDPalette();
+	}
+
 private:
 	void calcDPalette();
 
@@ -95,6 +104,17 @@ private:
 
 	using DPixel = typename DoublePixel<sizeof(Pixel)>::type;
 	DPixel dPalette[16 * 16];
+#ifdef __SSSE3__
+	// The palette split in byte planes (byte 'n' of every entry is stored
+	// in plane 'n'), this allows to look up 16 pixels at once with the
+	// pshufb instruction. Like dPalette, these are only valid when
+	// 'dPaletteValid' is true.
+	// - planes16:  the 16 colors for Graphic4 and Graphic6
+	// - planesG5:  entries 0-3 are the colors for the even pixels,
+	//              entries 4-7 the colors for the odd pixels in Graphic5
+	alignas(16) byte planes16[sizeof(Pixel)][16];
+	alignas(16) byte planesG5[sizeof(Pixel)][16];
+#endif
 	DisplayMode mode;
 	bool dPaletteValid;
 };
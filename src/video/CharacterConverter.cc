@@ -90,9 +90,33 @@ static inline __m128i select(__m128i a0, __m128i a1, __m128i mask)
 }
 #endif
 
-template<typename Pixel> static inline void draw6(
+template<typename Pixel>
+void CharacterConverter<Pixel>::draw6(
 	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern)
 {
+#ifdef __SSE2__
+	// SSE2 version, 32bpp, see draw8()
+	if constexpr (sizeof(Pixel) == 4) {
+		const __m128i m74 = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+		const __m128i m32 = _mm_set_epi32(0x00, 0x00, 0x04, 0x08);
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i fg4 = _mm_set1_epi32(fg);
+		__m128i bg4 = _mm_set1_epi32(bg);
+		__m128i pat = _mm_set1_epi32(pattern);
+
+		__m128i b74 = _mm_cmpeq_epi32(_mm_and_si128(pat, m74), zero);
+		__m128i b32 = _mm_cmpeq_epi32(_mm_and_si128(pat, m32), zero);
+
+		auto* out = reinterpret_cast<__m128i*>(pixelPtr);
+		_mm_storeu_si128(out + 0, select(fg4, bg4, b74));
+		_mm_storel_epi64(out + 1, select(fg4, bg4, b32));
+		pixelPtr += 6;
+		return;
+	}
+#endif
+
+	// C++ version
 	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
 	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
 	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
@@ -102,7 +126,8 @@ template<typename Pixel> static inline void draw6(
 	pixelPtr += 6;
 }
 
-template<typename Pixel> static inline void draw8(
+template<typename Pixel>
+void CharacterConverter<Pixel>::draw8(
 	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern)
 {
 #ifdef __SSE2__
@@ -41,6 +41,12 @@ public:
 	  */
 	void setDisplayMode(DisplayMode mode);
 
+	/** Draw 6 or 8 pixels of a pattern byte (bit 7 is the leftmost
+	  * pixel) and advance 'pixelPtr'. Public for the unit test.
+	  */
+	static void draw6(Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern);
+	static void draw8(Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, byte pattern);
+
 private:
 	inline void renderText1   (Pixel* pixelPtr, int line);
 	inline void renderText1Q  (Pixel* pixelPtr, int line);
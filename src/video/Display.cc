@@ -73,6 +73,8 @@ Display::Display(Reactor& reactor_)
 
 Display::~Display()
 {
+	screenShotCmd.reportFinished(true);
+
 	renderSettings.getRendererSetting().detach(*this);
 	renderSettings.getFullScreenSetting().detach(*this);
 	renderSettings.getScaleFactorSetting().detach(*this);
@@ -341,6 +343,7 @@ void Display::repaintImpl()
 	}
 
 	cancelRT(); // cancel delayed repaint
+	screenShotCmd.reportFinished(false);
 
 	if (!renderFrozen) {
 		assert(videoSystem);
@@ -419,12 +422,14 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	bool msxOnly = false;
 	bool doubleSize = false;
 	bool withOsd = false;
+	bool async = false;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
 		flagArg("-raw", rawShot),
 		flagArg("-msxonly", msxOnly),
 		flagArg("-doublesize", doubleSize),
-		flagArg("-with-osd", withOsd)
+		flagArg("-with-osd", withOsd),
+		flagArg("-async", async)
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
 
@@ -459,10 +464,13 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	string filename = FileOperations::parseCommandFileArgument(
 		fname, "screenshots", prefix, ".png");
 
+	reportFinished(false);
+
+	std::future<void> done;
 	if (!rawShot) {
 		// include all layers (OSD stuff, console)
 		try {
-			display.getVideoSystem().takeScreenShot(filename, withOsd);
+			done = display.getVideoSystem().takeScreenShot(filename, withOsd);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
@@ -476,17 +484,50 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 		}
 		unsigned height = doubleSize ? 480 : 240;
 		try {
-			videoLayer->takeRawScreenShot(height, filename);
+			done = videoLayer->takeRawScreenShot(height, filename);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
 		}
 	}
 
-	display.getCliComm().printInfo("Screen saved to ", filename);
+	if (async) {
+		// The PNG encoding continues in the background, the file name
+		// is already reserved. Success or failure is reported later.
+		pending.push_back({filename, std::move(done)});
+	} else {
+		try {
+			done.get();
+		} catch (MSXException& e) {
+			throw CommandException(
+				"Failed to take screenshot: ", e.getMessage());
+		}
+		display.getCliComm().printInfo("Screen saved to ", filename);
+	}
 	result = filename;
 }
 
+void Display::ScreenShotCmd::reportFinished(bool wait)
+{
+	auto& display = OUTER(Display, screenShotCmd);
+	auto it = begin(pending);
+	while (it != end(pending)) {
+		if (!wait && (it->result.wait_for(std::chrono::seconds(0)) !=
+		              std::future_status::ready)) {
+			++it;
+			continue;
+		}
+		try {
+			it->result.get();
+			display.getCliComm().printInfo("Screen saved to ", it->filename);
+		} catch (MSXException& e) {
+			display.getCliComm().printWarning(
+				"Failed to take screenshot: ", e.getMessage());
+		}
+		it = pending.erase(it);
+	}
+}
+
 string Display::ScreenShotCmd::help(span<const TclObject> /*tokens*/) const
 {
 	// Note: -no-sprites option is implemented in Tcl
@@ -496,7 +537,9 @@ string Display::ScreenShotCmd::help(span<const TclObject> /*tokens*/) const
 	       "screenshot -raw              320x240 raw screenshot (of MSX screen only)\n"
 	       "screenshot -raw -doublesize  640x480 raw screenshot (of MSX screen only)\n"
 	       "screenshot -with-osd         Include OSD elements in the screenshot\n"
-	       "screenshot -no-sprites       Don't include sprites in the screenshot\n";
+	       "screenshot -no-sprites       Don't include sprites in the screenshot\n"
+	       "screenshot -async            Return before the file is written, errors are\n"
+	       "                             only reported as a warning\n";
 }
 
 void Display::ScreenShotCmd::tabCompletion(vector<string>& tokens) const
@@ -504,6 +547,7 @@ void Display::ScreenShotCmd::tabCompletion(vector<string>& tokens) const
 	using namespace std::literals;
 	static constexpr std::array extra = {
 		"-prefix"sv, "-raw"sv, "-doublesize"sv, "-with-osd"sv, "-no-sprites"sv,
+		"-async"sv,
 	};
 	completeFileName(tokens, userFileContext(), extra);
 }
@@ -11,6 +11,7 @@
 #include "RTSchedulable.hh"
 #include "Observer.hh"
 #include "CircularBuffer.hh"
+#include <future>
 #include <memory>
 #include <vector>
 #include <cstdint>
@@ -106,6 +107,16 @@ private:
 		void execute(span<const TclObject> tokens, TclObject& result) override;
 		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
 		void tabCompletion(std::vector<std::string>& tokens) const override;
+
+		/** Report the screenshots that finished encoding (in the
+		  * background). When 'wait' is true, first wait for all. */
+		void reportFinished(bool wait);
+
+		struct Pending {
+			std::string filename;
+			std::future<void> result;
+		};
+		std::vector<Pending> pending;
 	} screenShotCmd;
 
 	struct FpsInfoTopic final : InfoTopic {
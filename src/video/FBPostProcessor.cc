@@ -1,20 +1,25 @@
 #include "FBPostProcessor.hh"
+#include "Display.hh"
 #include "RawFrame.hh"
 #include "StretchScalerOutput.hh"
 #include "ScalerOutput.hh"
 #include "RenderSettings.hh"
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
+#include "SDLOffScreenSurface.hh"
 #include "SDLOutputSurface.hh"
+#include "ThreadPool.hh"
 #include "aligned.hh"
 #include "checked_cast.hh"
 #include "random.hh"
+#include "vla.hh"
 #include "xrange.hh"
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <numeric>
 #ifdef __SSE2__
 #include <emmintrin.h>
@@ -252,6 +257,7 @@ FBPostProcessor<Pixel>::FBPostProcessor(MSXMotherBoard& motherBoard_,
 template<typename Pixel>
 FBPostProcessor<Pixel>::~FBPostProcessor()
 {
+	waitScaleJob();
 	renderSettings.getNoiseSetting().detach(*this);
 }
 
@@ -259,6 +265,9 @@ template<typename Pixel>
 void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 {
 	auto& output = checked_cast<SDLOutputSurface&>(output_);
+	// also when the postprocess_thread setting was just disabled
+	waitScaleJob();
+
 	if (renderSettings.getInterleaveBlackFrame()) {
 		interleaveCount ^= 1;
 		if (interleaveCount) {
@@ -269,24 +278,72 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 
 	if (!paintFrame) return;
 
+	if (useScaleThread() && (&output == &screen)) {
+		// Show the most recent frame that was scaled on the worker
+		// thread (normally the previous frame), and only then start
+		// scaling the new frame. That job runs in parallel with the
+		// emulation of the next frame. Scale synchronously when there's
+		// nothing to show yet, or when the scale settings changed.
+		auto& scaled = getScaledSurface();
+		bool scalerChanged = updateScaler(scaled);
+		if (!scaledValid || scalerChanged ||
+		    (renderSettings.getScanlineFactor() != prevScanline) ||
+		    (renderSettings.getBlurFactor() != prevBlur)) {
+			scaleFrame(scaled, nullptr, scalerChanged);
+			scaledValid = true;
+			scalePending = false;
+		}
+		copyScaledFrame(scaled, output);
+		if (scalePending) {
+			scalePending = false;
+			startScaleJob(scaled);
+		}
+	} else {
+		bool scalerChanged = updateScaler(output);
+		scaleFrame(output, superImposeVideoFrame, scalerChanged);
+		if (&output == &screen) {
+			// 'scaledSurface' (if any) is outdated now
+			scaledValid = false;
+			scalePending = false;
+		}
+	}
+
+	drawNoise(output);
+	if (renderSettings.getNoise() != 0.0f) {
+		// the noise is not part of the scaled source lines
+		output.setFrameBufferOwner(nullptr);
+	}
+
+	output.flushFrameBuffer();
+}
+
+template<typename Pixel>
+bool FBPostProcessor<Pixel>::updateScaler(SDLOutputSurface& output)
+{
 	// New scaler algorithm selected? Or different horizontal stretch?
 	auto algo = renderSettings.getScaleAlgorithm();
 	unsigned factor = renderSettings.getScaleFactor();
 	unsigned inWidth = lrintf(renderSettings.getHorizontalStretch());
-	if ((scaleAlgorithm != algo) || (scaleFactor != factor) ||
-	    (inWidth != stretchWidth) || (lastOutput != &output)) {
-		scaleAlgorithm = algo;
-		scaleFactor = factor;
-		stretchWidth = inWidth;
-		lastOutput = &output;
-		currScaler = ScalerFactory<Pixel>::createScaler(
-			PixelOperations<Pixel>(output.getPixelFormat()),
-			renderSettings);
-		stretchScaler = StretchScalerOutputFactory<Pixel>::create(
-			output, pixelOps, inWidth);
+	if ((scaleAlgorithm == algo) && (scaleFactor == factor) &&
+	    (inWidth == stretchWidth) && (lastOutput == &output)) {
+		return false;
 	}
+	scaleAlgorithm = algo;
+	scaleFactor = factor;
+	stretchWidth = inWidth;
+	lastOutput = &output;
+	currScaler = ScalerFactory<Pixel>::createScaler(
+		PixelOperations<Pixel>(output.getPixelFormat()),
+		renderSettings);
+	stretchScaler = StretchScalerOutputFactory<Pixel>::create(
+		output, pixelOps, inWidth);
+	return true;
+}
 
-	// Scale image.
+template<typename Pixel>
+void FBPostProcessor<Pixel>::scaleFrame(
+	SDLOutputSurface& output, const RawFrame* superImpose, bool all)
+{
 	const unsigned srcHeight = paintFrame->getHeight();
 	const unsigned dstHeight = output.getLogicalHeight();
 
@@ -294,6 +351,19 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 	unsigned srcStep = srcHeight / g;
 	unsigned dstStep = dstHeight / g;
 
+	// Only scale the source lines that changed since the previous paint,
+	// this requires that the frame buffer still contains the result of
+	// that paint. A superimposed video frame is not part of the source
+	// lines, so then everything is repainted.
+	int scanline = renderSettings.getScanlineFactor();
+	int blur = renderSettings.getBlurFactor();
+	findDirtyLines(*paintFrame,
+	               all || superImpose ||
+	               (output.getFrameBufferOwner() != this) ||
+	               (scanline != prevScanline) || (blur != prevBlur));
+	prevScanline = scanline;
+	prevBlur = blur;
+
 	// TODO: Store all MSX lines in RawFrame and only scale the ones that fit
 	//       on the PC screen, as a preparation for resizable output window.
 	unsigned srcStartY = 0;
@@ -313,22 +383,94 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 			dstEndY += dstStep;
 		}
 
-		// fill region
+		// fill region, skip the parts that didn't change
 		//fprintf(stderr, "post processing lines %d-%d: %d\n",
 		//        srcStartY, srcEndY, lineWidth);
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*stretchScaler, dstStartY, dstEndY); // dest
+		unsigned srcY = srcStartY;
+		unsigned dstY = dstStartY;
+		while (srcY < srcEndY) {
+			bool dirty = isDirty(srcY, srcStep);
+			unsigned srcY2 = srcY + srcStep;
+			unsigned dstY2 = dstY + dstStep;
+			while ((srcY2 < srcEndY) && (isDirty(srcY2, srcStep) == dirty)) {
+				srcY2 += srcStep;
+				dstY2 += dstStep;
+			}
+			if (dirty) {
+				currScaler->scaleImage(
+					*paintFrame, superImpose,
+					srcY, srcY2, lineWidth, // source
+					*stretchScaler, dstY, dstY2); // dest
+			}
+			srcY = srcY2;
+			dstY = dstY2;
+		}
 
 		// next region
 		srcStartY = srcEndY;
 		dstStartY = dstEndY;
 	}
 
-	drawNoise(output);
+	output.setFrameBufferOwner(superImpose ? nullptr : this);
+}
 
-	output.flushFrameBuffer();
+template<typename Pixel>
+void FBPostProcessor<Pixel>::findDirtyLines(FrameSource& frame, bool all)
+{
+	unsigned numLines = frame.getHeight();
+	unsigned pitch = maxWidth;
+	if (prevWidths.size() != numLines) {
+		prevLines.resize(size_t(numLines) * pitch);
+		prevWidths.assign(numLines, 0); // never equal to an actual width
+	}
+	dirtyLines.assign(numLines, all);
+	if (all) {
+		// still remember the current lines for the next paint
+		for (auto& w : prevWidths) w = 0;
+	}
+
+	VLA_SSE_ALIGNED(Pixel, buf, pitch);
+	std::vector<bool> changed(numLines);
+	for (auto y : xrange(numLines)) {
+		unsigned width = frame.getLineWidth(y);
+		if (width > pitch) {
+			changed[y] = true;
+			prevWidths[y] = 0;
+			continue;
+		}
+		const Pixel* line = frame.getLinePtr(y, width, buf);
+		Pixel* prev = &prevLines[size_t(y) * pitch];
+		if ((prevWidths[y] != width) ||
+		    (memcmp(prev, line, width * sizeof(Pixel)) != 0)) {
+			changed[y] = true;
+			prevWidths[y] = width;
+			memcpy(prev, line, width * sizeof(Pixel));
+		}
+	}
+	if (all) return;
+
+	// The scaled output of a line also depends on the lines around it.
+	unsigned radius = std::min(currScaler->getVerticalRadius(), numLines);
+	unsigned dist = radius + 1;
+	for (auto y : xrange(numLines)) {
+		dist = changed[y] ? 0 : dist + 1;
+		if (dist <= radius) dirtyLines[y] = true;
+	}
+	dist = radius + 1;
+	for (unsigned y = numLines; y-- > 0; ) {
+		dist = changed[y] ? 0 : dist + 1;
+		if (dist <= radius) dirtyLines[y] = true;
+	}
+}
+
+template<typename Pixel>
+bool FBPostProcessor<Pixel>::isDirty(unsigned y, unsigned step) const
+{
+	unsigned end = std::min<unsigned>(y + step, dirtyLines.size());
+	for (/**/; y < end; ++y) {
+		if (dirtyLines[y]) return true;
+	}
+	return false;
 }
 
 template<typename Pixel>
@@ -341,7 +483,83 @@ std::unique_ptr<RawFrame> FBPostProcessor<Pixel>::rotateFrames(
 		noiseShift[y] = distribution(generator) * 16;
 	}
 
-	return PostProcessor::rotateFrames(std::move(finishedFrame), time);
+	// The scale job reads the frames that are rotated (and recycled) below.
+	// Normally it finished long ago, it was started by the paint of the
+	// previous frame.
+	waitScaleJob();
+	auto result = PostProcessor::rotateFrames(std::move(finishedFrame), time);
+	// The new frame is scaled after the next paint, see paint().
+	scalePending = paintFrame != nullptr;
+	return result;
+}
+
+template<typename Pixel>
+bool FBPostProcessor<Pixel>::useScaleThread() const
+{
+	// The superimposed frames belong to another video source, those can
+	// change while the scale job is running.
+	return renderSettings.getPostProcessThread() &&
+	       needRender() &&
+	       !superImposeVideoFrame && !superImposeVdpFrame;
+}
+
+template<typename Pixel>
+SDLOutputSurface& FBPostProcessor<Pixel>::getScaledSurface()
+{
+	auto& output = checked_cast<SDLOutputSurface&>(screen);
+	const SDL_Surface& proto = *output.getSDLSurface();
+	if (!scaledSurface ||
+	    (scaledSurface->getSDLSurface()->w != proto.w) ||
+	    (scaledSurface->getSDLSurface()->h != proto.h)) {
+		scaledSurface = std::make_unique<SDLOffScreenSurface>(proto);
+		scaledValid = false;
+		lastOutput = nullptr; // the new surface may get the same address
+	}
+	return *scaledSurface;
+}
+
+template<typename Pixel>
+void FBPostProcessor<Pixel>::startScaleJob(SDLOutputSurface& scaled)
+{
+	// Everything that needs the Tcl interpreter or SDL (the settings, the
+	// scaler creation) was done in paint(), the job itself only scales
+	// the frame in the offscreen 'scaledSurface'. The next paint() copies
+	// the result to the screen. There's at most one job in flight, so
+	// when scaling can't keep up, the emulation is slowed down (in the
+	// next rotateFrames()).
+	scaleJob = ThreadPool::instance().submit([this, &scaled] {
+		scaleFrame(scaled, nullptr, false);
+	});
+
+	// Normally the next frame repaints the screen, but e.g. when the
+	// emulation is paused, this frame must still be shown.
+	display.repaintDelayed(40000); // 25fps
+}
+
+template<typename Pixel>
+void FBPostProcessor<Pixel>::waitScaleJob()
+{
+	if (scaleJob.valid()) {
+		scaleJob.get();
+	}
+}
+
+template<typename Pixel>
+void FBPostProcessor<Pixel>::copyScaledFrame(
+	SDLOutputSurface& scaled, SDLOutputSurface& output)
+{
+	const SDL_Surface& src = *scaled.getSDLSurface();
+	SDL_Surface& dst = *output.getSDLSurface();
+	assert((src.w == dst.w) && (src.h == dst.h));
+	auto srcAccess = scaled.getDirectPixelAccess();
+	auto dstAccess = output.getDirectPixelAccess();
+	for (auto y : xrange(dst.h)) {
+		memcpy(dstAccess.template getLinePtr<Pixel>(y),
+		       srcAccess.template getLinePtr<Pixel>(y),
+		       dst.w * sizeof(Pixel));
+	}
+	// the output now holds a copy
+	output.setFrameBufferOwner(nullptr);
 }
 
 
@@ -5,12 +5,16 @@
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
 #include "ScalerOutput.hh"
+#include "MemBuffer.hh"
+#include <future>
+#include <memory>
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Display;
+class SDLOutputSurface;
 template<typename Pixel> class Scaler;
 
 /** Rasterizer using SDL.
@@ -39,6 +43,34 @@ private:
 	void drawNoiseLine(Pixel* buf, signed char* noise,
 	                   size_t width);
 
+	/** (Re)create the scalers if the scale settings or the output changed.
+	  * @return true iff the scalers were recreated.
+	  */
+	bool updateScaler(SDLOutputSurface& output);
+
+	/** Scale 'paintFrame' to the given output (using the scalers created
+	  * by updateScaler()). This doesn't use the Tcl interpreter or SDL, so
+	  * it can also run on a worker thread.
+	  * @param all Scale all lines, not only the ones that changed.
+	  */
+	void scaleFrame(SDLOutputSurface& output, const RawFrame* superImpose,
+	                bool all);
+
+	/** Should frames be scaled on a worker thread (see rotateFrames())?
+	  */
+	[[nodiscard]] bool useScaleThread() const;
+	[[nodiscard]] SDLOutputSurface& getScaledSurface();
+	void startScaleJob(SDLOutputSurface& scaled);
+	void waitScaleJob();
+	void copyScaledFrame(SDLOutputSurface& scaled, SDLOutputSurface& output);
+
+	/** Compare the lines of the given frame with the ones of the previous
+	  * paint and fill in 'dirtyLines': the lines that must be scaled.
+	  * @param all Mark all lines as dirty.
+	  */
+	void findDirtyLines(FrameSource& frame, bool all);
+	[[nodiscard]] bool isDirty(unsigned y, unsigned step) const;
+
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
@@ -71,6 +103,31 @@ private:
 	 */
 	std::vector<unsigned> noiseShift;
 
+	/** Copy of the (unscaled) source lines of the previous paint, and
+	  * their widths. Only the lines that changed, and the lines around
+	  * them, are scaled again, see findDirtyLines().
+	  */
+	MemBuffer<Pixel> prevLines;
+	std::vector<unsigned> prevWidths;
+	std::vector<bool> dirtyLines;
+
+	/** Scaler settings that were used for the previous paint.
+	  */
+	int prevScanline = -1;
+	int prevBlur = -1;
+
+	/** With the 'postprocess_thread' setting enabled, each new frame is
+	  * scaled on a worker thread to this offscreen surface, in parallel
+	  * with the emulation of the next frame. So the screen shows the
+	  * frames one frame later. 'scaledValid' indicates whether (after the
+	  * job finished) it contains a complete frame, 'scalePending' whether
+	  * 'paintFrame' still has to be scaled.
+	  */
+	std::unique_ptr<SDLOutputSurface> scaledSurface;
+	std::future<void> scaleJob;
+	bool scaledValid = false;
+	bool scalePending = false;
+
 	PixelOperations<Pixel> pixelOps;
 };
 
@@ -3,6 +3,7 @@
 
 #include "PixelFormat.hh"
 #include "gl_vec.hh"
+#include <future>
 #include <string>
 #include <cassert>
 #include <cstdint>
@@ -100,9 +101,11 @@ public:
 	}
 
 	/** Save the content of this OutputSurface to a PNG file.
+	  * The pixels are captured immediately, the PNG encoding happens in
+	  * the background. Encoding errors are reported via the future.
 	  * @throws MSXException If creating the PNG file fails.
 	  */
-	virtual void saveScreenshot(const std::string& filename) = 0;
+	[[nodiscard]] virtual std::future<void> saveScreenshot(const std::string& filename) = 0;
 
 protected:
 	OutputSurface() = default;
@@ -1,6 +1,7 @@
 #include "PNG.hh"
 #include "MSXException.hh"
 #include "File.hh"
+#include "ThreadPool.hh"
 #include "build-info.hh"
 #include "Version.hh"
 #include "one_of.hh"
@@ -283,81 +284,119 @@ static void flushData(png_structp ctx)
 	file->flush();
 }
 
+static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
+                           File& file, bool color)
+{
+	PNGWriteHandle png;
+	png.ptr = png_create_write_struct(
+		PNG_LIBPNG_VER_STRING,
+		const_cast<char*>("encoding"), handleError, handleWarning);
+	if (!png.ptr) {
+		throw MSXException("Failed to allocate main struct");
+	}
+
+	// Allocate/initialize the image information data.  REQUIRED
+	png.info = png_create_info_struct(png.ptr);
+	if (!png.info) {
+		// Couldn't create image information for PNG file
+		throw MSXException("Failed to allocate image info struct");
+	}
+
+	// Set up the output control.
+	png_set_write_fn(png.ptr, &file, writeData, flushData);
+
+	// Mark this image as being generated by openMSX and add creation time.
+	std::string version = Version::full();
+	png_text text[2];
+	text[0].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[0].key  = const_cast<char*>("Software");
+	text[0].text = const_cast<char*>(version.c_str());
+	text[1].compression = PNG_TEXT_COMPRESSION_NONE;
+	text[1].key  = const_cast<char*>("Creation Time");
+
+	// A buffer size of 20 characters is large enough till the year
+	// 9999. But the compiler doesn't understand calendars and
+	// warns that the snprintf output could be truncated (e.g.
+	// because the year is -2147483647). To silence this warning
+	// (and also to work around the windows _snprintf stuff) we add
+	// some extra buffer space.
+	static constexpr size_t size = (10 + 1 + 8 + 1) + 44;
+	time_t now = time(nullptr);
+	struct tm* tm = localtime(&now);
+	char timeStr[size];
+	snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
+			1900 + tm->tm_year, tm->tm_mon + 1, tm->tm_mday,
+			tm->tm_hour, tm->tm_min, tm->tm_sec);
+	text[1].text = timeStr;
+
+	png_set_text(png.ptr, png.info, text, 2);
+
+	png_set_IHDR(png.ptr, png.info, width, height, 8,
+				color ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_GRAY,
+				PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
+				PNG_FILTER_TYPE_BASE);
+
+	// Write the file header information.  REQUIRED
+	png_write_info(png.ptr, png.info);
+
+	// Write out the entire image data in one call.
+	png_write_image(
+		png.ptr,
+		reinterpret_cast<png_bytep*>(const_cast<void**>(row_pointers)));
+	png_write_end(png.ptr, png.info);
+}
+
+[[noreturn]] static void rethrowWithFilename(MSXException& e, const std::string& filename)
+{
+	throw MSXException(
+		"Error while writing PNG file \"", filename, "\": ",
+		e.getMessage());
+}
+
 static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
                            const std::string& filename, bool color)
 {
 	try {
 		File file(filename, File::TRUNCATE);
+		IMG_SavePNG_RW(width, height, row_pointers, file, color);
+	} catch (MSXException& e) {
+		rethrowWithFilename(e, filename);
+	}
+}
 
-		PNGWriteHandle png;
-		png.ptr = png_create_write_struct(
-			PNG_LIBPNG_VER_STRING,
-			const_cast<char*>("encoding"), handleError, handleWarning);
-		if (!png.ptr) {
-			throw MSXException("Failed to allocate main struct");
-		}
-
-		// Allocate/initialize the image information data.  REQUIRED
-		png.info = png_create_info_struct(png.ptr);
-		if (!png.info) {
-			// Couldn't create image information for PNG file
-			throw MSXException("Failed to allocate image info struct");
-		}
-
-		// Set up the output control.
-		png_set_write_fn(png.ptr, &file, writeData, flushData);
-
-		// Mark this image as being generated by openMSX and add creation time.
-		std::string version = Version::full();
-		png_text text[2];
-		text[0].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[0].key  = const_cast<char*>("Software");
-		text[0].text = const_cast<char*>(version.c_str());
-		text[1].compression = PNG_TEXT_COMPRESSION_NONE;
-		text[1].key  = const_cast<char*>("Creation Time");
-
-		// A buffer size of 20 characters is large enough till the year
-		// 9999. But the compiler doesn't understand calendars and
-		// warns that the snprintf output could be truncated (e.g.
-		// because the year is -2147483647). To silence this warning
-		// (and also to work around the windows _snprintf stuff) we add
-		// some extra buffer space.
-		static constexpr size_t size = (10 + 1 + 8 + 1) + 44;
-		time_t now = time(nullptr);
-		struct tm* tm = localtime(&now);
-		char timeStr[size];
-		snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
-				1900 + tm->tm_year, tm->tm_mon + 1, tm->tm_mday,
-				tm->tm_hour, tm->tm_min, tm->tm_sec);
-		text[1].text = timeStr;
-
-		png_set_text(png.ptr, png.info, text, 2);
-
-		png_set_IHDR(png.ptr, png.info, width, height, 8,
-					color ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_GRAY,
-					PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
-					PNG_FILTER_TYPE_BASE);
-
-		// Write the file header information.  REQUIRED
-		png_write_info(png.ptr, png.info);
-
-		// Write out the entire image data in one call.
-		png_write_image(
-			png.ptr,
-			reinterpret_cast<png_bytep*>(const_cast<void**>(row_pointers)));
-		png_write_end(png.ptr, png.info);
+// Create the file now, but do the actual encoding on the ThreadPool.
+template<typename GetRows>
+[[nodiscard]] static std::future<void> IMG_SavePNG_RW_async(
+	int width, int height, GetRows getRows, const std::string& filename)
+{
+	File file;
+	try {
+		file = File(filename, File::TRUNCATE);
 	} catch (MSXException& e) {
-		throw MSXException(
-			"Error while writing PNG file \"", filename, "\": ",
-			e.getMessage());
+		rethrowWithFilename(e, filename);
 	}
+	return ThreadPool::instance().submit(
+		[width, height, getRows = std::move(getRows),
+		 file = std::move(file), filename]() mutable {
+			try {
+				auto rowPointers = getRows();
+				IMG_SavePNG_RW(width, height, rowPointers.data(), file, true);
+			} catch (MSXException& e) {
+				rethrowWithFilename(e, filename);
+			}
+		});
 }
 
-static void save(SDL_Surface* image, const std::string& filename)
+[[nodiscard]] static SDLSurfacePtr convertToRGB24(SDL_Surface* image)
 {
 	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
 		OPENMSX_BIGENDIAN ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
-	SDLSurfacePtr surf24(SDL_ConvertSurface(image, frmt24.get(), 0));
+	return SDLSurfacePtr(SDL_ConvertSurface(image, frmt24.get(), 0));
+}
+
+static void save(SDL_Surface* image, const std::string& filename)
+{
+	SDLSurfacePtr surf24 = convertToRGB24(image);
 
 	// Create the array of pointers to image data
 	VLA(const void*, row_pointers, image->h);
@@ -368,10 +407,10 @@ static void save(SDL_Surface* image, const std::string& filename)
 	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true);
 }
 
-void save(unsigned width, unsigned height, const void** rowPointers,
-          const PixelFormat& format, const std::string& filename)
+[[nodiscard]] static SDLSurfacePtr copyToSurface(
+	unsigned width, unsigned height, const void** rowPointers,
+	const PixelFormat& format)
 {
-	// this implementation creates 1 extra copy, can be optimized if required
 	SDLSurfacePtr surface(
 		width, height, format.getBpp(),
 		format.getRmask(), format.getGmask(), format.getBmask(), format.getAmask());
@@ -379,9 +418,44 @@ void save(unsigned width, unsigned height, const void** rowPointers,
 		memcpy(surface.getLinePtr(y),
 		       rowPointers[y], width * format.getBytesPerPixel());
 	}
+	return surface;
+}
+
+void save(unsigned width, unsigned height, const void** rowPointers,
+          const PixelFormat& format, const std::string& filename)
+{
+	// this implementation creates 1 extra copy, can be optimized if required
+	auto surface = copyToSurface(width, height, rowPointers, format);
 	save(surface.get(), filename);
 }
 
+std::future<void> saveAsync(unsigned width, unsigned height,
+                            const void** rowPointers, const PixelFormat& format,
+                            const std::string& filename)
+{
+	// The conversion to RGB24 also happens on the worker thread. The
+	// (converted) surface is owned by the job, so it outlives the
+	// returned row pointers.
+	return IMG_SavePNG_RW_async(width, height,
+		[surface = copyToSurface(width, height, rowPointers, format), height]() mutable {
+			surface = convertToRGB24(surface.get());
+			std::vector<const void*> rows(height);
+			for (auto y : xrange(height)) rows[y] = surface.getLinePtr(y);
+			return rows;
+		}, filename);
+}
+
+std::future<void> saveAsync(unsigned width, unsigned height,
+                            MemBuffer<uint8_t> rgb24, const std::string& filename)
+{
+	return IMG_SavePNG_RW_async(width, height,
+		[pixels = std::move(rgb24), width, height]() mutable {
+			std::vector<const void*> rows(height);
+			for (auto y : xrange(height)) rows[y] = &pixels[size_t(width) * 3 * y];
+			return rows;
+		}, filename);
+}
+
 void save(unsigned width, unsigned height,
           const void** rowPointers, const std::string& filename)
 {
@@ -2,7 +2,10 @@
 #define PNG_HH
 
 #include "PixelFormat.hh"
+#include "MemBuffer.hh"
 #include "SDLSurfacePtr.hh"
+#include <cstdint>
+#include <future>
 #include <string>
 
 /** Utility functions to hide the complexity of saving to a PNG file.
@@ -23,6 +26,21 @@ namespace openmsx::PNG {
 	void saveGrayscale(unsigned width, unsigned height,
 	                   const void** rowPointers, const std::string& filename);
 
+	/** Like save(), but the (slow) PNG encoding runs on the ThreadPool.
+	 * The file itself is already created when these functions return (so
+	 * e.g. the next numbered screenshot gets a different name), errors
+	 * while opening it are thrown immediately. Errors during encoding
+	 * are reported via the returned future.
+	 * The first variant copies the given rows, the second one takes
+	 * ownership of tightly packed (top-down) RGB24 data.
+	 */
+	[[nodiscard]] std::future<void> saveAsync(
+		unsigned width, unsigned height, const void** rowPointers,
+		const PixelFormat& format, const std::string& filename);
+	[[nodiscard]] std::future<void> saveAsync(
+		unsigned width, unsigned height, MemBuffer<uint8_t> rgb24,
+		const std::string& filename);
+
 } // namespace openmsx::PNG
 
 #endif // PNG_HH
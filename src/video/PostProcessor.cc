@@ -256,7 +256,7 @@ static void getScaledFrame(FrameSource& paintFrame, unsigned bpp,
 	}
 }
 
-void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
+std::future<void> PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
 {
 	if (!paintFrame) {
 		throw CommandException("TODO");
@@ -266,7 +266,7 @@ void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filen
 	WorkBuffer workBuffer;
 	getScaledFrame(*paintFrame, getBpp(), height2, lines, workBuffer);
 	unsigned width = (height2 == 240) ? 320 : 640;
-	PNG::save(width, height2, lines, paintFrame->getPixelFormat(), filename);
+	return PNG::saveAsync(width, height2, lines, paintFrame->getPixelFormat(), filename);
 }
 
 unsigned PostProcessor::getBpp() const
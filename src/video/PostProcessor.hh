@@ -87,7 +87,7 @@ public:
 	[[nodiscard]] FrameSource* getPaintFrame() const { return paintFrame; }
 
 	// VideoLayer
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	[[nodiscard]] std::future<void> takeRawScreenShot(unsigned height, const std::string& filename) override;
 
 	[[nodiscard]] CliComm& getCliComm();
 
@@ -142,13 +142,13 @@ protected:
 	int maxWidth; // we lazily create RawFrame objects in lastFrames[]
 	int height;   // these two vars remember how big those should be
 
+	Display& display;
+
 private:
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
 
 private:
-	Display& display;
-
 	/** Laserdisc cannot do interlace (better: the current implementation
 	  * is not interlaced). In that case some internal stuff can be done
 	  * with less buffers.
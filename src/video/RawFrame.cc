@@ -8,6 +8,7 @@ RawFrame::RawFrame(
 		const PixelFormat& format, unsigned maxWidth_, unsigned height_)
 	: FrameSource(format)
 	, lineWidths(height_)
+	, lineTags(height_)
 	, maxWidth(maxWidth_)
 {
 	setHeight(height_);
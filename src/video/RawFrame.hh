@@ -4,6 +4,7 @@
 #include "FrameSource.hh"
 #include "MemBuffer.hh"
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -36,6 +37,21 @@ public:
 		auto* pixels = getLinePtrDirect<Pixel>(line);
 		pixels[0] = color;
 		lineWidths[line] = 1;
+		lineTags[line] = 0;
+	}
+
+	/** A line can be tagged by whoever renders it, to later recognize
+	  * whether the line still holds the same content (see SDLRasterizer).
+	  * Tag value 0 means 'unknown content', setBlank() resets the tag to
+	  * this value.
+	  */
+	[[nodiscard]] uint64_t getLineTag(unsigned line) const {
+		assert(line < getHeight());
+		return lineTags[line];
+	}
+	void setLineTag(unsigned line, uint64_t tag) {
+		assert(line < getHeight());
+		lineTags[line] = tag;
 	}
 
 	[[nodiscard]] unsigned getRowLength() const override;
@@ -50,6 +66,7 @@ protected:
 private:
 	MemBuffer<char, 64> data;
 	MemBuffer<unsigned> lineWidths;
+	MemBuffer<uint64_t> lineTags;
 	unsigned maxWidth;
 	unsigned pitch;
 };
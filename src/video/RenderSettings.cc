@@ -2,6 +2,7 @@
 #include "CommandController.hh"
 #include "CommandException.hh"
 #include "Version.hh"
+#include "one_of.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -185,10 +186,20 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"Useful on (100Hz+) lightboost enabled monitors to reduce "
 		"motion blur and double frame artifacts.",
 		false)
+
+	, postProcessThreadSetting(commandController,
+		"postprocess_thread",
+		"Scale the MSX frames on a separate thread, in parallel with "
+		"the emulation of the next frame. This delays the display by "
+		"one frame. Only for the SDL renderer.",
+		false)
 {
 	brightnessSetting.attach(*this);
 	contrastSetting  .attach(*this);
 	updateBrightnessAndContrast();
+	horizontalBlurSetting.attach(*this);
+	scanlineAlphaSetting .attach(*this);
+	updateBlurAndScanline();
 
 	auto& interp = commandController.getInterpreter();
 	colorMatrixSetting.setChecker([this, &interp](TclObject& newValue) {
@@ -230,6 +241,8 @@ RenderSettings::RenderSettings(CommandController& commandController)
 
 RenderSettings::~RenderSettings()
 {
+	scanlineAlphaSetting .detach(*this);
+	horizontalBlurSetting.detach(*this);
 	brightnessSetting.detach(*this);
 	contrastSetting  .detach(*this);
 }
@@ -240,6 +253,9 @@ void RenderSettings::update(const Setting& setting) noexcept
 		updateBrightnessAndContrast();
 	} else if (&setting == &contrastSetting) {
 		updateBrightnessAndContrast();
+	} else if (&setting == one_of(&horizontalBlurSetting,
+	                              &scanlineAlphaSetting)) {
+		updateBlurAndScanline();
 	} else {
 		UNREACHABLE;
 	}
@@ -253,6 +269,12 @@ void RenderSettings::updateBrightnessAndContrast()
 	brightness = (getBrightness() / 100.0f - 0.5f) * contrast + 0.5f;
 }
 
+void RenderSettings::updateBlurAndScanline()
+{
+	blurFactor = horizontalBlurSetting.getInt() * 256 / 100;
+	scanlineFactor = 255 - ((scanlineAlphaSetting.getInt() * 255) / 100);
+}
+
 static float conv2(float x, float gamma)
 {
 	return ::powf(std::min(std::max(0.0f, x), 1.0f), gamma);
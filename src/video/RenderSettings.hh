@@ -8,6 +8,7 @@
 #include "StringSetting.hh"
 #include "Observer.hh"
 #include "gl_mat.hh"
+#include <atomic>
 
 namespace openmsx {
 
@@ -91,14 +92,17 @@ public:
 	[[nodiscard]] FloatSetting& getNoiseSetting() { return noiseSetting; }
 	[[nodiscard]] float getNoise() const { return noiseSetting.getDouble(); }
 
-	/** The amount of horizontal blur [0..256]. */
+	/** The amount of horizontal blur [0..256].
+	  * Unlike most other getters, this (and getScanlineFactor()) may also
+	  * be called from a non-main thread, see FBPostProcessor.
+	  */
 	[[nodiscard]] int getBlurFactor() const {
-		return (horizontalBlurSetting.getInt()) * 256 / 100;
+		return blurFactor;
 	}
 
 	/** The alpha value [0..255] of the gap between scanlines. */
 	[[nodiscard]] int getScanlineFactor() const {
-		return 255 - ((scanlineAlphaSetting.getInt() * 255) / 100);
+		return scanlineFactor;
 	}
 
 	/** The amount of space [0..1] between scanlines. */
@@ -172,6 +176,12 @@ public:
 		return interleaveBlackFrameSetting.getBoolean();
 	}
 
+	/** Scale frames on a separate thread, in parallel with emulating the
+	  * next frame? */
+	[[nodiscard]] bool getPostProcessThread() const {
+		return postProcessThreadSetting.getBoolean();
+	}
+
 	/** Apply brightness, contrast and gamma transformation on the input
 	  * color component. The component is expected to be in the range
 	  * [0.0 .. 1.0] but it's not an error if it lays outside of this range.
@@ -201,6 +211,11 @@ private:
 	  */
 	void updateBrightnessAndContrast();
 
+	/** Sets the "blurFactor" and "scanlineFactor" fields according to the
+	  * setting values.
+	  */
+	void updateBlurAndScanline();
+
 	void parseColorMatrix(Interpreter& interp, const TclObject& value);
 
 private:
@@ -230,9 +245,12 @@ private:
 	FloatSetting horizontalStretchSetting;
 	FloatSetting pointerHideDelaySetting;
 	BooleanSetting interleaveBlackFrameSetting;
+	BooleanSetting postProcessThreadSetting;
 
 	float brightness;
 	float contrast;
+	std::atomic<int> blurFactor;
+	std::atomic<int> scanlineFactor;
 
 	/** Parsed color matrix, kept in sync with colorMatrix setting. */
 	gl::mat3 colorMatrix;
@@ -25,9 +25,9 @@ SDLGLOffScreenSurface::SDLGLOffScreenSurface(const OutputSurface& output)
 	setOpenGlPixelFormat();
 }
 
-void SDLGLOffScreenSurface::saveScreenshot(const std::string& filename)
+std::future<void> SDLGLOffScreenSurface::saveScreenshot(const std::string& filename)
 {
-	SDLGLVisibleSurface::saveScreenshotGL(*this, filename);
+	return SDLGLVisibleSurface::saveScreenshotGL(*this, filename);
 }
 
 } // namespace openmsx
@@ -16,7 +16,7 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	[[nodiscard]] std::future<void> saveScreenshot(const std::string& filename) override;
 
 private:
 	gl::Texture fboTex;
@@ -10,7 +10,6 @@
 #include "build-info.hh"
 #include "MemBuffer.hh"
 #include "outer.hh"
-#include "vla.hh"
 #include "InitException.hh"
 #include <memory>
 
@@ -108,12 +107,12 @@ SDLGLVisibleSurface::~SDLGLVisibleSurface()
 	SDL_GL_DeleteContext(glContext);
 }
 
-void SDLGLVisibleSurface::saveScreenshot(const std::string& filename)
+std::future<void> SDLGLVisibleSurface::saveScreenshot(const std::string& filename)
 {
-	saveScreenshotGL(*this, filename);
+	return saveScreenshotGL(*this, filename);
 }
 
-void SDLGLVisibleSurface::saveScreenshotGL(
+std::future<void> SDLGLVisibleSurface::saveScreenshotGL(
 	const OutputSurface& output, const std::string& filename)
 {
 	auto [x, y] = output.getViewOffset();
@@ -123,13 +122,11 @@ void SDLGLVisibleSurface::saveScreenshotGL(
 	MemBuffer<uint8_t> buffer(w * h * 4);
 	glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
 
-	// perform in-place conversion of RGBA -> RGB
-	VLA(const void*, rowPointers, h);
+	// convert RGBA -> RGB and flip vertically
+	MemBuffer<uint8_t> rgb(w * h * 3);
 	for (auto i : xrange(h)) {
-		uint8_t* out = &buffer[w * 4 * i];
-		const uint8_t* in = out;
-		rowPointers[h - 1 - i] = out;
-
+		const uint8_t* in = &buffer[w * 4 * i];
+		uint8_t* out = &rgb[w * 3 * (h - 1 - i)];
 		for (auto j : xrange(w)) {
 			out[3 * j + 0] = in[4 * j + 0];
 			out[3 * j + 1] = in[4 * j + 1];
@@ -137,7 +134,7 @@ void SDLGLVisibleSurface::saveScreenshotGL(
 		}
 	}
 
-	PNG::save(w, h, rowPointers, filename);
+	return PNG::saveAsync(w, h, std::move(rgb), filename);
 }
 
 void SDLGLVisibleSurface::finish()
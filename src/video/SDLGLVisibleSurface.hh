@@ -19,11 +19,11 @@ public:
 	                    VideoSystem& videoSystem);
 	~SDLGLVisibleSurface() override;
 
-	static void saveScreenshotGL(const OutputSurface& output,
-	                             const std::string& filename);
+	[[nodiscard]] static std::future<void> saveScreenshotGL(
+		const OutputSurface& output, const std::string& filename);
 
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	[[nodiscard]] std::future<void> saveScreenshot(const std::string& filename) override;
 
 	// VisibleSurface
 	void finish() override;
@@ -35,14 +35,15 @@ SDLOffScreenSurface::SDLOffScreenSurface(const SDL_Surface& proto)
 	setSDLRenderer(renderer.get());
 }
 
-void SDLOffScreenSurface::saveScreenshot(const std::string& filename)
+std::future<void> SDLOffScreenSurface::saveScreenshot(const std::string& filename)
 {
-	SDLVisibleSurface::saveScreenshotSDL(*this, filename);
+	return SDLVisibleSurface::saveScreenshotSDL(*this, filename);
 }
 
 void SDLOffScreenSurface::clearScreen()
 {
 	memset(surface->pixels, 0, uint32_t(surface->pitch) * surface->h);
+	setFrameBufferOwner(nullptr);
 }
 
 } // namespace openmsx
@@ -15,7 +15,7 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	[[nodiscard]] std::future<void> saveScreenshot(const std::string& filename) override;
 	void clearScreen() override;
 
 private:
@@ -61,6 +61,14 @@ public:
 	 */
 	virtual void clearScreen() {}
 
+	/** Remember who painted the (complete) frame buffer last. That painter
+	  * can then later choose to only repaint the parts that changed. Any
+	  * other modification of the frame buffer (e.g. clearScreen()) should
+	  * reset this to nullptr.
+	  */
+	void setFrameBufferOwner(const void* owner) { frameBufferOwner = owner; }
+	[[nodiscard]] const void* getFrameBufferOwner() const { return frameBufferOwner; }
+
 protected:
 	SDLOutputSurface() = default;
 
@@ -71,6 +79,7 @@ protected:
 private:
 	SDL_Surface* surface = nullptr;
 	SDL_Renderer* renderer = nullptr;
+	const void* frameBufferOwner = nullptr;
 };
 
 } // namespace openmsx
@@ -1,6 +1,7 @@
 #include "SDLRasterizer.hh"
 #include "VDP.hh"
 #include "VDPVRAM.hh"
+#include "SpriteChecker.hh"
 #include "RawFrame.hh"
 #include "Display.hh"
 #include "Renderer.hh"
@@ -8,6 +9,7 @@
 #include "PostProcessor.hh"
 #include "MemoryOps.hh"
 #include "OutputSurface.hh"
+#include "ThreadPool.hh"
 #include "enumerate.hh"
 #include "one_of.hh"
 #include "xrange.hh"
@@ -16,6 +18,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
 
 using namespace gl;
@@ -54,6 +58,51 @@ static constexpr int translateX(int absoluteX, bool narrow)
 	return std::max(screenX, 0);
 }
 
+/** Translate a screen X coordinate (as returned by translateX()) to the
+  * corresponding coordinate on a 640 pixels wide line.
+  */
+static constexpr int to640(int screenX, bool narrow)
+{
+	return narrow ? screenX : 2 * screenX;
+}
+
+/** Calls 'renderLine(y, displayY)' for all screen lines 'y' in the range
+  * [fromY, limitY). The given 'displayY' is used for the first line, for
+  * each next line it's incremented (modulo 256).
+  * Larger ranges are split over the ThreadPool. This is safe because the
+  * emulation (so also VRAM and the VDP registers) is stopped while a
+  * drawDisplay() call is in progress, and each line only writes to its own
+  * line in the output frame. So the result is identical to rendering the
+  * lines one after the other.
+  */
+template<typename RenderLine>
+static void renderLines(int fromY, int limitY, int displayY, RenderLine renderLine)
+{
+	// Below this number of lines per job, the synchronization overhead
+	// outweighs the gain.
+	constexpr int MIN_LINES_PER_JOB = 16;
+
+	int numLines = limitY - fromY;
+	auto& pool = ThreadPool::instance();
+	unsigned numJobs = std::min<unsigned>(
+		pool.getNumThreads() + 1, // the calling thread also works
+		std::max(numLines / MIN_LINES_PER_JOB, 1));
+	auto renderRange = [&](int begin, int end) {
+		for (auto y : xrange(begin, end)) {
+			renderLine(y, (y == fromY) ? displayY
+			                           : ((displayY + y - fromY) & 255));
+		}
+	};
+	if (numJobs == 1) {
+		renderRange(fromY, limitY);
+		return;
+	}
+	pool.parallelFor(numJobs, [&](unsigned job) {
+		renderRange(fromY + int(numLines * job / numJobs),
+		            fromY + int(numLines * (job + 1) / numJobs));
+	});
+}
+
 template<typename Pixel>
 inline void SDLRasterizer<Pixel>::renderBitmapLine(Pixel* buf, unsigned vramLine)
 {
@@ -80,7 +129,19 @@ SDLRasterizer<Pixel>::SDLRasterizer(
 	, characterConverter(vdp, palFg, palBg)
 	, bitmapConverter(palFg, PALETTE256, V9958_COLORS)
 	, spriteConverter(vdp.getSpriteChecker())
+	, paletteVersion(0)
+	, nextRecentState(0)
+	, lastStateId(0)
+	, lineSignatures(NUM_SIGNATURES)
+	, lastLineTag(0)
 {
+	for (auto& recent : recentStates) {
+		memset(&recent.state, 0, sizeof(recent.state));
+		recent.id = ++lastStateId;
+	}
+	std::fill(std::begin(lineDrawn),  std::end(lineDrawn),  false);
+	std::fill(std::begin(lineReused), std::end(lineReused), false);
+
 	// Init the palette.
 	precalcPalette();
 
@@ -165,6 +226,9 @@ void SDLRasterizer<Pixel>::frameStart(EmuTime::param time)
 	// NTSC: display at [32..244),
 	// PAL:  display at [59..271).
 	lineRenderTop = vdp.isPalTiming() ? 59 - 14 : 32 - 14;
+
+	std::fill(std::begin(lineDrawn),  std::end(lineDrawn),  false);
+	std::fill(std::begin(lineReused), std::end(lineReused), false);
 }
 
 template<typename Pixel>
@@ -237,6 +301,7 @@ void SDLRasterizer<Pixel>::setTransparency(bool enabled)
 template<typename Pixel>
 void SDLRasterizer<Pixel>::precalcPalette()
 {
+	++paletteVersion;
 	if (vdp.isMSX1VDP()) {
 		// Fixed palette.
 		const auto palette = vdp.getMSX1Palette();
@@ -391,6 +456,33 @@ std::pair<Pixel, Pixel> SDLRasterizer<Pixel>::getBorderColors()
 	return {col, col};
 }
 
+template<typename Pixel>
+uint64_t SDLRasterizer<Pixel>::getStateId(const DisplayState& state)
+{
+	for (const auto& recent : recentStates) {
+		if (memcmp(&recent.state, &state, sizeof(state)) == 0) {
+			return recent.id;
+		}
+	}
+	auto& recent = recentStates[nextRecentState];
+	nextRecentState = (nextRecentState + 1) % std::size(recentStates);
+	memcpy(&recent.state, &state, sizeof(state));
+	recent.id = ++lastStateId;
+	return recent.id;
+}
+
+template<typename Pixel>
+bool SDLRasterizer<Pixel>::LineSignature::sameContent(
+	const LineSignature& other) const
+{
+	return (stateId     == other.stateId) &&
+	       (vramStamp   == other.vramStamp) &&
+	       (vramLine[0] == other.vramLine[0]) &&
+	       (vramLine[1] == other.vramLine[1]) &&
+	       (numSprites  == other.numSprites) &&
+	       std::equal(sprites, sprites + numSprites, other.sprites);
+}
+
 template<typename Pixel>
 void SDLRasterizer<Pixel>::drawBorder(
 	int fromX, int fromY, int limitX, int limitY)
@@ -413,10 +505,21 @@ void SDLRasterizer<Pixel>::drawBorder(
 		unsigned x = translateX(fromX, (lineWidth == 512));
 		unsigned num = translateX(limitX, (lineWidth == 512)) - x;
 		unsigned width = (lineWidth == 512) ? 640 : 320;
+		int minX = to640(x,       lineWidth == 512);
+		int maxX = to640(x + num, lineWidth == 512);
 		MemoryOps::MemSet2<Pixel> memset;
 		for (auto y : xrange(startY, endY)) {
 			memset(workFrame->getLinePtrDirect<Pixel>(y) + x,
 			       num, border0, border1);
+			if (uint64_t tag = workFrame->getLineTag(y)) {
+				// Overwriting (part of) the display area
+				// invalidates the tag of this line.
+				const auto& sig = lineSignatures[tag & (NUM_SIGNATURES - 1)];
+				if ((sig.tag != tag) ||
+				    ((minX < sig.maxX) && (sig.minX < maxX))) {
+					workFrame->setLineTag(y, 0);
+				}
+			}
 			if (limitX == VDP::TICKS_PER_LINE) {
 				// Only set line width at the end (right
 				// border) of the line. This ensures we can
@@ -490,8 +593,68 @@ void SDLRasterizer<Pixel>::drawDisplay(
 		pageBorder = pageSplit;
 	}
 
-	if (mode.isBitmapMode()) {
-		for (auto y : xrange(screenY, screenLimitY)) {
+	// Only render the lines of which the workFrame doesn't already contain
+	// the content we're about to render. Typically this skips most lines of
+	// a static screen. The workFrame was last used a few frames ago (see
+	// PostProcessor::rotateFrames()), the tag of each line refers to the
+	// signature it was rendered with.
+	DisplayState state;
+	memset(&state, 0, sizeof(state));
+	memcpy(state.palFg, palFg, sizeof(palFg));
+	memcpy(state.palBg, palBg, sizeof(palBg));
+	state.paletteVersion = paletteVersion;
+	state.mode = mode.getByte();
+	state.displayX = displayX;
+	state.displayWidth = displayWidth;
+	state.leftBackground = leftBackground;
+	state.leftSprites = vdp.getLeftSprites();
+	state.hScrollHigh = vdp.getHorizontalScrollHigh();
+	state.hScrollLow = vdp.getHorizontalScrollLow();
+	state.multiPage = vdp.isMultiPageScrolling();
+	state.verticalScroll = vdp.getVerticalScroll();
+	state.foreground = vdp.getForegroundColor();
+	state.background = vdp.getBackgroundColor();
+	state.blinkForeground = vdp.getBlinkForegroundColor();
+	state.blinkBackground = vdp.getBlinkBackgroundColor();
+	state.blinkState = vdp.getBlinkState();
+	auto getMask = [](const VRAMWindow& table) {
+		return table.isEnabled() ? table.getMask() : -1;
+	};
+	state.nameMask = getMask(vram.nameTable);
+	state.patternMask = getMask(vram.patternTable);
+	state.colorMask = getMask(vram.colorTable);
+	state.transparency = vdp.getTransparency();
+	state.sprites = vdp.spritesEnabled() && !renderSettings.getDisableSprites();
+	uint64_t stateId = getStateId(state);
+
+	// Character modes: any write to the tables invalidates all lines.
+	uint64_t tableStamp = mode.isBitmapMode() ? 0 : std::max({
+		vram.getWriteStamp(vram.nameTable),
+		vram.getWriteStamp(vram.patternTable),
+		vram.getWriteStamp(vram.colorTable)});
+	// Bitmap modes: only lines of which the VRAM was written.
+	auto getBitmapStamp = [&](int vramLine) {
+		if (mode.isPlanar()) {
+			auto [vramPtr0, vramPtr1] =
+				vram.bitmapCacheWindow.getReadAreaPlanar(vramLine * 256, 256);
+			return std::max(vram.getWriteStamp(vramPtr0, 128),
+			                vram.getWriteStamp(vramPtr1, 128));
+		} else {
+			return vram.getWriteStamp(
+				vram.bitmapCacheWindow.getReadArea(vramLine * 128, 128), 128);
+		}
+	};
+
+	auto& spriteChecker = vdp.getSpriteChecker();
+	int minX = to640(leftBackground + displayX, lineWidth == 512);
+	int maxX = to640(leftBackground + displayX + displayWidth, lineWidth == 512);
+	bool anyToRender = false;
+	for (auto y : xrange(screenY, screenLimitY)) {
+		int dispY = (y == screenY) ? displayY
+		                           : ((displayY + y - screenY) & 255);
+		LineSignature sig;
+		sig.stateId = stateId;
+		if (mode.isBitmapMode()) {
 			// Which bits in the name mask determine the page?
 			// TODO optimize this?
 			//   Calculating pageMaskOdd/Even is a non-trivial amount
@@ -504,10 +667,68 @@ void SDLRasterizer<Pixel>::drawDisplay(
 			int pageMaskEven = vdp.isMultiPageScrolling()
 				? (pageMaskOdd & ~0x100)
 				: pageMaskOdd;
-			const int vramLine[2] = {
-				(vram.nameTable.getMask() >> 7) & (pageMaskEven | displayY),
-				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | displayY)
-			};
+			int* vramLine = bitmapVramLines[y];
+			vramLine[0] = (vram.nameTable.getMask() >> 7) & (pageMaskEven | dispY);
+			vramLine[1] = (vram.nameTable.getMask() >> 7) & (pageMaskOdd  | dispY);
+			sig.vramLine[0] = vramLine[0];
+			sig.vramLine[1] = vramLine[1];
+			sig.vramStamp = std::max(getBitmapStamp(vramLine[0]),
+			                         getBitmapStamp(vramLine[1]));
+		} else {
+			sig.vramLine[0] = dispY;
+			sig.vramLine[1] = 0;
+			sig.vramStamp = tableStamp;
+		}
+
+		lineReused[y] = false;
+		if (lineDrawn[y]) {
+			// Second (partial) draw of this line in this frame,
+			// its content can no longer be described by a single
+			// signature.
+			workFrame->setLineTag(y, 0);
+			anyToRender = true;
+			continue;
+		}
+		lineDrawn[y] = true;
+
+		sig.numSprites = 0;
+		if (state.sprites) {
+			const SpriteChecker::SpriteInfo* visibleSprites;
+			int num = spriteChecker.getSprites(y + lineRenderTop, visibleSprites);
+			if (num > int(std::size(sig.sprites))) {
+				workFrame->setLineTag(y, 0);
+				anyToRender = true;
+				continue;
+			}
+			for (auto i : xrange(num)) {
+				const auto& info = visibleSprites[i];
+				sig.sprites[i] = uint64_t(info.pattern) |
+				                 (uint64_t(uint16_t(info.x)) << 32) |
+				                 (uint64_t(info.colorAttrib) << 48);
+			}
+			sig.numSprites = num;
+		}
+
+		uint64_t oldTag = workFrame->getLineTag(y);
+		const auto& old = lineSignatures[oldTag & (NUM_SIGNATURES - 1)];
+		if (oldTag && (old.tag == oldTag) && old.sameContent(sig)) {
+			lineReused[y] = true;
+			continue;
+		}
+		sig.tag = ++lastLineTag;
+		sig.minX = minX;
+		sig.maxX = maxX;
+		lineSignatures[sig.tag & (NUM_SIGNATURES - 1)] = sig;
+		workFrame->setLineTag(y, sig.tag);
+		anyToRender = true;
+	}
+	if (!anyToRender) return;
+
+	if (mode.isBitmapMode()) {
+		bitmapConverter.prepareConcurrentConvert();
+		renderLines(screenY, screenLimitY, displayY, [&](int y, int /*dispY*/) {
+			if (lineReused[y]) return;
+			const int* vramLine = bitmapVramLines[y];
 
 			Pixel buf[512];
 			int lineInBuf = -1; // buffer data not valid
@@ -538,27 +759,24 @@ void SDLRasterizer<Pixel>::drawDisplay(
 				       buf + x,
 				       (displayWidth - firstPageWidth) * sizeof(Pixel));
 			}
-
-			displayY = (displayY + 1) & 255;
-		}
+		});
 	} else {
 		// horizontal scroll (high) is implemented in CharacterConverter
-		for (auto y : xrange(screenY, screenLimitY)) {
-			assert(!vdp.isMSX1VDP() || displayY < 192);
+		renderLines(screenY, screenLimitY, displayY, [&](int y, int dispY) {
+			if (lineReused[y]) return;
+			assert(!vdp.isMSX1VDP() || dispY < 192);
 
 			Pixel* dst = workFrame->getLinePtrDirect<Pixel>(y)
 			           + leftBackground + displayX;
 			if ((displayX == 0) && (displayWidth == lineWidth)){
-				characterConverter.convertLine(dst, displayY);
+				characterConverter.convertLine(dst, dispY);
 			} else {
 				Pixel buf[512];
-				characterConverter.convertLine(buf, displayY);
+				characterConverter.convertLine(buf, dispY);
 				const Pixel* src = buf + displayX;
 				memcpy(dst, src, displayWidth * sizeof(Pixel));
 			}
-
-			displayY = (displayY + 1) & 255;
-		}
+		});
 	}
 }
 
@@ -588,11 +806,27 @@ void SDLRasterizer<Pixel>::drawSprites(
 	int spriteMode = vdp.getDisplayMode().getSpriteMode(vdp.isMSX1VDP());
 	int displayLimitX = displayX + displayWidth;
 	int limitY = fromY + displayHeight;
-	int screenX = translateX(
-		vdp.getLeftSprites(),
-		vdp.getDisplayMode().getLineWidth() == 512);
+	bool narrow = vdp.getDisplayMode().getLineWidth() == 512;
+	int screenX = translateX(vdp.getLeftSprites(), narrow);
+	// Lines that were reused by drawDisplay() already contain the sprites.
+	// For the other lines, the drawn range of their signature must include
+	// the sprites, see drawBorder().
+	int minX = to640(screenX, narrow) + 2 * displayX;
+	int maxX = to640(screenX, narrow) + 2 * displayLimitX;
+	auto skipLine = [&](int y) {
+		if (lineReused[y]) return true;
+		if (uint64_t tag = workFrame->getLineTag(y)) {
+			auto& sig = lineSignatures[tag & (NUM_SIGNATURES - 1)];
+			if (sig.tag == tag) {
+				sig.minX = std::min(sig.minX, minX);
+				sig.maxX = std::max(sig.maxX, maxX);
+			}
+		}
+		return false;
+	};
 	if (spriteMode == 1) {
 		for (int y = fromY; y < limitY; y++, screenY++) {
+			if (skipLine(screenY)) continue;
 			Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(screenY) + screenX;
 			spriteConverter.drawMode1(y, displayX, displayLimitX, pixelPtr);
 		}
@@ -600,18 +834,21 @@ void SDLRasterizer<Pixel>::drawSprites(
 		byte mode = vdp.getDisplayMode().getByte();
 		if (mode == DisplayMode::GRAPHIC5) {
 			for (int y = fromY; y < limitY; y++, screenY++) {
+				if (skipLine(screenY)) continue;
 				Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(screenY) + screenX;
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC5>(
 					y, displayX, displayLimitX, pixelPtr);
 			}
 		} else if (mode == DisplayMode::GRAPHIC6) {
 			for (int y = fromY; y < limitY; y++, screenY++) {
+				if (skipLine(screenY)) continue;
 				Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(screenY) + screenX;
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC6>(
 					y, displayX, displayLimitX, pixelPtr);
 			}
 		} else {
 			for (int y = fromY; y < limitY; y++, screenY++) {
+				if (skipLine(screenY)) continue;
 				Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(screenY) + screenX;
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC4>(
 					y, displayX, displayLimitX, pixelPtr);
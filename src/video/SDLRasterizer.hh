@@ -7,7 +7,9 @@
 #include "SpriteConverter.hh"
 #include "Observer.hh"
 #include "openmsx.hh"
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -84,6 +86,50 @@ private:
 	// Get the border color(s). These are 16bpp or 32bpp host pixels.
 	std::pair<Pixel, Pixel> getBorderColors();
 
+	/** All state, except for the VRAM content, that influences how a
+	  * display line is rendered. Compared with memcmp(), so all members
+	  * must be initialized (also the padding, if any).
+	  */
+	struct DisplayState {
+		Pixel palFg[16 * 2], palBg[16];
+		unsigned paletteVersion;
+		int mode; // DisplayMode::getByte()
+		int displayX, displayWidth; // as passed to drawDisplay()
+		int leftBackground, leftSprites;
+		int hScrollHigh, hScrollLow, multiPage, verticalScroll;
+		int foreground, background;
+		int blinkForeground, blinkBackground, blinkState;
+		int nameMask, patternMask, colorMask; // -1 if disabled
+		int transparency, sprites;
+	};
+
+	/** Returns an id for the given state. Equal states get the same id,
+	  * as long as that state was used recently. Otherwise a new id (never
+	  * used before) is returned.
+	  */
+	[[nodiscard]] uint64_t getStateId(const DisplayState& state);
+
+	/** Everything that determines the content of a rendered display
+	  * line, including the sprites drawn on top of it. See drawDisplay().
+	  */
+	struct LineSignature {
+		uint64_t tag; // the tag of the RawFrame line, 0 if unused
+		uint64_t stateId;
+		uint64_t vramStamp;
+		int vramLine[2]; // bitmap modes: the two pages, else: displayY
+		int minX, maxX; // drawn range, in 640-pixel wide coordinates
+		unsigned numSprites;
+		uint64_t sprites[32];
+
+		[[nodiscard]] bool sameContent(const LineSignature& other) const;
+	};
+
+	/** Number of remembered line signatures, must be a power of 2.
+	  * Large enough to hold all lines of all frames that the post
+	  * processor keeps around (up to 5 when deflicker is active).
+	  */
+	static constexpr unsigned NUM_SIGNATURES = 2048;
+
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
@@ -156,6 +202,40 @@ private:
 	/** Host colors corresponding to each possible V9958 color.
 	  */
 	Pixel V9958_COLORS[32768];
+
+	/** Incremented each time the colors above (and palGraphic7Sprites)
+	  * are recalculated.
+	  */
+	unsigned paletteVersion;
+
+	/** Recently used display states and their ids, see getStateId().
+	  */
+	struct RecentState {
+		DisplayState state;
+		uint64_t id;
+	};
+	RecentState recentStates[16];
+	unsigned nextRecentState;
+	uint64_t lastStateId;
+
+	/** The signatures of recently rendered display lines, indexed by
+	  * (the lower bits of) the tag of the line in its RawFrame. A line in
+	  * the workFrame that still has the signature that we're about to
+	  * render doesn't need to be rendered again.
+	  */
+	std::vector<LineSignature> lineSignatures;
+	uint64_t lastLineTag;
+
+	/** Per line of the workFrame: was the display part already drawn in
+	  * this frame and did that draw reuse the previous content.
+	  */
+	bool lineDrawn[240];
+	bool lineReused[240];
+
+	/** For bitmap modes: the VRAM lines for each line of the workFrame,
+	  * as calculated by drawDisplay().
+	  */
+	int bitmapVramLines[240][2];
 };
 
 } // namespace openmsx
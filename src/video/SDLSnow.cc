@@ -40,6 +40,7 @@ void SDLSnow<Pixel>::paint(OutputSurface& output_)
 			memcpy(p1, p0, width * sizeof(Pixel));
 		}
 	}
+	output.setFrameBufferOwner(nullptr);
 	output.flushFrameBuffer();
 
 	display.repaintDelayed(100 * 1000); // 10fps
@@ -218,11 +218,11 @@ void SDLVideoSystem::flush()
 	screen->finish();
 }
 
-void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
+std::future<void> SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
 {
 	if (withOsd) {
 		// we can directly save current content as screenshot
-		screen->saveScreenshot(filename);
+		return screen->saveScreenshot(filename);
 	} else {
 		// we first need to re-render to an off-screen surface
 		// with OSD layers disabled
@@ -230,7 +230,7 @@ void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
 		ScopedLayerHider hideOsd(*osdGuiLayer);
 		std::unique_ptr<OutputSurface> surf = screen->createOffScreenSurface();
 		display.repaintImpl(*surf);
-		surf->saveScreenshot(filename);
+		return surf->saveScreenshot(filename);
 	}
 }
 
@@ -41,7 +41,7 @@ public:
 #endif
 	[[nodiscard]] bool checkSettings() override;
 	void flush() override;
-	void takeScreenShot(const std::string& filename, bool withOsd) override;
+	[[nodiscard]] std::future<void> takeScreenShot(const std::string& filename, bool withOsd) override;
 	void updateWindowTitle() override;
 	[[nodiscard]] gl::ivec2 getMouseCoord() override;
 	[[nodiscard]] OutputSurface* getOutputSurface() override;
@@ -6,7 +6,6 @@
 #include "OSDGUILayer.hh"
 #include "MSXException.hh"
 #include "unreachable.hh"
-#include "vla.hh"
 #include "build-info.hh"
 #include <cstdint>
 #include <memory>
@@ -107,31 +106,28 @@ std::unique_ptr<OutputSurface> SDLVisibleSurface::createOffScreenSurface()
 	return std::make_unique<SDLOffScreenSurface>(*surface);
 }
 
-void SDLVisibleSurface::saveScreenshot(const std::string& filename)
+std::future<void> SDLVisibleSurface::saveScreenshot(const std::string& filename)
 {
-	saveScreenshotSDL(*this, filename);
+	return saveScreenshotSDL(*this, filename);
 }
 
-void SDLVisibleSurface::saveScreenshotSDL(
+std::future<void> SDLVisibleSurface::saveScreenshotSDL(
 	const SDLOutputSurface& output, const std::string& filename)
 {
 	auto [width, height] = output.getLogicalSize();
-	VLA(const void*, rowPointers, height);
 	MemBuffer<uint8_t> buffer(width * height * 3);
-	for (auto i : xrange(height)) {
-		rowPointers[i] = &buffer[width * 3 * i];
-	}
 	if (SDL_RenderReadPixels(
 			output.getSDLRenderer(), nullptr,
 			SDL_PIXELFORMAT_RGB24, buffer.data(), width * 3)) {
 		throw MSXException("Couldn't acquire screenshot pixels: ", SDL_GetError());
 	}
-	PNG::save(width, height, rowPointers, filename);
+	return PNG::saveAsync(width, height, std::move(buffer), filename);
 }
 
 void SDLVisibleSurface::clearScreen()
 {
 	SDL_FillRect(surface.get(), nullptr, 0);
+	setFrameBufferOwner(nullptr);
 }
 
 void SDLVisibleSurface::fullScreenUpdated(bool /*fullscreen*/)
@@ -16,11 +16,11 @@ public:
 	                  CliComm& cliComm,
 	                  VideoSystem& videoSystem);
 
-	static void saveScreenshotSDL(const SDLOutputSurface& output,
-	                              const std::string& filename);
+	[[nodiscard]] static std::future<void> saveScreenshotSDL(
+		const SDLOutputSurface& output, const std::string& filename);
 
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	[[nodiscard]] std::future<void> saveScreenshot(const std::string& filename) override;
 	void flushFrameBuffer() override;
 	void clearScreen() override;
 
@@ -108,6 +108,8 @@ static constexpr unsigned bufferSize(unsigned size)
 VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 	: vdp(vdp_)
 	, data(*vdp_.getDeviceConfig2().getXML(), bufferSize(size))
+	, writeStamps(data.getSize() >> STAMP_BLOCK_BITS)
+	, writeCounter(0)
 	, logicalVRAMDebug (vdp)
 	, physicalVRAMDebug(vdp, size)
 	#ifdef DEBUG
@@ -126,6 +128,10 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 {
 	(void)time;
 
+	// all writes go via writeCommon() or via the methods below
+	data.enableDirtyTracking();
+	markAllWritten();
+
 	vrMode = vdp.getVRMode();
 	setSizeMask(time);
 
@@ -146,6 +152,47 @@ void VDPVRAM::clear()
 		// give the same value.
 		memset(&data[actualSize], 0xFF, data.getSize() - actualSize);
 	}
+	markAllWritten();
+}
+
+void VDPVRAM::markAllWritten()
+{
+	++writeCounter;
+	std::fill_n(writeStamps.data(), data.getSize() >> STAMP_BLOCK_BITS,
+	            writeCounter);
+}
+
+uint64_t VDPVRAM::getWriteStamp(const byte* area, unsigned size) const
+{
+	assert(size != 0);
+	unsigned offset = area - &data[0];
+	assert((offset + size) <= data.getSize());
+	unsigned first = offset >> STAMP_BLOCK_BITS;
+	unsigned last = (offset + size - 1) >> STAMP_BLOCK_BITS;
+	return *std::max_element(&writeStamps[first], &writeStamps[last + 1]);
+}
+
+uint64_t VDPVRAM::getWriteStamp(const VRAMWindow& window) const
+{
+	if (!window.isEnabled()) return 0;
+
+	// The window contains all addresses 'baseAddr | x', with 'x' any
+	// combination of the bits in '~combiMask'. Visit each block that
+	// contains such an address.
+	constexpr unsigned BLOCK_MASK = ~0u << STAMP_BLOCK_BITS;
+	unsigned base = unsigned(window.baseAddr) & BLOCK_MASK;
+	unsigned freeBits = ~unsigned(window.combiMask) & BLOCK_MASK &
+	                    (Math::ceil2(data.getSize()) - 1);
+	uint64_t result = 0;
+	unsigned sub = 0;
+	do {
+		unsigned addr = base | sub;
+		if (addr < data.getSize()) {
+			result = std::max(result, writeStamps[addr >> STAMP_BLOCK_BITS]);
+		}
+		sub = (sub - freeBits) & freeBits; // next subset of 'freeBits'
+	} while (sub != 0);
+	return result;
 }
 
 void VDPVRAM::updateDisplayMode(DisplayMode mode, bool cmdBit, EmuTime::param time)
@@ -209,6 +256,8 @@ void VDPVRAM::updateVRMode(bool newVRmode, EmuTime::param time)
 	}
 	vrMode = newVRmode;
 	setSizeMask(time);
+	data.markAllDirty();
+	markAllWritten();
 
 	if (vrMode) {
 		// switch from VR=0 to VR=1
@@ -303,6 +352,8 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 		}
 	}
 	memcpy(&data[0], tmp, sizeof(tmp));
+	data.markDirty(0, sizeof(tmp));
+	markAllWritten();
 }
 
 
@@ -327,7 +378,10 @@ void VDPVRAM::serialize(Archive& ar, unsigned /*version*/)
 		setSizeMask(static_cast<MSXDevice&>(vdp).getCurrentTime());
 	}
 
-	ar.serialize_blob("data", &data[0], actualSize);
+	data.serializeBlob(ar, "data", actualSize);
+	if constexpr (Archive::IS_LOADER) {
+		markAllWritten();
+	}
 	ar.serialize("cmdReadWindow",       cmdReadWindow,
 	             "cmdWriteWindow",      cmdWriteWindow,
 	             "nameTable",           nameTable,
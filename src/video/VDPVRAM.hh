@@ -6,10 +6,12 @@
 #include "VDPCmdEngine.hh"
 #include "SimpleDebuggable.hh"
 #include "Ram.hh"
+#include "MemBuffer.hh"
 #include "Math.hh"
 #include "openmsx.hh"
 #include "likely.hh"
 #include <cassert>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -320,14 +322,15 @@ public:
 		}
 	}
 
-	template<typename Archive>
-	void serialize(Archive& ar, unsigned version);
-
-private:
+	/** Is this window enabled (see setMask() and disable()).
+	  */
 	[[nodiscard]] inline bool isEnabled() const {
 		return baseAddr != -1;
 	}
 
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
 private:
 	/** Only VDPVRAM may construct VRAMWindow objects.
 	  */
@@ -545,6 +548,22 @@ public:
 	  */
 	void change4k8kMapping(bool mapping8k);
 
+	/** Returns a stamp that changes each time (a part of) the given VRAM
+	  * area is written. Comparing this with an earlier returned stamp
+	  * (for the same area) tells whether the area changed in between.
+	  * Writes are tracked per block of 2^STAMP_BLOCK_BITS bytes, so a
+	  * changed stamp doesn't necessarily mean the area itself changed.
+	  * @param area Pointer to the area, as returned by
+	  *             VRAMWindow::getReadArea() or getReadAreaPlanar().
+	  * @param size Size of the area in bytes.
+	  */
+	[[nodiscard]] uint64_t getWriteStamp(const byte* area, unsigned size) const;
+
+	/** Similar to above, but for all addresses inside the given window.
+	  * For a disabled window this returns 0.
+	  */
+	[[nodiscard]] uint64_t getWriteStamp(const VRAMWindow& window) const;
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -569,7 +588,9 @@ private:
 		spriteAttribTable.notify(address, time);
 		spritePatternTable.notify(address, time);
 
+		data.markDirty(address);
 		data[address] = value;
+		writeStamps[address >> STAMP_BLOCK_BITS] = ++writeCounter;
 
 		// Cache dirty marking should happen after the commit,
 		// otherwise the cache could be re-validated based on old state.
@@ -599,6 +620,11 @@ private:
 
 	void setSizeMask(EmuTime::param time);
 
+	/** Give all blocks a new write stamp, e.g. after the whole content
+	  * of the VRAM was changed at once.
+	  */
+	void markAllWritten();
+
 private:
 	/** VDP this VRAM belongs to.
 	  */
@@ -608,6 +634,13 @@ private:
 	  */
 	Ram data;
 
+	/** For each block of VRAM, the value of 'writeCounter' at the last
+	  * write to that block. See getWriteStamp().
+	  */
+	static constexpr unsigned STAMP_BLOCK_BITS = 7;
+	MemBuffer<uint64_t> writeStamps;
+	uint64_t writeCounter;
+
 	/** Debuggable with mode dependend view on the vram
 	  *   Screen7/8 are not interleaved in this mode.
 	  *   This debuggable is also at least 128kB in size (it possibly
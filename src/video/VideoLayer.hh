@@ -5,6 +5,7 @@
 #include "Layer.hh"
 #include "Observer.hh"
 #include "MSXEventListener.hh"
+#include <future>
 #include <string>
 
 namespace openmsx {
@@ -30,8 +31,9 @@ public:
 
 	/** Create a raw (=non-postprocessed) screenshot. The 'height'
 	 * parameter should be either '240' or '480'. The current image will be
-	 * scaled to '320x240' or '640x480' and written to a png file. */
-	virtual void takeRawScreenShot(
+	 * scaled to '320x240' or '640x480' and written to a png file. The
+	 * encoding happens in the background, see PNG::saveAsync(). */
+	[[nodiscard]] virtual std::future<void> takeRawScreenShot(
 		unsigned height, const std::string& filename) = 0;
 
 	// We used to test whether a Layer is active by looking at the
@@ -8,7 +8,7 @@ bool VideoSystem::checkSettings()
 	return true;
 }
 
-void VideoSystem::takeScreenShot(
+std::future<void> VideoSystem::takeScreenShot(
 	const std::string& /*filename*/, bool /*withOsd*/)
 {
 	throw MSXException(
@@ -3,6 +3,7 @@
 
 #include "gl_vec.hh"
 #include "zstring_view.hh"
+#include <future>
 #include <string>
 #include <memory>
 #include "components.hh"
@@ -66,9 +67,11 @@ public:
 	  * The default implementation throws an exception.
 	  * @param filename Name of the file to save the screenshot to.
 	  * @param withOsd Should OSD elements be included in the screenshot.
+	  * @return Future that becomes ready once the file is completely
+	  *         written (or that holds the error if encoding failed).
 	  * @throws MSXException If taking the screen shot fails.
 	  */
-	virtual void takeScreenShot(const std::string& filename, bool withOsd);
+	[[nodiscard]] virtual std::future<void> takeScreenShot(const std::string& filename, bool withOsd);
 
 	/** Called when the window title string has changed.
 	  */
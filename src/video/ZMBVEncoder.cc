@@ -350,10 +350,25 @@ const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* wor
 	return nullptr; // avoid warning
 }
 
-span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame)
+void ZMBVEncoder::grabFrame(FrameSource* frame)
 {
 	std::swap(newframe, oldframe); // replace oldframe with newframe
 
+	// copy lines (to add black border)
+	unsigned linePitch = pitch * pixelSize;
+	unsigned lineWidth = width * pixelSize;
+	uint8_t* dest =
+		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	for (auto i : xrange(height)) {
+		const auto* scaled = getScaledLine(frame, i, dest);
+		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		dest += linePitch;
+	}
+	framePixelFormat = frame->getPixelFormat();
+}
+
+span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame)
+{
 	// Reset the work buffer
 	unsigned workUsed = 0;
 	unsigned writeDone = 1;
@@ -374,29 +389,18 @@ span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame
 		deflateReset(&zstream); // restart deflate
 	}
 
-	// copy lines (to add black border)
-	unsigned linePitch = pitch * pixelSize;
-	unsigned lineWidth = width * pixelSize;
-	uint8_t* dest =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (auto i : xrange(height)) {
-		const auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
-	}
-
 	// Add the frame data.
 	if (keyFrame) {
 		// Key frame: full frame data.
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(framePixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(framePixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -407,12 +411,12 @@ span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(framePixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(framePixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -22,7 +22,13 @@ public:
 
 	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
 
-	[[nodiscard]] span<const uint8_t> compressFrame(bool keyFrame, FrameSource* frame);
+	/** Copy the content of the given frame into the encoder. This must be
+	  * called from the thread that owns 'frame'. */
+	void grabFrame(FrameSource* frame);
+
+	/** Encode the last grabbed frame. This doesn't access the original
+	  * FrameSource anymore, so it can run on a different thread. */
+	[[nodiscard]] span<const uint8_t> compressFrame(bool keyFrame);
 
 private:
 	enum Format {
@@ -50,6 +56,7 @@ private:
 	unsigned outputSize;
 
 	z_stream zstream;
+	PixelFormat framePixelFormat; // of the last grabbed frame
 
 	const unsigned width;
 	const unsigned height;
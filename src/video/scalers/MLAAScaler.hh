@@ -25,6 +25,9 @@ public:
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
 
+	/** Edges are followed over the full height of the image. */
+	[[nodiscard]] unsigned getVerticalRadius() const override { return unsigned(-1); }
+
 private:
 	const PixelOperations<Pixel> pixelOps;
 	const unsigned dstWidth;
@@ -400,7 +400,8 @@ void SaI3xScaler<Pixel>::scaleFixed(FrameSource& src,
 	auto* src1 = src.getLinePtr(srcY + 0, srcWidth, buf1);
 	auto* src2 = src.getLinePtr(srcY + 1, srcWidth, buf2);
 
-	for (auto dstY : xrange(dstStartY, dstEndY)) {
+	// scaleFixedLine() advances dstY by NY lines
+	for (unsigned dstY = dstStartY; dstY < dstEndY; srcY += 1) {
 		auto* src3 = src.getLinePtr(srcY + 2, srcWidth, buf3);
 		LineRepeater<NY>::template scaleFixedLine<NX, NY, Pixel>(
 			src0, src1, src2, src3, srcWidth, dst, dstY);
@@ -30,6 +30,12 @@ public:
 	virtual void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) = 0;
+
+	/** The output for a source line depends on at most this many source
+	  * lines above and below it. Used to only rescale the lines around a
+	  * changed source line.
+	  */
+	[[nodiscard]] virtual unsigned getVerticalRadius() const { return 2; }
 };
 
 } // namespace openmsx
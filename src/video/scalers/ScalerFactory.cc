@@ -13,17 +13,23 @@
 #include "RGBTriplet3xScaler.hh"
 #include "MLAAScaler.hh"
 #include "Scaler1.hh"
+#include "SlicedScaler.hh"
+#include "ThreadPool.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 using std::unique_ptr;
 
 namespace openmsx {
 
+static constexpr unsigned MAX_SCALER_BANDS = 8;
+
 template<typename Pixel>
-unique_ptr<Scaler<Pixel>> ScalerFactory<Pixel>::createScaler(
+static unique_ptr<Scaler<Pixel>> createSingleScaler(
 	const PixelOperations<Pixel>& pixelOps, RenderSettings& renderSettings)
 {
 	switch (renderSettings.getScaleFactor()) {
@@ -86,6 +92,28 @@ unique_ptr<Scaler<Pixel>> ScalerFactory<Pixel>::createScaler(
 	return nullptr; // avoid warning
 }
 
+template<typename Pixel>
+unique_ptr<Scaler<Pixel>> ScalerFactory<Pixel>::createScaler(
+	const PixelOperations<Pixel>& pixelOps, RenderSettings& renderSettings)
+{
+	auto scaler = createSingleScaler(pixelOps, renderSettings);
+
+	// Use all workers of the thread pool plus the calling thread, but
+	// beyond a few bands memory bandwidth is the limit anyway. Scalers
+	// that need the whole image (MLAA) can't be split in bands.
+	unsigned numBands = std::min(ThreadPool::instance().getNumThreads() + 1,
+	                             MAX_SCALER_BANDS);
+	if ((numBands <= 1) || (scaler->getVerticalRadius() == unsigned(-1))) {
+		return scaler;
+	}
+	std::vector<unique_ptr<Scaler<Pixel>>> scalers;
+	scalers.push_back(std::move(scaler));
+	while (scalers.size() < numBands) {
+		scalers.push_back(createSingleScaler(pixelOps, renderSettings));
+	}
+	return std::make_unique<SlicedScaler<Pixel>>(std::move(scalers));
+}
+
 // Force template instantiation.
 #if HAVE_16BPP
 template class ScalerFactory<uint16_t>;
@@ -17,6 +17,8 @@ class ScalerFactory
 {
 public:
 	/** Instantiates a Scaler.
+	  * On multi-core hosts the returned scaler splits the image in bands
+	  * that are scaled in parallel, see SlicedScaler.
 	  * @return A Scaler object, owned by the caller.
 	  */
 	[[nodiscard]] static std::unique_ptr<Scaler<Pixel>> createScaler(
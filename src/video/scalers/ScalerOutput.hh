@@ -3,6 +3,11 @@
 
 namespace openmsx {
 
+/** Destination of a Scaler. The scaler acquires an output line, writes the
+  * scaled pixels in it and then releases it again.
+  * Different lines may be acquired/released/filled concurrently from
+  * different threads (see SlicedScaler).
+  */
 template<typename Pixel> class ScalerOutput
 {
 public:
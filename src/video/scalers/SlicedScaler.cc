@@ -0,0 +1,68 @@
+#include "SlicedScaler.hh"
+#include "FrameSource.hh"
+#include "ScalerOutput.hh"
+#include "ThreadPool.hh"
+#include "build-info.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+
+namespace openmsx {
+
+template<typename Pixel>
+SlicedScaler<Pixel>::SlicedScaler(
+		std::vector<std::unique_ptr<Scaler<Pixel>>> scalers_)
+	: scalers(std::move(scalers_))
+{
+	assert(scalers.size() >= 2);
+}
+
+template<typename Pixel>
+void SlicedScaler<Pixel>::scaleImage(FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY)
+{
+	// The band boundaries must map to whole output lines, e.g. for 3x
+	// scaling of an interlaced frame 2 source lines become 3 output lines.
+	unsigned srcHeight = src.getHeight();
+	unsigned dstHeight = dst.getHeight();
+	unsigned g = std::gcd(srcHeight, dstHeight);
+	unsigned srcStep = srcHeight / g;
+	unsigned dstStep = dstHeight / g;
+	unsigned numSteps = (srcEndY - srcStartY) / srcStep;
+	unsigned numBands = std::min(unsigned(scalers.size()),
+	                             (srcEndY - srcStartY) / MIN_BAND_LINES);
+	if ((numBands <= 1) ||
+	    ((numSteps * srcStep) != (srcEndY - srcStartY)) ||
+	    ((numSteps * dstStep) != (dstEndY - dstStartY))) {
+		scalers[0]->scaleImage(src, superImpose,
+		                       srcStartY, srcEndY, srcWidth,
+		                       dst, dstStartY, dstEndY);
+		return;
+	}
+
+	ThreadPool::instance().parallelFor(numBands, [&](unsigned band) {
+		unsigned begin = (numSteps * (band + 0)) / numBands;
+		unsigned end   = (numSteps * (band + 1)) / numBands;
+		scalers[band]->scaleImage(src, superImpose,
+			srcStartY + begin * srcStep, srcStartY + end * srcStep, srcWidth,
+			dst, dstStartY + begin * dstStep, dstStartY + end * dstStep);
+	});
+}
+
+template<typename Pixel>
+unsigned SlicedScaler<Pixel>::getVerticalRadius() const
+{
+	return scalers[0]->getVerticalRadius();
+}
+
+// Force template instantiation.
+#if HAVE_16BPP
+template class SlicedScaler<uint16_t>;
+#endif
+#if HAVE_32BPP
+template class SlicedScaler<uint32_t>;
+#endif
+
+} // namespace openmsx
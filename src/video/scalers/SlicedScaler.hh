@@ -0,0 +1,46 @@
+#ifndef SLICEDSCALER_HH
+#define SLICEDSCALER_HH
+
+#include "Scaler.hh"
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+/** Scaler that splits the to-be-scaled area in horizontal bands and scales
+  * those in parallel (on the ThreadPool).
+  *
+  * Each band uses its own instance of the actual scaler: scalers are not
+  * thread-safe, e.g. some of them keep lookup tables that are (re)calculated
+  * when a setting changes. The bands don't overlap in the output, but the
+  * scalers also read the source lines around their band (at most
+  * getVerticalRadius() lines), so the result is identical to scaling the
+  * whole area at once.
+  */
+template<typename Pixel>
+class SlicedScaler final : public Scaler<Pixel>
+{
+public:
+	/** Don't split in bands smaller than this (number of source lines),
+	  * for small areas the synchronization costs more than it gains.
+	  */
+	static constexpr unsigned MIN_BAND_LINES = 16;
+
+	/** @param scalers One instance of the same scaler per band, there
+	  *                must be at least two.
+	  */
+	explicit SlicedScaler(std::vector<std::unique_ptr<Scaler<Pixel>>> scalers);
+
+	void scaleImage(FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
+
+	[[nodiscard]] unsigned getVerticalRadius() const override;
+
+private:
+	std::vector<std::unique_ptr<Scaler<Pixel>>> scalers;
+};
+
+} // namespace openmsx
+
+#endif
@@ -122,13 +122,13 @@ void Video9000::paint(OutputSurface& output)
 	activeLayer->paint(output);
 }
 
-void Video9000::takeRawScreenShot(unsigned height, const std::string& filename)
+std::future<void> Video9000::takeRawScreenShot(unsigned height, const std::string& filename)
 {
 	auto* layer = dynamic_cast<VideoLayer*>(activeLayer);
 	if (!layer) {
 		throw CommandException("TODO");
 	}
-	layer->takeRawScreenShot(height, filename);
+	return layer->takeRawScreenShot(height, filename);
 }
 
 int Video9000::signalEvent(const Event& event) noexcept
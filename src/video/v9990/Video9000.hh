@@ -39,7 +39,7 @@ private:
 
 	// VideoLayer
 	void paint(OutputSurface& output) override;
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	[[nodiscard]] std::future<void> takeRawScreenShot(unsigned height, const std::string& filename) override;
 
 	// EventListener
 	int signalEvent(const Event& event) noexcept override;